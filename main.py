@@ -1,3 +1,5 @@
+import os
+import json
 import queue
 import sys
 import time
@@ -14,11 +16,13 @@ except ImportError:
 import speech_recognition as sr
 from difflib import SequenceMatcher
 
+import phrase_manifest
+import phrase_match
+
 # For Vosk offline
 try:
     from vosk import Model, KaldiRecognizer
     import sounddevice as sd
-    import json
     VOSK_AVAILABLE = True
 except Exception:
     VOSK_AVAILABLE = False
@@ -375,6 +379,29 @@ MODE = "auto"  # "google" = online, "vosk" = offline, "auto" = try google then v
 # Matching sensitivity [0.0 - 1.0]. Higher => stricter match
 MATCH_THRESHOLD = 0.70
 
+# Framed event link from the ESP32 (decoded by pi/wake_link; build with
+# `cmake -S pi -B build-pi && cmake --build build-pi`). Without it main.py polls TRIGGER_PIN.
+LINK_DEVICE = "/dev/serial0"
+LINK_DECODER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "build-pi", "wake_link")
+# The firmware sends a hello frame every second while idle; a link silent for
+# this long is reported dead (TX not wired, or CONFIG_WAKE_LINK=n).
+LINK_DEAD_S = 3.5
+# Shut the Pi down after this many seconds of silence reported by the ESP32
+# (0 = off). Use this instead of shutdown.py while main.py holds the link:
+# a serial port has one reader.
+SHUTDOWN_AFTER_SILENCE_S = 0
+
+# ESP32 MultiNet command_id -> phrase, from phrase_manifest.csv (the list the
+# firmware's command table is built from). Commands the ESP accepted are
+# counted directly instead of being recognized again on the Pi.
+try:
+    ESP_PHRASE_MANIFEST = phrase_manifest.load()
+    ESP_COMMAND_PHRASES = ESP_PHRASE_MANIFEST.phrases()
+except (OSError, phrase_manifest.ManifestError) as e:
+    print("Phrase manifest not loaded, ESP32 commands are not counted:", e)
+    ESP_PHRASE_MANIFEST = None
+    ESP_COMMAND_PHRASES = {}
+
 # Audio chunk / phrase capture settings
 PHRASE_TIME_LIMIT = 4.0  # seconds to listen per attempt
 CALIBRATION_DURATION = 2.0  # seconds to adjust ambient noise
@@ -383,8 +410,14 @@ CALIBRATION_DURATION = 2.0  # seconds to adjust ambient noise
 MIC_DEVICE_INDEX = None  # e.g., 2 for a USB mic (see list below)
 # ----------------------------------------
 
+# Every phrase a transcript contains, in one pass (build-pi/libphrase_match.so); None
+# until it is built, and then only best_match() runs
+PHRASE_MATCHER = phrase_match.load(PHRASES)
+# Vosk partial hypotheses needed unchanged before a phrase in them is reported
+STABLE_PARTIALS = 2
+
 # Internal state
-detection_counts = {p: 0 for p in PHRASES}
+detection_counts = {p: 0 for p in PHRASES + list(ESP_COMMAND_PHRASES.values())}
 detection_lock = threading.Lock()
 
 
@@ -425,6 +458,37 @@ def best_match(recognized: str, phrases, threshold=MATCH_THRESHOLD):
     return best, best_score
 
 
+# best_match()'s accept/reject and score from the same library, ruling out most phrases
+# before scoring them; below MATCH_THRESHOLD its best phrase is None
+FUZZY_MATCHER = phrase_match.load_fuzzy(PHRASES, normalize_text)
+
+
+def match_transcript(text):
+    """Count every phrase the transcript contains; without one, its best fuzzy match if close enough."""
+    found = PHRASE_MATCHER.phrases_in(text) if PHRASE_MATCHER else []
+    for phrase in found:
+        print(f"Match: \"{phrase}\"")
+        handle_detection(phrase)
+    if not found:
+        match_fuzzy(text)
+
+
+def match_fuzzy(text):
+    """Count the transcript's best fuzzy match if close enough."""
+    if FUZZY_MATCHER:
+        best, score = FUZZY_MATCHER.best(text, MATCH_THRESHOLD)
+    else:
+        best, score = best_match(text, PHRASES)
+    if score >= MATCH_THRESHOLD:
+        print(f"Match: \"{best}\" (score={score:.2f})")
+        handle_detection(best)
+    elif best is None:
+        # the native matcher prunes phrases that cannot reach the threshold, so it names none
+        print(f"No match (no phrase reached {MATCH_THRESHOLD:.2f})")
+    else:
+        print(f"No match (best='{best}', score={score:.2f})")
+
+
 def handle_detection(phrase):
     """
     Print FIRST/SECOND detection messages and update counters thread-safely.
@@ -455,6 +519,89 @@ def handle_detection(phrase):
         print(f"\nDetected \"{phrase}\" ({count} times)")
 
 
+# ---------------- ESP32 event link ----------------
+def open_link():
+    """Start pi/wake_link on LINK_DEVICE; None if the decoder or the port is missing."""
+    if not (os.path.exists(LINK_DECODER) and os.path.exists(LINK_DEVICE)):
+        return None
+    try:
+        argv = [LINK_DECODER]
+        if SHUTDOWN_AFTER_SILENCE_S > 0:
+            argv += ["--shutdown-after", str(int(SHUTDOWN_AFTER_SILENCE_S))]
+        return subprocess.Popen(argv + [LINK_DEVICE], stdout=subprocess.PIPE, text=True, bufsize=1)
+    except OSError as e:
+        print("Event link not started:", e)
+        return None
+
+
+def link_events(link):
+    """Yield decoded link frames as dicts until the decoder exits."""
+    for line in link.stdout:
+        try:
+            yield json.loads(line)
+        except ValueError:
+            continue
+
+
+def read_link(link):
+    """Queue of decoded link frames, fed by a background reader; None marks the decoder's exit."""
+    events = queue.Queue()
+
+    def reader():
+        for ev in link_events(link):
+            events.put(ev)
+        events.put(None)
+
+    threading.Thread(target=reader, daemon=True).start()
+    return events
+
+
+def wait_for_wake(events):
+    """Block until the ESP32 reports a wake word: a wake frame on the link or TRIGGER_PIN high,
+    whichever comes first, so a link that never sends frames cannot hold up the wake."""
+    last_frame = time.monotonic()
+    dead = False
+    while GPIO.input(TRIGGER_PIN) == GPIO.LOW:
+        if not events:
+            time.sleep(0.1)
+            continue
+        try:
+            ev = events.get(timeout=0.1)
+        except queue.Empty:
+            if not dead and time.monotonic() - last_frame > LINK_DEAD_S:
+                print("No frames on the event link, waiting on TRIGGER_PIN")
+                dead = True
+            continue
+        if ev is None:
+            print("Event link closed, polling TRIGGER_PIN instead")
+            events.put(None)  # follow_link() sees the end too
+            events = None
+            continue
+        last_frame = time.monotonic()
+        if dead:
+            print("Event link is up")
+            dead = False
+        if ev.get("type") == "wake":
+            return
+
+
+def follow_link(events):
+    """Background: count commands the ESP32 already recognized, from the rest of the link stream."""
+    warned = False
+    for ev in iter(events.get, None):
+        if ev.get("type") == "hello" and ESP_PHRASE_MANIFEST and not warned:
+            if (ev.get("phrase_table") or ESP_PHRASE_MANIFEST.hash) != ESP_PHRASE_MANIFEST.hash:
+                print("ESP32 firmware was built from a different phrase_manifest.csv; command ids may not match")
+                warned = True
+        if ev.get("type") != "command" or not ev.get("accepted"):
+            continue
+        phrase = ESP_COMMAND_PHRASES.get(ev.get("command_id"))
+        if phrase:
+            print(f"ESP32 command {ev['command_id']}: \"{phrase}\" ({ev.get('category', 'unknown')}, "
+                  f"{ev.get('severity', 'none')} severity, prob={ev.get('prob', 0):.2f})")
+            handle_detection(phrase)
+
+
 # ---------------- Online (Google) backend using SpeechRecognition ----------------
 def run_google_backend():
     r = sr.Recognizer()
@@ -477,12 +624,7 @@ def run_google_backend():
         try:
             text = r.recognize_google(audio)
             print("Recognized (google):", text)
-            best, score = best_match(text, PHRASES)
-            if score >= MATCH_THRESHOLD:
-                print(f"Match: \"{best}\" (score={score:.2f})")
-                handle_detection(best)
-            else:
-                print(f"No match (best='{best}', score={score:.2f})")
+            match_transcript(text)
         except sr.UnknownValueError:
             print("Could not understand audio (online).")
         except sr.RequestError as e:
@@ -515,6 +657,27 @@ def run_vosk_backend():
     rec = KaldiRecognizer(model, samplerate)
     rec.SetWords(True)
 
+    # Phrases are reported from partial results while the caller is still talking
+    stream = PHRASE_MATCHER.stream(STABLE_PARTIALS) if PHRASE_MATCHER else None
+    heard = set()  # phrases already reported in this utterance
+
+    def hypothesis(text, final=False):
+        """Count phrases that settled in a partial or final result; fuzzy-match a final one without any."""
+        if not stream:
+            if final and text:
+                match_transcript(text)
+            return
+        for m in stream.update(text, final):
+            if m.phrase not in heard:
+                heard.add(m.phrase)
+                print(f"Match: \"{m.phrase}\"" + ("" if final else " (partial)"))
+                handle_detection(m.phrase)
+        if final:
+            if text and not heard:
+                match_fuzzy(text)
+            stream.reset()
+            heard.clear()
+
     print(f"Vosk model loaded. Listening (samplerate={samplerate})...")
     # We'll stream small chunks and aggregate recognized text per phrase_time_limit
     q = queue.Queue()
@@ -543,17 +706,11 @@ def run_vosk_backend():
                         text = j.get("text", "")
                         if text:
                             print("Recognized (vosk):", text)
-                            best, score = best_match(text, PHRASES)
-                            if score >= MATCH_THRESHOLD:
-                                print(f"Match: \"{best}\" (score={score:.2f})")
-                                handle_detection(best)
-                            else:
-                                print(f"No match (best='{best}', score={score:.2f})")
                             # reset buffer
                             buffer = b""
+                        hypothesis(text, final=True)
                     else:
-                        # partial result: may ignore or print
-                        pass
+                        hypothesis(json.loads(rec.PartialResult()).get("partial", ""))
                 except queue.Empty:
                     # time slice done; flush partial
                     # final_result = rec.FinalResult()
@@ -562,12 +719,7 @@ def run_vosk_backend():
                     text = j.get("text", "")
                     if text:
                         print("Recognized (vosk final):", text)
-                        best, score = best_match(text, PHRASES)
-                        if score >= MATCH_THRESHOLD:
-                            print(f"Match: \"{best}\" (score={score:.2f})")
-                            handle_detection(best)
-                        else:
-                            print(f"No match (best='{best}', score={score:.2f})")
+                    hypothesis(text, final=True)
                     # reset recognizer state
                     rec = KaldiRecognizer(model, samplerate)
                     rec.SetWords(True)
@@ -587,12 +739,15 @@ def main():
     GPIO.setup(LED_PIN, GPIO.OUT)
     GPIO.setup(VIBRATION_PIN, GPIO.OUT)
     GPIO.setup(TRIGGER_PIN, GPIO.IN, pull_up_down=GPIO.PUD_DOWN)
-    # Wait for GPIO trigger to activate silence monitoring
+    # Wait for the ESP32's wake word: a link wake frame or the GPIO trigger, whichever comes first
+    link = open_link()
+    events = read_link(link) if link else None
     if GPIO:
-        print("Waiting for GPIO trigger to activate silence monitoring...")
-        while GPIO.input(TRIGGER_PIN) == GPIO.LOW:
-            time.sleep(0.1)
-        print("GPIO trigger received. Starting silence monitoring...")
+        print("Waiting for ESP32 wake (%s)..." % ("event link " + LINK_DEVICE + " or GPIO trigger" if link else "GPIO trigger"))
+        wait_for_wake(events)
+        print("Wake received. Starting phrase detection...")
+    if events:
+        threading.Thread(target=follow_link, args=(events,), daemon=True).start()
 
     print("Fraudulent Phrase Detector")
     print("=========================")
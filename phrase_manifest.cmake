@@ -0,0 +1,15 @@
+# phrase_manifest.cmake - generates phrase_table.h from phrase_manifest.csv when the build configures.
+# Included by wake/main (firmware), wake/host and pi; editing the manifest or the generator reconfigures.
+set(PHRASE_MANIFEST ${CMAKE_CURRENT_LIST_DIR}/phrase_manifest.csv)
+set(PHRASE_MANIFEST_PY ${CMAKE_CURRENT_LIST_DIR}/phrase_manifest.py)
+
+#   phrase_manifest_generate(<python> <header path> [--image <bin path> --image-size <bytes>])
+function(phrase_manifest_generate python header)
+    execute_process(
+        COMMAND ${python} ${PHRASE_MANIFEST_PY} --manifest ${PHRASE_MANIFEST} --header ${header} ${ARGN}
+        RESULT_VARIABLE rc)
+    if(NOT rc EQUAL 0)
+        message(FATAL_ERROR "phrase_manifest.py failed on ${PHRASE_MANIFEST}")
+    endif()
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${PHRASE_MANIFEST} ${PHRASE_MANIFEST_PY})
+endfunction()
@@ -0,0 +1,229 @@
+"""phrase_manifest.py - reads phrase_manifest.csv and generates what the ESP32 and the Pi build from it.
+
+    python3 phrase_manifest.py [--manifest CSV] [--header OUT.h] [--image OUT.bin [--image-size N]]
+
+--header writes phrase_table.h: a constexpr table indexed by command_id with
+the LED mask, severity and category of each command packed into 16 bits,
+plus PHRASE_TABLE_HASH so the two ends can tell whether they were built from
+the same manifest. --image writes a "commands" partition image holding every
+phrase (format: wake/main/cmd_table.h). Without an output it prints the table.
+main.py imports load() for ESP_COMMAND_PHRASES.
+"""
+import argparse
+import csv
+import os
+import re
+import struct
+import sys
+import zlib
+
+DEFAULT_MANIFEST = os.path.join(os.path.dirname(os.path.abspath(__file__)), "phrase_manifest.csv")
+
+SEVERITIES = ["none", "low", "medium", "high"]  # index 0 is for ids outside the manifest
+ACTIONS = {"none": 0, "led0": 1, "led1": 2, "led2": 4, "all": 7}
+LED_BITS = 3
+SEVERITY_SHIFT = 3
+CATEGORY_SHIFT = 5
+CATEGORY_MAX = 31  # categories after "unknown" that fit the 5 category bits
+PHRASE_MAX = 63  # CMD_TABLE_PHRASE_MAX
+
+# cmd_table.h
+CMD_TABLE_MAGIC = 0x31444D43
+CMD_TABLE_FORMAT = 1
+CMD_SEG_BASE = 1
+CMD_OP_ADD = 1
+CMD_TABLE_SECTOR = 4096
+
+
+class ManifestError(Exception):
+    pass
+
+
+class Manifest:
+    def __init__(self, version, rows):
+        self.version = version
+        self.rows = rows  # (command_id, phrase, category, severity, action) in file order
+        self.categories = ["unknown"]
+        self.commands = {}  # command_id -> (category, severity, action)
+        for cid, _, category, severity, action in rows:
+            if category not in self.categories:
+                self.categories.append(category)
+            self.commands.setdefault(cid, (category, severity, action))
+        normalized = "".join(",".join(str(f) for f in r) + "\n" for r in rows)
+        self.hash = zlib.crc32(normalized.encode())
+
+    def phrases(self):
+        """command_id -> its first phrase"""
+        out = {}
+        for cid, phrase, *_ in self.rows:
+            out.setdefault(cid, phrase)
+        return out
+
+    def entry(self, cid):
+        category, severity, action = self.commands[cid]
+        return (ACTIONS[action] | SEVERITIES.index(severity) << SEVERITY_SHIFT |
+                self.categories.index(category) << CATEGORY_SHIFT)
+
+
+def load(path=DEFAULT_MANIFEST):
+    """Parse and check the manifest; raises ManifestError naming the line."""
+    version = None
+    rows = []
+    seen = {}
+    with open(path, newline="") as f:
+        lines = list(enumerate(f, 1))
+    data = []
+    for lineno, line in lines:
+        m = re.match(r"#\s*version:\s*(\d+)", line)
+        if m:
+            version = int(m.group(1))
+        elif line.strip() and not line.startswith("#"):
+            data.append((lineno, line))
+    reader = csv.reader(line for _, line in data)
+    header = next(reader, None)
+    if header != ["command_id", "phrase", "category", "severity", "action"]:
+        raise ManifestError(f"{path}: expected the header command_id,phrase,category,severity,action")
+    for (lineno, _), fields in zip(data[1:], reader):
+        where = f"{path}:{lineno}"
+        if len(fields) != 5:
+            raise ManifestError(f"{where}: expected 5 fields")
+        cid, phrase, category, severity, action = (s.strip() for s in fields)
+        if not cid.isdigit() or int(cid) > 32767:
+            raise ManifestError(f"{where}: command_id must be 0..32767")
+        cid = int(cid)
+        if not re.fullmatch(r"[a-z]+( [a-z]+)*", phrase) or len(phrase) > PHRASE_MAX:
+            raise ManifestError(f"{where}: phrase must be lowercase words, at most {PHRASE_MAX} characters")
+        if not re.fullmatch(r"[a-z_]+", category):
+            raise ManifestError(f"{where}: category must be a lowercase name")
+        if severity not in SEVERITIES[1:]:
+            raise ManifestError(f"{where}: severity must be one of {', '.join(SEVERITIES[1:])}")
+        if action not in ACTIONS:
+            raise ManifestError(f"{where}: action must be one of {', '.join(ACTIONS)}")
+        if phrase in seen:
+            raise ManifestError(f"{where}: \"{phrase}\" already on line {seen[phrase]}")
+        seen[phrase] = lineno
+        for other in rows:
+            if other[0] == cid and other[2:] != (category, severity, action):
+                raise ManifestError(f"{where}: synonyms of command {cid} differ in category, severity or action")
+        rows.append((cid, phrase, category, severity, action))
+    if version is None:
+        raise ManifestError(f"{path}: missing a \"# version: N\" line")
+    m = Manifest(version, rows)
+    if sorted(m.commands) != list(range(len(m.commands))):
+        raise ManifestError(f"{path}: command ids must be dense from 0 (the table is indexed by them)")
+    if len(m.categories) - 1 > CATEGORY_MAX:
+        raise ManifestError(f"{path}: more than {CATEGORY_MAX} categories")
+    return m
+
+
+def c_header(m, manifest_name):
+    n = len(m.commands)
+    entries = [m.entry(cid) for cid in range(n)] + [0]
+    body = ",\n".join(
+        "    " + ", ".join(f"0x{e:04x}" for e in entries[i:i + 8]) for i in range(0, len(entries), 8))
+    categories = ", ".join(f'"{c}"' for c in m.categories)
+    severities = ", ".join(f'"{s}"' for s in SEVERITIES)
+    return f"""/* phrase_table.h - generated by phrase_manifest.py from {manifest_name}; do not edit
+ *
+ * phrase_table[command_id] packs what a recognized command does:
+ *   bits 0-2 LEDs to light, bits 3-4 severity, bits 5-9 category
+ * The extra entry at PHRASE_TABLE_SIZE is all zeros (no LEDs, severity and
+ * category 0) and is what phrase_entry() returns for ids outside the manifest.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define PHRASE_TABLE_VERSION {m.version}
+#define PHRASE_TABLE_HASH 0x{m.hash:08x}u // CRC-32 of the manifest rows; sent in the link's hello frame
+#define PHRASE_TABLE_SIZE {n}
+
+#define PHRASE_LED_BITS {LED_BITS}
+#define PHRASE_SEVERITY_SHIFT {SEVERITY_SHIFT}
+#define PHRASE_CATEGORY_SHIFT {CATEGORY_SHIFT}
+
+static constexpr uint16_t phrase_table[PHRASE_TABLE_SIZE + 1] = {{
+{body}}};
+
+static constexpr const char *phrase_category_names[] = {{{categories}}};
+static constexpr const char *phrase_severity_names[] = {{{severities}}};
+#define PHRASE_CATEGORY_COUNT {len(m.categories)}
+
+/* clamps instead of branching: out-of-range ids (negative ones too) land on the zero entry */
+static inline uint16_t phrase_entry(int command_id)
+{{
+    unsigned i = (unsigned)command_id;
+    return phrase_table[i < PHRASE_TABLE_SIZE ? i : PHRASE_TABLE_SIZE];
+}}
+
+static inline unsigned phrase_leds(uint16_t e)
+{{
+    return e & ((1u << PHRASE_LED_BITS) - 1);
+}}
+
+static inline unsigned phrase_severity(uint16_t e)
+{{
+    return (e >> PHRASE_SEVERITY_SHIFT) & 3u;
+}}
+
+static inline unsigned phrase_category(uint16_t e)
+{{
+    return (e >> PHRASE_CATEGORY_SHIFT) & 31u;
+}}
+"""
+
+
+def partition_image(m, size):
+    """One base segment with every phrase in the first slot, padded with 0xFF (erased flash) to size."""
+    body = b""
+    for cid, phrase, *_ in m.rows:
+        p = phrase.encode()
+        body += struct.pack("<BBh", CMD_OP_ADD, len(p), cid) + p
+    seg = struct.pack("<IBBHIII", CMD_TABLE_MAGIC, CMD_TABLE_FORMAT, CMD_SEG_BASE, len(m.rows), m.version,
+                      len(body), zlib.crc32(body)) + body
+    seg += b"\xff" * (-len(seg) % 4)
+    slot = size // 2 // CMD_TABLE_SECTOR * CMD_TABLE_SECTOR  # CMD_TABLE_SLOT_SIZE()
+    if len(seg) > slot:
+        raise ManifestError(f"{len(seg)} bytes do not fit a {size} byte partition's {slot} byte slot")
+    return seg + b"\xff" * (size - len(seg))
+
+
+def write_if_changed(path, data):
+    """Leaves an unchanged output alone so the build does not recompile its users."""
+    try:
+        with open(path, "rb") as f:
+            if f.read() == data:
+                return
+    except OSError:
+        pass
+    os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+    with open(path, "wb") as f:
+        f.write(data)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Generate the command tables from phrase_manifest.csv")
+    ap.add_argument("--manifest", default=DEFAULT_MANIFEST)
+    ap.add_argument("--header", help="write phrase_table.h here")
+    ap.add_argument("--image", help="write a commands partition image here")
+    ap.add_argument("--image-size", type=lambda s: int(s, 0), default=64 * 1024)
+    args = ap.parse_args()
+    try:
+        m = load(args.manifest)
+        if args.header:
+            write_if_changed(args.header, c_header(m, os.path.basename(args.manifest)).encode())
+        if args.image:
+            write_if_changed(args.image, partition_image(m, args.image_size))
+    except (ManifestError, OSError) as e:
+        print(f"phrase_manifest: {e}", file=sys.stderr)
+        return 1
+    if not (args.header or args.image):
+        print(f"manifest v{m.version}, hash 0x{m.hash:08x}: {len(m.commands)} commands, {len(m.rows)} phrases")
+        for cid, phrase in m.phrases().items():
+            category, severity, action = m.commands[cid]
+            print(f"{cid:5d}  0x{m.entry(cid):04x}  {category:12s} {severity:7s} {action:5s} {phrase}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,209 @@
+"""phrase_match.py - transcript phrase matching in pi/phrase_match*.cpp, through ctypes.
+
+    matcher = phrase_match.load(PHRASES)   # None until build-pi/libphrase_match.so is built
+    matcher.phrases_in("please read me the card number and the sort code")
+    -> ["card number", "sort code"]
+
+    fuzzy = phrase_match.load_fuzzy(PHRASES, normalize_text)
+    fuzzy.best("plese read me the cart number", MATCH_THRESHOLD)
+    -> ("card number", 0.83...)            # what best_match() accepts, with its score
+
+    stream = matcher.stream()
+    stream.update("read me the card")      -> []
+    stream.update("read me the card number")  -> []
+    stream.update("read me the card number and")  -> [Match("card number", ...)]
+    stream.update("read me the card number and the", final=True); stream.reset()
+
+The automaton finds exact occurrences of a phrase's words, normalized like
+main.py's normalize_text(). A stream feeds it a recognizer's partial
+hypotheses, rescanning only the words that changed, and reports each phrase
+once it has stopped changing. The fuzzy matcher gives best_match()'s
+accept/reject decision and score for misheard phrases without scoring every
+phrase. phrase_match_bench.py compares them with best_match().
+"""
+import ctypes
+import os
+from collections import namedtuple
+
+DEFAULT_LIB = os.path.join(os.path.dirname(os.path.abspath(__file__)), "build-pi", "libphrase_match.so")
+
+ALL = 0  # every occurrence, overlapping ones too
+LONGEST = 1  # leftmost-longest, no overlaps
+
+
+# index into the phrase list, first token, character offsets into the text
+Match = namedtuple("Match", "phrase index token begin end")
+
+
+class _Hit(ctypes.Structure):
+    _fields_ = [("phrase", ctypes.c_int32), ("token", ctypes.c_uint32),
+                ("begin", ctypes.c_uint32), ("end", ctypes.c_uint32)]
+
+
+class _FuzzyResult(ctypes.Structure):
+    _fields_ = [("phrase", ctypes.c_int32), ("score", ctypes.c_double), ("signature_pass", ctypes.c_uint32),
+                ("lcs_pass", ctypes.c_uint32), ("scored", ctypes.c_uint32)]
+
+
+def _bind(lib):
+    lib.phrase_matcher_create.restype = ctypes.c_void_p
+    lib.phrase_matcher_create.argtypes = [ctypes.POINTER(ctypes.c_char_p), ctypes.c_size_t]
+    lib.phrase_matcher_destroy.restype = None
+    lib.phrase_matcher_destroy.argtypes = [ctypes.c_void_p]
+    lib.phrase_matcher_find.restype = ctypes.c_size_t
+    lib.phrase_matcher_find.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t, ctypes.c_int,
+                                        ctypes.POINTER(_Hit), ctypes.c_size_t]
+    lib.phrase_matcher_states.restype = ctypes.c_size_t
+    lib.phrase_matcher_states.argtypes = [ctypes.c_void_p]
+    lib.phrase_stream_create.restype = ctypes.c_void_p
+    lib.phrase_stream_create.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+    lib.phrase_stream_destroy.restype = None
+    lib.phrase_stream_destroy.argtypes = [ctypes.c_void_p]
+    lib.phrase_stream_reset.restype = None
+    lib.phrase_stream_reset.argtypes = [ctypes.c_void_p]
+    lib.phrase_stream_update.restype = ctypes.c_size_t
+    lib.phrase_stream_update.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t, ctypes.c_int,
+                                         ctypes.POINTER(_Hit), ctypes.c_size_t]
+    lib.phrase_stream_scanned.restype = ctypes.c_uint64
+    lib.phrase_stream_scanned.argtypes = [ctypes.c_void_p]
+    lib.phrase_fuzzy_create.restype = ctypes.c_void_p
+    lib.phrase_fuzzy_create.argtypes = [ctypes.POINTER(ctypes.c_char_p), ctypes.c_size_t]
+    lib.phrase_fuzzy_destroy.restype = None
+    lib.phrase_fuzzy_destroy.argtypes = [ctypes.c_void_p]
+    lib.phrase_fuzzy_best.restype = None
+    lib.phrase_fuzzy_best.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t, ctypes.c_double,
+                                      ctypes.POINTER(_FuzzyResult)]
+    return lib
+
+
+_libs = {}
+
+
+def _library(path):
+    """the bound library, or None if it is not built"""
+    if path not in _libs:
+        try:
+            _libs[path] = _bind(ctypes.CDLL(path))
+        except OSError:
+            _libs[path] = None
+    return _libs[path]
+
+
+def _matches(phrases, text, raw, hits):
+    """[Match] with the library's byte offsets into raw turned into character offsets into text"""
+    if len(raw) == len(text):
+        chars = lambda b: b  # noqa: E731
+    else:
+        chars = lambda b: len(raw[:b].decode(errors="ignore"))  # noqa: E731
+    return [Match(phrases[h.phrase], h.phrase, h.token, chars(h.begin), chars(h.end)) for h in hits]
+
+
+class PhraseMatcher:
+    def __init__(self, lib, phrases):
+        self._lib = lib
+        self.phrases = list(phrases)
+        encoded = (ctypes.c_char_p * len(self.phrases))(*(p.encode() for p in self.phrases))
+        self._m = lib.phrase_matcher_create(encoded, len(self.phrases))
+        if not self._m:
+            raise MemoryError("phrase_matcher_create failed")
+        self._hits = (_Hit * 64)()
+
+    def __del__(self):
+        if getattr(self, "_m", None):
+            self._lib.phrase_matcher_destroy(self._m)
+            self._m = None
+
+    def states(self):
+        return self._lib.phrase_matcher_states(self._m)
+
+    def find(self, text, mode=LONGEST):
+        """[Match] in text order (LONGEST) or by where they end (ALL); one thread at a time"""
+        raw = text.encode()
+        n = self._lib.phrase_matcher_find(self._m, raw, len(raw), mode, self._hits, len(self._hits))
+        if n > len(self._hits):
+            self._hits = (_Hit * n)()
+            n = self._lib.phrase_matcher_find(self._m, raw, len(raw), mode, self._hits, n)
+        return _matches(self.phrases, text, raw, self._hits[:n])
+
+    def phrases_in(self, text):
+        """distinct phrases in text, in order of first occurrence"""
+        return list(dict.fromkeys(m.phrase for m in self.find(text)))
+
+    def stream(self, stable_updates=2):
+        """a PhraseStream for one recognizer's utterances"""
+        return PhraseStream(self, stable_updates)
+
+
+class PhraseStream:
+    """Phrases in a recognizer's partial hypotheses, each reported once as soon as it is stable:
+    unchanged for stable_updates hypotheses (see pi/phrase_match.h)."""
+
+    def __init__(self, matcher, stable_updates=2):
+        self._matcher = matcher  # the automaton must outlive the stream
+        self._lib = matcher._lib
+        self._s = self._lib.phrase_stream_create(matcher._m, stable_updates)
+        if not self._s:
+            raise MemoryError("phrase_stream_create failed")
+        self._hits = (_Hit * 16)()
+        self.detected = 0  # occurrences reported in this utterance
+
+    def __del__(self):
+        if getattr(self, "_s", None):
+            self._lib.phrase_stream_destroy(self._s)
+            self._s = None
+
+    def update(self, text, final=False):
+        """[Match] newly stable in this hypothesis of the utterance, in text order; all the rest when final"""
+        raw = text.encode()
+        out = []
+        while True:
+            n = self._lib.phrase_stream_update(self._s, raw, len(raw), final, self._hits, len(self._hits))
+            out += _matches(self._matcher.phrases, text, raw, self._hits[:n])
+            if n < len(self._hits):
+                break
+        self.detected += len(out)
+        return out
+
+    def reset(self):
+        """start the next utterance"""
+        self._lib.phrase_stream_reset(self._s)
+        self.detected = 0
+
+    def scanned(self):
+        """words run through the automaton so far, over all utterances"""
+        return self._lib.phrase_stream_scanned(self._s)
+
+
+class FuzzyMatcher:
+    def __init__(self, lib, phrases, normalize):
+        self._lib = lib
+        self.phrases = list(phrases)
+        self.normalize = normalize
+        encoded = (ctypes.c_char_p * len(self.phrases))(*(normalize(p).encode() for p in self.phrases))
+        self._f = lib.phrase_fuzzy_create(encoded, len(self.phrases))
+        if not self._f:
+            raise MemoryError("phrase_fuzzy_create failed")
+        self.last = _FuzzyResult()  # counters of the last call
+
+    def __del__(self):
+        if getattr(self, "_f", None):
+            self._lib.phrase_fuzzy_destroy(self._f)
+            self._f = None
+
+    def best(self, text, threshold):
+        """(phrase, score) as best_match() gives them when score >= threshold; phrase is None below it"""
+        raw = self.normalize(text).encode()
+        self._lib.phrase_fuzzy_best(self._f, raw, len(raw), threshold, ctypes.byref(self.last))
+        return (self.phrases[self.last.phrase] if self.last.phrase >= 0 else None), self.last.score
+
+
+def load(phrases, path=DEFAULT_LIB):
+    """A PhraseMatcher for phrases, or None if the library is not built."""
+    lib = _library(path)
+    return PhraseMatcher(lib, phrases) if lib else None
+
+
+def load_fuzzy(phrases, normalize, path=DEFAULT_LIB):
+    """A FuzzyMatcher for phrases, normalized with main.py's normalize_text(); None if the library is not built."""
+    lib = _library(path)
+    return FuzzyMatcher(lib, phrases, normalize) if lib else None
@@ -0,0 +1,264 @@
+"""phrase_match_bench.py - main.py's best_match() against the phrase_match matchers on transcripts.
+
+    python3 phrase_match_bench.py [--lib PATH] [--count N] [--words N] [--misheard N]
+                                  [--tolerance X] [--min-speedup X] [--stable N] [--revise P] [FILE ...]
+
+Each FILE holds one transcript per line (recordings run through Vosk or
+Google). Without files, --count synthetic call transcripts of --words words
+are made from filler speech with PHRASES planted in them, and --misheard
+short utterances from PHRASES with letters and words changed.
+
+Exact: time per transcript against best_match(), planted phrases each one
+reports, and the automaton's occurrences checked against a plain token scan.
+Fuzzy: the C++ best_match() must accept and reject the same transcripts,
+pick the same phrase with a score within --tolerance, and be at least
+--min-speedup times faster.
+Streaming: each transcript is fed to a PhraseStream word by word like Vosk
+partials, the newest word misheard (or cut short) with probability --revise
+and corrected in the next partial. Nothing may be reported that the final
+transcript lacks, and everything it has must be, bar occurrences inside a
+longer one; reports as the call goes are compared with waiting for the
+final result, and words scanned with rescanning every partial.
+Ends with PASS or FAIL.
+"""
+import argparse
+import ast
+import os
+import random
+import string
+import sys
+import time
+from difflib import SequenceMatcher
+
+import phrase_match
+
+MAIN = os.path.join(os.path.dirname(os.path.abspath(__file__)), "main.py")
+
+FILLER = ("hello yes this is calling from the about your we have noticed some unusual activity on so i need "
+          "you to just a moment please can you hear me okay right now today sir madam thank you for your time "
+          "it is very important that we sort this out before the end of the day otherwise there could be a "
+          "problem with everything alright let me check that for you one second").split()
+
+
+def from_main(names):
+    """PHRASES, best_match() and friends out of main.py, which needs RPi.GPIO to import"""
+    tree = ast.parse(open(MAIN).read(), MAIN)
+    keep = [n for n in tree.body
+            if (isinstance(n, ast.Assign) and any(getattr(t, "id", None) in names for t in n.targets))
+            or (isinstance(n, ast.FunctionDef) and n.name in names)]
+    ns = {"string": string, "SequenceMatcher": SequenceMatcher}
+    exec(compile(ast.Module(body=keep, type_ignores=[]), MAIN, "exec"), ns)
+    return ns
+
+
+def synthetic(phrases, count, words, rng):
+    """[(transcript, planted phrases)]: one planted phrase per 40 words or so"""
+    out = []
+    for _ in range(count):
+        tokens = [rng.choice(FILLER) for _ in range(words)]
+        planted = rng.sample(phrases, max(1, words // 40))
+        for p in planted:
+            at = rng.randrange(len(tokens) + 1)
+            tokens[at:at] = p.split()
+        out.append((" ".join(tokens), planted))
+    return out
+
+
+def misheard(phrases, count, rng):
+    """utterances with a phrase in them, a few letters changed and filler words around it"""
+    out = []
+    for _ in range(count):
+        chars = list(rng.choice(phrases))
+        for _ in range(rng.randrange(4)):
+            at = rng.randrange(len(chars) + 1)
+            edit = rng.randrange(3)
+            if edit == 0 and at < len(chars):
+                chars[at] = rng.choice(string.ascii_lowercase + " ")
+            elif edit == 1 and at < len(chars):
+                del chars[at]
+            else:
+                chars.insert(at, rng.choice(string.ascii_lowercase))
+        words = "".join(chars).split()
+        for _ in range(rng.randrange(4)):
+            words.insert(rng.randrange(len(words) + 1), rng.choice(FILLER))
+        out.append(" ".join(words))
+    return out
+
+
+def reference(phrases, text, normalize):
+    """every (phrase, first token) by comparing each phrase at each position"""
+    tokens = normalize(text).split()
+    found = set()
+    for i, p in enumerate(phrases):
+        pt = normalize(p).split()
+        for at in range(len(tokens) - len(pt) + 1 if pt else 0):
+            if tokens[at:at + len(pt)] == pt:
+                found.add((i, at))
+    return found
+
+
+def partials(text, vocab, revise, rng):
+    """Vosk-like hypotheses for text, one more word each; the newest word is sometimes wrong until the next"""
+    words = text.split()
+    out = []
+    for n in range(1, len(words) + 1):
+        heard = words[:n]
+        if rng.random() < revise:
+            last = heard[-1]
+            heard[-1] = last[:rng.randrange(1, len(last))] if len(last) > 1 and rng.random() < 0.3 \
+                else rng.choice(vocab)
+        out.append(" ".join(heard))
+    return out
+
+
+def not_covered(phrases, found, normalize):
+    """found (phrase, first token) less occurrences inside a longer one"""
+    size = {i: len(normalize(p).split()) for i, p in enumerate(phrases)}
+    return {(i, at) for i, at in found
+            if not any(j_at <= at and j_at + size[j] >= at + size[i] and size[j] > size[i] for j, j_at in found)}
+
+
+def timed(fn, items, min_s=0.5):
+    """seconds per item, repeating the whole set for at least min_s"""
+    runs, t0 = 0, time.perf_counter()
+    while True:
+        for x in items:
+            fn(x)
+        runs += 1
+        elapsed = time.perf_counter() - t0
+        if elapsed >= min_s:
+            return elapsed / (runs * len(items))
+
+
+def main():
+    ap = argparse.ArgumentParser(description="best_match() vs the phrase_match automaton")
+    ap.add_argument("--lib", default=phrase_match.DEFAULT_LIB)
+    ap.add_argument("--count", type=int, default=50)
+    ap.add_argument("--words", type=int, default=400)
+    ap.add_argument("--misheard", type=int, default=1000)
+    ap.add_argument("--tolerance", type=float, default=1e-9)
+    ap.add_argument("--min-speedup", type=float, default=50.0)
+    ap.add_argument("--stable", type=int, default=2, help="partials a phrase must hold before it is reported")
+    ap.add_argument("--revise", type=float, default=0.3, help="chance the newest word of a partial is wrong")
+    ap.add_argument("files", nargs="*")
+    args = ap.parse_args()
+
+    ns = from_main({"PHRASES", "MATCH_THRESHOLD", "normalize_text", "best_match"})
+    phrases, best_match, normalize = ns["PHRASES"], ns["best_match"], ns["normalize_text"]
+    threshold = ns["MATCH_THRESHOLD"]
+    t0 = time.perf_counter()
+    matcher = phrase_match.load(phrases, args.lib)
+    fuzzy = phrase_match.load_fuzzy(phrases, normalize, args.lib)
+    if not matcher:
+        print(f"{args.lib} not found; build it with: cmake -S pi -B build-pi && cmake --build build-pi")
+        return 2
+    build_ms = (time.perf_counter() - t0) * 1000
+
+    rng = random.Random(1)
+    if args.files:
+        corpus = [(line.strip(), None) for f in args.files for line in open(f) if line.strip()]
+        utterances = [t for t, _ in corpus]
+    else:
+        corpus = synthetic(phrases, args.count, args.words, rng)
+        utterances = misheard(phrases, args.misheard, rng) + [t for t, _ in corpus]
+    texts = [t for t, _ in corpus]
+    words = sum(len(t.split()) for t in texts) / len(texts)
+    print(f"{len(phrases)} phrases, {matcher.states()} automaton states, built in {build_ms:.1f} ms")
+    print(f"{len(texts)} transcripts, {words:.0f} words on average")
+
+    failures = 0
+    for t in texts:
+        got = {(m.index, m.token) for m in matcher.find(t, phrase_match.ALL)}
+        if got != reference(phrases, t, normalize):
+            failures += 1
+    print(f"occurrences vs a plain token scan: {len(texts) - failures}/{len(texts)} transcripts agree")
+
+    best_s = timed(lambda t: best_match(t, phrases), texts)
+    auto_s = timed(matcher.phrases_in, texts)
+    print(f"best_match:   {best_s * 1000:9.3f} ms per transcript")
+    print(f"phrase_match: {auto_s * 1000:9.3f} ms per transcript ({best_s / auto_s:.0f}x faster)")
+
+    if corpus[0][1] is not None:
+        planted = sum(len(p) for _, p in corpus)
+        by_best = sum(best_match(t, phrases)[0] in p and best_match(t, phrases)[1] >= ns["MATCH_THRESHOLD"]
+                      for t, p in corpus)
+        by_auto = sum(len(set(p) & set(matcher.phrases_in(t))) for t, p in corpus)
+        print(f"planted phrases reported: best_match {by_best}/{planted}, phrase_match {by_auto}/{planted}")
+
+    # fuzzy: best_match()'s decisions
+    print(f"\nfuzzy: {len(utterances)} transcripts, threshold {threshold}")
+    disagree = accepted = signature = lcs = scored = 0
+    for t in utterances:
+        want, want_score = best_match(t, phrases)
+        got, got_score = fuzzy.best(t, threshold)
+        signature += fuzzy.last.signature_pass
+        lcs += fuzzy.last.lcs_pass
+        scored += fuzzy.last.scored
+        if want_score >= threshold:
+            accepted += 1
+            ok = got == want and abs(got_score - want_score) <= args.tolerance
+        else:
+            ok = got is None
+        if not ok:
+            disagree += 1
+            if disagree <= 5:
+                print(f"  differs: {t!r}: best_match {want!r} {want_score:.4f}, fuzzy {got!r} {got_score:.4f}")
+    n = len(utterances)
+    print(f"decisions: {n - disagree}/{n} agree ({accepted} accepted by best_match)")
+    print(f"phrases per transcript: {len(phrases)} -> {signature / n:.1f} past the character counts -> "
+          f"{lcs / n:.1f} past the LCS bound -> {scored / n:.1f} scored")
+    best_s = timed(lambda t: best_match(t, phrases), utterances)
+    fuzzy_s = timed(lambda t: fuzzy.best(t, threshold), utterances)
+    speedup = best_s / fuzzy_s
+    print(f"best_match:   {best_s * 1000:9.3f} ms per transcript")
+    print(f"phrase_fuzzy: {fuzzy_s * 1000:9.3f} ms per transcript ({speedup:.0f}x faster, {args.min_speedup:.0f}x needed)")
+    failures += disagree + (speedup < args.min_speedup)
+
+    # streaming: phrases reported from partial hypotheses
+    print(f"\nstreaming: {len(texts)} transcripts word by word, newest word wrong {args.revise:.0%} of the time, "
+          f"reported after {args.stable} unchanged partials")
+    vocab = sorted({w for p in phrases for w in normalize(p).split()} | set(FILLER))
+    stream = matcher.stream(args.stable)
+    hypotheses = []
+    false = missing = reported = early = 0
+    early_words = final_words = 0
+    for t in texts:
+        updates = partials(t, vocab, args.revise, rng) + [t]
+        hypotheses.append(updates)
+        words = len(t.split())
+        got = {}
+        for n, h in enumerate(updates):
+            for m in stream.update(h, final=n == len(updates) - 1):
+                got.setdefault((m.index, m.token), min(n + 1, words))
+        stream.reset()
+        want = not_covered(phrases, reference(phrases, t, normalize), normalize)
+        false += len(set(got) - want)
+        missing += len(want - set(got))
+        for (i, at), heard in got.items():
+            if (i, at) not in want:
+                continue
+            end = at + len(normalize(phrases[i]).split())
+            reported += 1
+            early += heard < words
+            early_words += heard - end
+            final_words += words - end
+    updates = sum(len(u) for u in hypotheses)
+    rescan = sum(len(h.split()) for u in hypotheses for h in u)
+    print(f"reported {reported} occurrences, {false} not in the final transcript, {missing} missed")
+    if reported:
+        print(f"words after a phrase before it is reported: {early_words / reported:.1f} streaming, "
+              f"{final_words / reported:.1f} waiting for the final result ({early}/{reported} before it)")
+    print(f"words scanned: {stream.scanned()} streaming, {rescan} rescanning every partial "
+          f"({rescan / max(1, stream.scanned()):.0f}x)")
+    stream_s = timed(lambda u: [stream.update(h) for h in u] + [stream.reset()], hypotheses) / \
+        (updates / len(hypotheses))
+    rescan_s = timed(lambda u: [matcher.find(h) for h in u], hypotheses) / (updates / len(hypotheses))
+    print(f"per partial: {stream_s * 1e6:.1f} us streaming, {rescan_s * 1e6:.1f} us rescanning")
+    failures += false + missing
+
+    print("FAIL" if failures else "PASS")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,178 @@
+/* link_decoder.cpp - byte-at-a-time frame decoder and JSON formatting for the Pi link */
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "link_decoder.h"
+#include "phrase_table.h"
+
+void link_decoder_init(link_decoder_t *d)
+{
+    memset(d, 0, sizeof(*d));
+}
+
+static void drop(link_decoder_t *d, size_t k)
+{
+    memmove(d->buf, d->buf + k, d->n - k);
+    d->n -= k;
+}
+
+static void emit(link_decoder_t *d, link_frame_fn fn, void *ctx)
+{
+    link_frame_t f;
+    f.type = d->buf[2];
+    f.seq = d->buf[3];
+    f.len = d->buf[4];
+    memcpy(f.payload, d->buf + LINK_HEADER_BYTES, f.len);
+    if (d->have_seq)
+        d->lost += (uint8_t)(f.seq - d->next_seq);
+    d->have_seq = true;
+    d->next_seq = (uint8_t)(f.seq + 1);
+    d->frames++;
+    fn(&f, ctx);
+}
+
+/* consumes as many complete frames or garbage bytes from buf as it can */
+static void scan(link_decoder_t *d, link_frame_fn fn, void *ctx)
+{
+    while (d->n)
+    {
+        if (d->buf[0] != LINK_SOF0 || (d->n >= 2 && d->buf[1] != LINK_SOF1))
+        {
+            d->skipped++;
+            drop(d, 1);
+            continue;
+        }
+        if (d->n < LINK_HEADER_BYTES)
+            return;
+        size_t len = d->buf[4];
+        if (len > LINK_MAX_PAYLOAD)
+        {
+            d->skipped++;
+            drop(d, 1);
+            continue;
+        }
+        size_t total = LINK_HEADER_BYTES + len + LINK_CRC_BYTES;
+        if (d->n < total)
+            return;
+        uint16_t crc = link_crc16(0xFFFF, d->buf + 2, 3 + len);
+        uint16_t got = (uint16_t)(d->buf[total - 2] | d->buf[total - 1] << 8);
+        if (crc != got)
+        {
+            // the real frame start may be inside what we took for this frame
+            d->crc_errors++;
+            drop(d, 1);
+            continue;
+        }
+        emit(d, fn, ctx);
+        drop(d, total);
+    }
+}
+
+void link_decoder_push(link_decoder_t *d, const uint8_t *data, size_t n, link_frame_fn fn, void *ctx)
+{
+    while (n)
+    {
+        size_t k = sizeof(d->buf) - d->n;
+        if (k > n)
+            k = n;
+        memcpy(d->buf + d->n, data, k);
+        d->n += k;
+        data += k;
+        n -= k;
+        scan(d, fn, ctx);
+    }
+}
+
+/* copies the payload into a zeroed struct; false if the frame is shorter than `need`
+ * (the struct's size unless fields appended later may be missing from older firmware) */
+static bool payload_as(const link_frame_t *f, void *out, size_t size, size_t need)
+{
+    memset(out, 0, size);
+    if (f->len < need)
+        return false;
+    memcpy(out, f->payload, f->len < size ? f->len : size);
+    return true;
+}
+
+static bool payload_as(const link_frame_t *f, void *out, size_t size)
+{
+    return payload_as(f, out, size, size);
+}
+
+size_t link_frame_json(const link_frame_t *f, char *out, size_t len)
+{
+    int n = 0;
+    switch (f->type)
+    {
+    case LINK_HELLO:
+    {
+        link_hello_t h;
+        if (!payload_as(f, &h, sizeof(h), offsetof(link_hello_t, phrase_table)))
+            break;
+        n = snprintf(out, len, "{\"type\":\"hello\",\"seq\":%u,\"t_ms\":%u,\"version\":%u,\"phrase_table\":%u}", f->seq,
+                     (unsigned)h.t_ms, h.version, (unsigned)h.phrase_table);
+        break;
+    }
+    case LINK_WAKE:
+    {
+        link_wake_t w;
+        if (!payload_as(f, &w, sizeof(w)))
+            break;
+        n = snprintf(out, len, "{\"type\":\"wake\",\"seq\":%u,\"t_ms\":%u,\"model_index\":%d,\"word_index\":%d,\"channel\":%d}",
+                     f->seq, (unsigned)w.t_ms, w.model_index, w.word_index, w.channel);
+        break;
+    }
+    case LINK_COMMAND:
+    {
+        link_command_t c;
+        if (!payload_as(f, &c, sizeof(c), offsetof(link_command_t, severity)))
+            break;
+        // names from this build's phrase table; the hello frame says whether the firmware's matches
+        n = snprintf(out, len,
+                     "{\"type\":\"command\",\"seq\":%u,\"t_ms\":%u,\"rank\":%u,\"accepted\":%s,\"command_id\":%d,"
+                     "\"phrase_id\":%d,\"prob\":%.4f,\"severity\":\"%s\",\"category\":\"%s\"}",
+                     f->seq, (unsigned)c.t_ms, c.rank, c.accepted ? "true" : "false", c.command_id, c.phrase_id,
+                     c.prob_q16 / 65535.0, c.severity < 4 ? phrase_severity_names[c.severity] : "unknown",
+                     c.category < PHRASE_CATEGORY_COUNT ? phrase_category_names[c.category] : "unknown");
+        break;
+    }
+    case LINK_TIMEOUT:
+    {
+        link_timeout_t t;
+        if (!payload_as(f, &t, sizeof(t)))
+            break;
+        n = snprintf(out, len, "{\"type\":\"timeout\",\"seq\":%u,\"t_ms\":%u}", f->seq, (unsigned)t.t_ms);
+        break;
+    }
+    case LINK_AUDIO_STATS:
+    {
+        link_audio_stats_t a;
+        if (!payload_as(f, &a, sizeof(a)))
+            break;
+        n = snprintf(out, len,
+                     "{\"type\":\"audio_stats\",\"seq\":%u,\"t_ms\":%u,\"rms_dbfs\":%.1f,\"peak\":%d,\"dc\":%d,"
+                     "\"silent_pct\":%u,\"clipped\":%u,\"overruns\":%u,\"underruns\":%u,\"chunks\":%u}",
+                     f->seq, (unsigned)a.t_ms, a.rms_dbfs_x10 / 10.0, a.peak, a.dc, a.silent_pct, a.clipped, a.overruns,
+                     a.underruns, a.chunks);
+        break;
+    }
+    case LINK_SILENCE:
+    {
+        static const char *const states[] = {"idle", "calibrating", "grace", "tracking"};
+        link_silence_t l;
+        if (!payload_as(f, &l, sizeof(l)))
+            break;
+        n = snprintf(out, len,
+                     "{\"type\":\"silence\",\"seq\":%u,\"t_ms\":%u,\"state\":\"%s\",\"silent_s\":%u,"
+                     "\"floor_dbfs\":%.1f,\"threshold_dbfs\":%.1f}",
+                     f->seq, (unsigned)l.t_ms, l.state < 4 ? states[l.state] : "unknown", l.silent_s,
+                     l.floor_dbfs_x10 / 10.0, l.threshold_dbfs_x10 / 10.0);
+        break;
+    }
+    default:
+        break;
+    }
+    if (n <= 0)
+        n = snprintf(out, len, "{\"type\":\"unknown\",\"id\":%u,\"seq\":%u,\"len\":%u}", f->type, f->seq, f->len);
+    return (size_t)n < len ? (size_t)n : len - 1;
+}
@@ -0,0 +1,37 @@
+/* link_decoder.h - streaming decoder for the ESP32 -> Pi event link (wire format in wake/main/link_proto.h) */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "link_proto.h"
+
+typedef struct
+{
+    uint8_t type; // link_type_t
+    uint8_t seq;
+    uint8_t len;
+    uint8_t payload[LINK_MAX_PAYLOAD];
+} link_frame_t;
+
+typedef struct
+{
+    uint8_t buf[LINK_FRAME_MAX];
+    size_t n;
+    bool have_seq;
+    uint8_t next_seq;
+    uint32_t frames;     // good frames delivered
+    uint32_t crc_errors; // frames rejected by the CRC
+    uint32_t skipped;    // bytes dropped while hunting for a frame start
+    uint32_t lost;       // frames missing from the seq sequence: lost on the wire or dropped by the firmware
+} link_decoder_t;
+
+typedef void (*link_frame_fn)(const link_frame_t *f, void *ctx);
+
+void link_decoder_init(link_decoder_t *d);
+
+/* Feeds any number of bytes, split anywhere; calls fn once per frame that
+ * passes its CRC. After a bad frame it resyncs at the next 0xA5 0x5A. */
+void link_decoder_push(link_decoder_t *d, const uint8_t *data, size_t n, link_frame_fn fn, void *ctx);
+
+/* One JSON object per frame, e.g. {"type":"wake","seq":3,"t_ms":1200,...}; returns its length */
+size_t link_frame_json(const link_frame_t *f, char *out, size_t len);
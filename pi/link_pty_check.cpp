@@ -0,0 +1,232 @@
+/* link_pty_check.cpp - end-to-end check of the link framing over a Linux pty pair
+ *
+ * A writer thread encodes a known event sequence with link_encode() and
+ * writes it into the pty master in random-sized pieces, with line noise
+ * between frames, one frame whose payload is corrupted and one cut short.
+ * The reader decodes the raw slave side with link_decoder. Passes when every
+ * intact frame arrives once, in order, with the same payload and the fields
+ * expected in its JSON, and both damaged frames are rejected.
+ *
+ *   link_pty_check [--frames N]
+ */
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "link_decoder.h"
+#include "phrase_table.h"
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t len;
+    uint8_t payload[LINK_MAX_PAYLOAD];
+    char json[96]; // must appear in link_frame_json()'s output, if set
+} expected_t;
+
+typedef struct
+{
+    const std::vector<expected_t> *want;
+    size_t next;
+    int mismatches;
+} check_t;
+
+static uint32_t xorshift(uint32_t *s)
+{
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+/* the i-th event of the sequence, cycling through every frame type */
+static expected_t make_event(int i)
+{
+    expected_t e = {};
+    uint32_t t_ms = 1000 + 37 * (uint32_t)i;
+    switch (i % 6)
+    {
+    case 0:
+    {
+        link_hello_t h = {t_ms, LINK_VERSION, PHRASE_TABLE_HASH};
+        snprintf(e.json, sizeof(e.json), "\"phrase_table\":%u}", (unsigned)PHRASE_TABLE_HASH);
+        e.type = LINK_HELLO;
+        e.len = sizeof(h);
+        memcpy(e.payload, &h, sizeof(h));
+        break;
+    }
+    case 1:
+    {
+        link_wake_t w = {t_ms, 0, (int8_t)(i % 3), -1};
+        e.type = LINK_WAKE;
+        e.len = sizeof(w);
+        memcpy(e.payload, &w, sizeof(w));
+        break;
+    }
+    case 2:
+    {
+        uint8_t severity = (uint8_t)(1 + i % 3), category = (uint8_t)(1 + i % (PHRASE_CATEGORY_COUNT - 1));
+        link_command_t c = {t_ms, 1, 1, (int16_t)(i % 200), (int16_t)(i % 50), (uint16_t)(i * 997), severity, category};
+        snprintf(e.json, sizeof(e.json), "\"severity\":\"%s\",\"category\":\"%s\"}", phrase_severity_names[severity],
+                 phrase_category_names[category]);
+        e.type = LINK_COMMAND;
+        e.len = sizeof(c);
+        memcpy(e.payload, &c, sizeof(c));
+        break;
+    }
+    case 3:
+    {
+        link_timeout_t t = {t_ms};
+        e.type = LINK_TIMEOUT;
+        e.len = sizeof(t);
+        memcpy(e.payload, &t, sizeof(t));
+        break;
+    }
+    case 4:
+    {
+        link_audio_stats_t a = {t_ms, -423, 1200, -3, 12, 0, 0, 1, 0, 156};
+        e.type = LINK_AUDIO_STATS;
+        e.len = sizeof(a);
+        memcpy(e.payload, &a, sizeof(a));
+        break;
+    }
+    default:
+    {
+        link_silence_t l = {t_ms, (uint16_t)(i % 600), -512, -542, 3};
+        e.type = LINK_SILENCE;
+        e.len = sizeof(l);
+        memcpy(e.payload, &l, sizeof(l));
+        break;
+    }
+    }
+    return e;
+}
+
+static void on_frame(const link_frame_t *f, void *ctx)
+{
+    check_t *c = (check_t *)ctx;
+    if (c->next >= c->want->size())
+    {
+        c->mismatches++;
+        return;
+    }
+    const expected_t &e = (*c->want)[c->next++];
+    if (f->type != e.type || f->len != e.len || memcmp(f->payload, e.payload, e.len) != 0)
+    {
+        c->mismatches++;
+        return;
+    }
+    char json[256];
+    if (e.json[0] && (link_frame_json(f, json, sizeof(json)) == 0 || !strstr(json, e.json)))
+        c->mismatches++;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 2000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frames = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: link_pty_check [--frames N]\n");
+            return 2;
+        }
+    }
+    if (frames < 10)
+        frames = 10;
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        perror("link_pty_check: posix_openpt");
+        return 2;
+    }
+    int slave = open(ptsname(master), O_RDONLY | O_NOCTTY);
+    struct termios t;
+    if (slave < 0 || tcgetattr(slave, &t) != 0)
+    {
+        perror("link_pty_check: pty slave");
+        return 2;
+    }
+    cfmakeraw(&t); // the same raw mode wake_link puts a serial port in
+    tcsetattr(slave, TCSANOW, &t);
+
+    // build the byte stream and the frames the reader must see
+    std::vector<uint8_t> stream;
+    std::vector<expected_t> want;
+    uint32_t s = 2463534242u;
+    int corrupt_at = frames / 3, truncate_at = 2 * frames / 3;
+    for (int i = 0; i < frames; ++i)
+    {
+        expected_t e = make_event(i);
+        uint8_t frame[LINK_FRAME_MAX];
+        size_t n = link_encode(frame, e.type, (uint8_t)i, e.payload, e.len);
+        if (i == corrupt_at)
+            frame[LINK_HEADER_BYTES + 1] ^= 0x10;
+        else if (i == truncate_at)
+            n -= 3;
+        else
+            want.push_back(e);
+        stream.insert(stream.end(), frame, frame + n);
+        if (xorshift(&s) % 8 == 0)
+        {
+            // line noise, including stray start bytes
+            static const uint8_t noise[] = {0x00, LINK_SOF0, 0xFF, LINK_SOF0, LINK_SOF1, 0x7F};
+            stream.insert(stream.end(), noise, noise + 1 + xorshift(&s) % sizeof(noise));
+        }
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::thread writer([&]() {
+        uint32_t w = 88172645u;
+        for (size_t off = 0; off < stream.size();)
+        {
+            size_t k = 1 + xorshift(&w) % 64;
+            if (k > stream.size() - off)
+                k = stream.size() - off;
+            ssize_t n = write(master, stream.data() + off, k);
+            if (n <= 0)
+                break;
+            off += (size_t)n;
+        }
+    });
+
+    link_decoder_t dec;
+    link_decoder_init(&dec);
+    check_t check = {&want, 0, 0};
+    size_t received = 0;
+    uint8_t buf[256];
+    while (received < stream.size())
+    {
+        struct pollfd p = {slave, POLLIN, 0};
+        if (poll(&p, 1, 1000) <= 0)
+            break; // nothing for a second: the rest is not coming
+        ssize_t n = read(slave, buf, sizeof(buf));
+        if (n <= 0)
+            break;
+        received += (size_t)n;
+        link_decoder_push(&dec, buf, (size_t)n, on_frame, &check);
+    }
+    writer.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    printf("link_pty_check: bytes=%zu/%zu frames=%u/%zu crc_errors=%u lost=%u skipped_bytes=%u mismatches=%d "
+           "%.0f kB/s\n",
+           received, stream.size(), (unsigned)dec.frames, want.size(), (unsigned)dec.crc_errors, (unsigned)dec.lost,
+           (unsigned)dec.skipped, check.mismatches, secs > 0 ? received / 1024.0 / secs : 0.0);
+    bool ok = received == stream.size() && check.next == want.size() && check.mismatches == 0 && dec.crc_errors >= 1 &&
+              dec.lost == 2;
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    close(slave);
+    close(master);
+    return ok ? 0 : 1;
+}
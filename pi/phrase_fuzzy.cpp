@@ -0,0 +1,359 @@
+/* phrase_fuzzy.cpp - bounded, bit-parallel rewrite of main.py's best_match() */
+#include <string.h>
+#include <algorithm>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "phrase_fuzzy.h"
+
+typedef uint64_t lanes_t __attribute__((vector_size(8 * PHRASE_FUZZY_LANES)));
+
+typedef struct
+{
+    std::vector<int32_t> sym;                       // code points as symbol ids
+    std::vector<std::pair<int32_t, int32_t>> count; // (symbol, occurrences), the signature
+    std::vector<int32_t> tokens;                    // distinct word ids
+} fuzzy_phrase_t;
+
+struct phrase_fuzzy
+{
+    std::unordered_map<uint32_t, int32_t> symbols; // code point -> id, phrase characters only
+    std::unordered_map<std::string, int32_t> words;
+    std::vector<fuzzy_phrase_t> phrases;
+    std::vector<uint64_t> pm; // [symbol * padded + phrase]: bit i set if the phrase's character i is the symbol
+    size_t padded;            // phrase count rounded up to PHRASE_FUZZY_LANES
+};
+
+/* per-thread buffers, so a query allocates nothing once they have grown */
+typedef struct
+{
+    std::vector<uint32_t> cps;             // text code points
+    std::vector<int32_t> b;                // text symbols, -1 for characters no phrase has
+    std::vector<int32_t> known;            // text symbols without the -1s, for the LCS
+    std::vector<int32_t> count;            // per symbol, in the text
+    std::vector<std::vector<int32_t>> b2j; // per symbol, its text positions; difflib's b2j after autojunk
+    std::vector<uint32_t> word_seen;       // per word id: query stamp when in the text
+    std::vector<uint32_t> len[2], stamp[2];
+    std::vector<int32_t> candidates;
+    std::vector<double> bound;   // per phrase: upper bound on its score
+    std::vector<double> overlap; // per phrase: share of its words in the text
+    std::vector<int32_t> queue;
+    std::string word;
+    uint32_t query, row;
+} fuzzy_scratch_t;
+
+static thread_local fuzzy_scratch_t scratch;
+
+/* UTF-8 to code points; a malformed byte stands for itself */
+static void decode(const char *s, size_t len, std::vector<uint32_t> *out)
+{
+    out->clear();
+    for (size_t i = 0; i < len;)
+    {
+        unsigned char c = (unsigned char)s[i];
+        int n = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+        uint32_t cp = n ? c & (0x3F >> n) : c;
+        if (n && i + n >= len)
+        {
+            n = 0;
+            cp = c;
+        }
+        for (int k = 1; k <= n; ++k)
+        {
+            if (((unsigned char)s[i + k] & 0xC0) != 0x80)
+            {
+                n = 0;
+                cp = c;
+                break;
+            }
+            cp = cp << 6 | ((unsigned char)s[i + k] & 0x3F);
+        }
+        out->push_back(cp);
+        i += n + 1;
+    }
+}
+
+phrase_fuzzy_t *phrase_fuzzy_create(const char *const *phrases, size_t count)
+{
+    phrase_fuzzy_t *f = new (std::nothrow) phrase_fuzzy_t();
+    if (!f)
+        return NULL;
+    try
+    {
+        std::vector<uint32_t> cps;
+        f->phrases.resize(count);
+        for (size_t p = 0; p < count; ++p)
+        {
+            fuzzy_phrase_t &ph = f->phrases[p];
+            decode(phrases[p], strlen(phrases[p]), &cps);
+            for (uint32_t cp : cps)
+            {
+                int32_t s = f->symbols.emplace(cp, (int32_t)f->symbols.size()).first->second;
+                ph.sym.push_back(s);
+                auto it = std::find_if(ph.count.begin(), ph.count.end(), [s](const std::pair<int32_t, int32_t> &c) {
+                    return c.first == s;
+                });
+                if (it == ph.count.end())
+                    ph.count.push_back({s, 1});
+                else
+                    it->second++;
+            }
+            // normalized text: words are separated by single spaces
+            const char *w = phrases[p];
+            while (*w)
+            {
+                size_t n = strcspn(w, " ");
+                if (n)
+                {
+                    int32_t id = f->words.emplace(std::string(w, n), (int32_t)f->words.size()).first->second;
+                    if (std::find(ph.tokens.begin(), ph.tokens.end(), id) == ph.tokens.end())
+                        ph.tokens.push_back(id);
+                }
+                w += n + (w[n] == ' ');
+            }
+        }
+        f->padded = (count + PHRASE_FUZZY_LANES - 1) / PHRASE_FUZZY_LANES * PHRASE_FUZZY_LANES;
+        f->pm.assign(f->symbols.size() * f->padded, 0);
+        for (size_t p = 0; p < count; ++p)
+        {
+            const std::vector<int32_t> &sym = f->phrases[p].sym;
+            for (size_t i = 0; i < sym.size() && i < PHRASE_FUZZY_LCS_MAX; ++i)
+                f->pm[sym[i] * f->padded + p] |= 1ull << i;
+        }
+    }
+    catch (const std::bad_alloc &)
+    {
+        delete f;
+        return NULL;
+    }
+    return f;
+}
+
+void phrase_fuzzy_destroy(phrase_fuzzy_t *f)
+{
+    delete f;
+}
+
+/* difflib's find_longest_match() without junk: popular characters are only missing from b2j */
+static void longest_match(fuzzy_scratch_t *s, const int32_t *a, int alo, int ahi, int blo, int bhi, int *bi, int *bj,
+                          int *bk)
+{
+    int besti = alo, bestj = blo, bestsize = 0;
+    s->row += 2; // the first row must not see the previous call's last one
+    for (int i = alo; i < ahi; ++i, ++s->row)
+    {
+        uint32_t *cur = s->len[s->row & 1].data(), *cur_stamp = s->stamp[s->row & 1].data();
+        const uint32_t *prev = s->len[~s->row & 1].data(), *prev_stamp = s->stamp[~s->row & 1].data();
+        for (int32_t j : s->b2j[a[i]])
+        {
+            if (j < blo)
+                continue;
+            if (j >= bhi)
+                break;
+            int k = (j > 0 && prev_stamp[j - 1] == s->row - 1 ? (int)prev[j - 1] : 0) + 1;
+            cur[j] = (uint32_t)k;
+            cur_stamp[j] = s->row;
+            if (k > bestsize)
+            {
+                besti = i - k + 1;
+                bestj = j - k + 1;
+                bestsize = k;
+            }
+        }
+    }
+    const int32_t *b = s->b.data();
+    while (besti > alo && bestj > blo && a[besti - 1] == b[bestj - 1])
+    {
+        besti--;
+        bestj--;
+        bestsize++;
+    }
+    while (besti + bestsize < ahi && bestj + bestsize < bhi && a[besti + bestsize] == b[bestj + bestsize])
+        bestsize++;
+    *bi = besti;
+    *bj = bestj;
+    *bk = bestsize;
+}
+
+/* characters in get_matching_blocks(); the order blocks are found in does not change their sum */
+static int matching_chars(fuzzy_scratch_t *s, const std::vector<int32_t> &a)
+{
+    int matches = 0;
+    s->queue.clear();
+    s->queue.insert(s->queue.end(), {0, (int32_t)a.size(), 0, (int32_t)s->b.size()});
+    while (!s->queue.empty())
+    {
+        int bhi = s->queue.back(), blo = s->queue.end()[-2], ahi = s->queue.end()[-3], alo = s->queue.end()[-4];
+        s->queue.resize(s->queue.size() - 4);
+        int i, j, k;
+        longest_match(s, a.data(), alo, ahi, blo, bhi, &i, &j, &k);
+        if (!k)
+            continue;
+        matches += k;
+        if (alo < i && blo < j)
+            s->queue.insert(s->queue.end(), {alo, i, blo, j});
+        if (i + k < ahi && j + k < bhi)
+            s->queue.insert(s->queue.end(), {i + k, ahi, j + k, bhi});
+    }
+    return matches;
+}
+
+/* SequenceMatcher.ratio() and best_match()'s score, in Python's floating-point steps */
+static double score_of(int matches, size_t la, size_t lb, double overlap)
+{
+    double ratio = la + lb ? 2.0 * matches / (double)(la + lb) : 1.0;
+    return (0.7 * ratio) + (0.3 * overlap);
+}
+
+/* LCS of each lane's phrase with the text's known characters (Hyyro: V' = (V + U) | (V - U), U = V & PM) */
+static void lcs_lanes(const phrase_fuzzy_t *f, const fuzzy_scratch_t *s, const int32_t *lane, int *lcs)
+{
+    lanes_t v = ~(lanes_t){};
+    for (int32_t sym : s->known)
+    {
+        const uint64_t *pm = &f->pm[sym * f->padded];
+        lanes_t m;
+        for (int l = 0; l < PHRASE_FUZZY_LANES; ++l)
+            m[l] = pm[lane[l]];
+        lanes_t u = v & m;
+        v = (v + u) | (v - u);
+    }
+    for (int l = 0; l < PHRASE_FUZZY_LANES; ++l)
+    {
+        size_t m = std::min(f->phrases[lane[l]].sym.size(), (size_t)PHRASE_FUZZY_LCS_MAX);
+        uint64_t used = m == 64 ? ~0ull : (1ull << m) - 1;
+        lcs[l] = __builtin_popcountll(~v[l] & used);
+    }
+}
+
+void phrase_fuzzy_best(const phrase_fuzzy_t *f, const char *text, size_t len, double threshold,
+                       phrase_fuzzy_result_t *out)
+{
+    fuzzy_scratch_t *s = &scratch;
+    memset(out, 0, sizeof(*out));
+    out->phrase = -1;
+
+    // text as symbols, its character counts and difflib's b2j, popular characters dropped past 200 characters
+    std::vector<uint32_t> &cps = s->cps;
+    decode(text, len, &cps);
+    size_t nsym = f->symbols.size();
+    s->b.resize(cps.size());
+    s->known.clear();
+    s->count.assign(nsym, 0);
+    s->b2j.resize(nsym);
+    for (auto &v : s->b2j)
+        v.clear();
+    for (size_t j = 0; j < cps.size(); ++j)
+    {
+        auto it = f->symbols.find(cps[j]);
+        s->b[j] = it == f->symbols.end() ? -1 : it->second;
+        if (s->b[j] < 0)
+            continue;
+        s->known.push_back(s->b[j]);
+        s->count[s->b[j]]++;
+        s->b2j[s->b[j]].push_back((int32_t)j);
+    }
+    size_t lb = cps.size();
+    if (lb >= 200)
+    {
+        size_t ntest = lb / 100 + 1;
+        for (auto &v : s->b2j)
+        {
+            if (v.size() > ntest)
+                v.clear();
+        }
+    }
+    for (int k = 0; k < 2; ++k)
+    {
+        if (s->len[k].size() < lb)
+        {
+            s->len[k].resize(lb);
+            s->stamp[k].assign(lb, 0);
+            s->row = 0;
+        }
+    }
+    if (s->row > 0xF0000000u)
+    {
+        std::fill(s->stamp[0].begin(), s->stamp[0].end(), 0);
+        std::fill(s->stamp[1].begin(), s->stamp[1].end(), 0);
+        s->row = 0;
+    }
+
+    // words of the text
+    if (++s->query == 0)
+        s->word_seen.assign(s->word_seen.size(), 0), s->query = 1;
+    s->word_seen.resize(f->words.size(), 0);
+    for (const char *w = text, *end = text + len; w < end;)
+    {
+        size_t n = std::find(w, end, ' ') - w;
+        if (n)
+        {
+            s->word.assign(w, n);
+            auto it = f->words.find(s->word);
+            if (it != f->words.end())
+                s->word_seen[it->second] = s->query;
+        }
+        w += n + 1;
+    }
+
+    // bound 1: character counts
+    size_t np = f->phrases.size();
+    s->candidates.clear();
+    s->bound.assign(np, 0.0);
+    s->overlap.assign(np, 0.0);
+    std::vector<double> &bound = s->bound, &overlap = s->overlap;
+    for (size_t p = 0; p < np; ++p)
+    {
+        const fuzzy_phrase_t &ph = f->phrases[p];
+        int shared = 0;
+        for (int32_t t : ph.tokens)
+            shared += s->word_seen[t] == s->query;
+        overlap[p] = (double)shared / (double)std::max<size_t>(1, ph.tokens.size());
+        int m = 0;
+        for (auto &c : ph.count)
+            m += std::min(c.second, s->count[c.first]);
+        bound[p] = score_of(m, ph.sym.size(), lb, overlap[p]);
+        if (bound[p] >= threshold && bound[p] > 0.0)
+            s->candidates.push_back((int32_t)p);
+    }
+    out->signature_pass = (uint32_t)s->candidates.size();
+
+    // bound 2: LCS, PHRASE_FUZZY_LANES candidates at a time (the last group padded with its first)
+    for (size_t c = 0; c < s->candidates.size(); c += PHRASE_FUZZY_LANES)
+    {
+        int32_t lane[PHRASE_FUZZY_LANES];
+        int lcs[PHRASE_FUZZY_LANES];
+        for (int l = 0; l < PHRASE_FUZZY_LANES; ++l)
+            lane[l] = s->candidates[c + l < s->candidates.size() ? c + l : c];
+        lcs_lanes(f, s, lane, lcs);
+        for (int l = 0; l < PHRASE_FUZZY_LANES && c + l < s->candidates.size(); ++l)
+        {
+            const fuzzy_phrase_t &ph = f->phrases[lane[l]];
+            if (ph.sym.size() <= PHRASE_FUZZY_LCS_MAX)
+                bound[lane[l]] = std::min(bound[lane[l]], score_of(lcs[l], ph.sym.size(), lb, overlap[lane[l]]));
+        }
+    }
+
+    // exact scores in phrase order, like best_match(): the first strictly higher score wins
+    double best_score = 0.0;
+    int32_t best = -1;
+    for (int32_t p : s->candidates)
+    {
+        if (bound[p] < threshold)
+            continue;
+        out->lcs_pass++;
+        if (bound[p] <= best_score)
+            continue;
+        out->scored++;
+        double score = score_of(matching_chars(s, f->phrases[p].sym), f->phrases[p].sym.size(), lb, overlap[p]);
+        if (score > best_score)
+        {
+            best_score = score;
+            best = p;
+        }
+    }
+    out->score = best_score;
+    out->phrase = best_score >= threshold ? best : -1;
+}
@@ -0,0 +1,50 @@
+/* phrase_fuzzy.h - main.py's best_match() in C++: same phrase, same score, most phrases ruled out by bounds
+ *
+ * best_match() scores every phrase as 0.7 * SequenceMatcher(None, phrase,
+ * text).ratio() + 0.3 * the share of the phrase's words in the text, and
+ * keeps the first highest. ratio() is 2 * M / (len phrase + len text), with
+ * M the characters in difflib's matching blocks. Here a phrase is only
+ * scored that way if two cheaper upper bounds on M still let it beat both
+ * the threshold and the best score so far:
+ *   1. character-count signature: M <= sum over characters of min(count in phrase, count in text)
+ *   2. bit-parallel LCS (Hyyro), PHRASE_FUZZY_LANES phrases per vector op:
+ *      matching blocks form a common subsequence, so M <= LCS
+ * The exact score is difflib's Ratcliff-Obershelp, autojunk included, in the
+ * same floating-point steps, so accepted phrases and their scores are
+ * identical to best_match(). Phrases and text arrive already normalized by
+ * normalize_text(), as UTF-8; they are compared by code point.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PHRASE_FUZZY_LANES 4 // phrases per LCS step; GCC vector extensions pick the target's SIMD
+#define PHRASE_FUZZY_LCS_MAX 64 // longer phrases skip the LCS bound
+
+typedef struct phrase_fuzzy phrase_fuzzy_t;
+
+typedef struct
+{
+    int32_t phrase;          // best phrase scoring at least the threshold, -1 if none
+    double score;            // its score; without one, the best score among phrases that passed the bounds
+    uint32_t signature_pass; // phrases the character-count bound left
+    uint32_t lcs_pass;       // of those, phrases the LCS bound left
+    uint32_t scored;         // exact Ratcliff-Obershelp runs
+} phrase_fuzzy_result_t;
+
+phrase_fuzzy_t *phrase_fuzzy_create(const char *const *phrases, size_t count);
+void phrase_fuzzy_destroy(phrase_fuzzy_t *f);
+
+/* With threshold 0 no phrase is ruled out and the result is best_match()'s
+ * (phrase -1 where it returns None). Safe from several threads at once. */
+void phrase_fuzzy_best(const phrase_fuzzy_t *f, const char *text, size_t len, double threshold,
+                       phrase_fuzzy_result_t *out);
+
+#ifdef __cplusplus
+}
+#endif
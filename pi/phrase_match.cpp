@@ -0,0 +1,377 @@
+/* phrase_match.cpp - token-level Aho-Corasick matcher for transcripts */
+#include <ctype.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "phrase_match.h"
+
+struct phrase_matcher
+{
+    std::unordered_map<std::string, int32_t> vocab; // normalized phrase token -> id
+    std::unordered_map<uint64_t, int32_t> edges;    // state << 32 | token id -> next state
+    std::vector<int32_t> fail;                      // longest proper suffix that is also a state
+    std::vector<int32_t> out;                       // phrase ending at this state, -1 if none
+    std::vector<int32_t> dict;                      // nearest state on the fail chain with an output, -1 if none
+    std::vector<uint32_t> depth;                    // tokens from the root
+    std::vector<int32_t> same;                      // per phrase: next phrase with the same tokens, -1
+    std::vector<uint8_t> extends;                   // a longer phrase continues from this state
+    uint32_t max_depth;
+};
+
+/* Next normalized token of text from *pos; false at the end. begin/end are its byte span. */
+static bool next_token(const char *text, size_t len, size_t *pos, std::string *tok, uint32_t *begin, uint32_t *end)
+{
+    size_t i = *pos;
+    while (i < len)
+    {
+        while (i < len && isspace((unsigned char)text[i]))
+            i++;
+        size_t start = i;
+        tok->clear();
+        for (; i < len && !isspace((unsigned char)text[i]); ++i)
+        {
+            unsigned char c = (unsigned char)text[i];
+            if (c < 0x80 && ispunct(c))
+                continue;
+            tok->push_back((char)(c < 0x80 ? tolower(c) : c));
+        }
+        if (!tok->empty())
+        {
+            *pos = i;
+            *begin = (uint32_t)start;
+            *end = (uint32_t)i;
+            return true;
+        }
+    }
+    *pos = i;
+    return false;
+}
+
+static int32_t edge(const phrase_matcher_t *m, int32_t state, int32_t token)
+{
+    auto it = m->edges.find((uint64_t)state << 32 | (uint32_t)token);
+    return it == m->edges.end() ? -1 : it->second;
+}
+
+phrase_matcher_t *phrase_matcher_create(const char *const *phrases, size_t count)
+{
+    phrase_matcher_t *m = new (std::nothrow) phrase_matcher_t();
+    if (!m)
+        return NULL;
+    try
+    {
+        m->fail.push_back(0);
+        m->out.push_back(-1);
+        m->depth.push_back(0);
+        m->same.assign(count, -1);
+        m->max_depth = 0;
+        std::vector<std::vector<std::pair<int32_t, int32_t>>> children(1);
+        std::string tok;
+        for (size_t p = 0; p < count; ++p)
+        {
+            size_t pos = 0, len = strlen(phrases[p]);
+            uint32_t b, e;
+            int32_t state = 0;
+            while (next_token(phrases[p], len, &pos, &tok, &b, &e))
+            {
+                int32_t id = m->vocab.emplace(tok, (int32_t)m->vocab.size()).first->second;
+                int32_t next = edge(m, state, id);
+                if (next < 0)
+                {
+                    next = (int32_t)m->out.size();
+                    m->edges[(uint64_t)state << 32 | (uint32_t)id] = next;
+                    children[state].push_back({id, next});
+                    children.emplace_back();
+                    m->fail.push_back(0);
+                    m->out.push_back(-1);
+                    m->depth.push_back(m->depth[state] + 1);
+                }
+                state = next;
+            }
+            if (state == 0)
+                continue;
+            m->same[p] = m->out[state];
+            m->out[state] = (int32_t)p;
+            m->max_depth = std::max(m->max_depth, m->depth[state]);
+        }
+
+        // failure and output links breadth first, so a state's fail target is always done before it
+        m->dict.assign(m->out.size(), -1);
+        m->extends.resize(m->out.size());
+        for (size_t i = 0; i < children.size(); ++i)
+            m->extends[i] = !children[i].empty();
+        std::vector<int32_t> queue;
+        for (auto &c : children[0])
+            queue.push_back(c.second);
+        for (size_t q = 0; q < queue.size(); ++q)
+        {
+            int32_t s = queue[q];
+            for (auto &c : children[s])
+            {
+                int32_t f = m->fail[s];
+                while (f && edge(m, f, c.first) < 0)
+                    f = m->fail[f];
+                int32_t to = edge(m, f, c.first);
+                m->fail[c.second] = to >= 0 ? to : 0;
+                queue.push_back(c.second);
+            }
+            int32_t f = m->fail[s];
+            m->dict[s] = m->out[f] >= 0 ? f : m->dict[f];
+        }
+    }
+    catch (const std::bad_alloc &)
+    {
+        delete m;
+        return NULL;
+    }
+    return m;
+}
+
+void phrase_matcher_destroy(phrase_matcher_t *m)
+{
+    delete m;
+}
+
+size_t phrase_matcher_states(const phrase_matcher_t *m)
+{
+    return m->out.size();
+}
+
+typedef struct
+{
+    phrase_hit_t hit;
+    uint32_t last; // last token
+} candidate_t;
+
+/* the automaton's step for one token id (-1: a word no phrase has) */
+static int32_t step(const phrase_matcher_t *m, int32_t state, int32_t id)
+{
+    if (id < 0)
+        return 0; // a word no phrase has ends every partial match
+    int32_t next;
+    while ((next = edge(m, state, id)) < 0 && state)
+        state = m->fail[state];
+    return next < 0 ? 0 : next;
+}
+
+size_t phrase_matcher_find(const phrase_matcher_t *m, const char *text, size_t len, int mode, phrase_hit_t *hits,
+                           size_t max)
+{
+    // byte offsets of the last max_depth tokens, for where a hit begins
+    std::vector<uint32_t> starts(m->max_depth ? m->max_depth : 1);
+    std::vector<candidate_t> found;
+    std::string tok;
+    size_t pos = 0, count = 0;
+    uint32_t b, e, n = 0;
+    int32_t state = 0;
+    for (; next_token(text, len, &pos, &tok, &b, &e); ++n)
+    {
+        starts[n % starts.size()] = b;
+        auto id = m->vocab.find(tok);
+        state = step(m, state, id == m->vocab.end() ? -1 : id->second);
+        for (int32_t s = m->out[state] >= 0 ? state : m->dict[state]; s >= 0; s = m->dict[s])
+        {
+            uint32_t first = n + 1 - m->depth[s];
+            for (int32_t p = m->out[s]; p >= 0; p = m->same[p])
+            {
+                candidate_t c = {{p, first, starts[first % starts.size()], e}, n};
+                if (mode == PHRASE_MATCH_LONGEST)
+                    found.push_back(c);
+                else if (count++ < max)
+                    hits[count - 1] = c.hit;
+            }
+        }
+    }
+    if (mode != PHRASE_MATCH_LONGEST)
+        return count;
+
+    std::stable_sort(found.begin(), found.end(), [](const candidate_t &a, const candidate_t &b) {
+        return a.hit.token != b.hit.token ? a.hit.token < b.hit.token : a.last > b.last;
+    });
+    uint32_t free_from = 0;
+    const candidate_t *taken = NULL;
+    for (const candidate_t &c : found)
+    {
+        // phrases that normalize alike cover the same span and are all kept
+        bool alike = taken && taken->hit.token == c.hit.token && taken->last == c.last;
+        if (c.hit.token < free_from && !alike)
+            continue;
+        if (count++ < max)
+            hits[count - 1] = c.hit;
+        taken = &c;
+        free_from = c.last + 1;
+    }
+    return count;
+}
+
+/* ---- streaming ---- */
+
+typedef struct
+{
+    candidate_t c;
+    bool reported;
+} stream_hit_t;
+
+struct phrase_stream
+{
+    const phrase_matcher_t *m;
+    uint32_t stable_updates;
+    uint32_t update;                                     // hypotheses seen in this utterance
+    std::string text;                                    // the last one
+    std::vector<int32_t> ids;                            // its tokens, -1 for words no phrase has
+    std::vector<uint32_t> begin, end;                    // their byte spans
+    std::vector<int32_t> state;                          // automaton state after each token
+    std::vector<uint32_t> since;                         // update since which tokens 0..i are unchanged
+    std::vector<stream_hit_t> hits;                      // every occurrence in the last hypothesis
+    std::vector<std::pair<int32_t, uint32_t>> reported;  // (phrase, first token) reported in this utterance
+    std::string tok;
+    uint64_t scanned;
+};
+
+phrase_stream_t *phrase_stream_create(const phrase_matcher_t *m, uint32_t stable_updates)
+{
+    phrase_stream_t *s = new (std::nothrow) phrase_stream_t();
+    if (!s)
+        return NULL;
+    s->m = m;
+    s->stable_updates = stable_updates ? stable_updates : 1;
+    s->scanned = 0;
+    phrase_stream_reset(s);
+    return s;
+}
+
+void phrase_stream_destroy(phrase_stream_t *s)
+{
+    delete s;
+}
+
+void phrase_stream_reset(phrase_stream_t *s)
+{
+    s->update = 0;
+    s->text.clear();
+    s->ids.clear();
+    s->begin.clear();
+    s->end.clear();
+    s->state.clear();
+    s->since.clear();
+    s->hits.clear();
+    s->reported.clear();
+}
+
+uint64_t phrase_stream_scanned(const phrase_stream_t *s)
+{
+    return s->scanned;
+}
+
+/* another occurrence in the hypothesis spans more words and contains h */
+static bool covered(const phrase_stream_t *s, const candidate_t &h)
+{
+    for (const stream_hit_t &o : s->hits)
+    {
+        if (o.c.hit.token <= h.hit.token && o.c.last >= h.last &&
+            o.c.last - o.c.hit.token > h.last - h.hit.token)
+            return true;
+    }
+    return false;
+}
+
+/* h is in the held words, and no partial match in progress at their end reaches back to its
+ * first word, so no longer occurrence can still cover it */
+static bool settled(const phrase_stream_t *s, const candidate_t &h, size_t held, int32_t at)
+{
+    const phrase_matcher_t *m = s->m;
+    if (h.last >= held)
+        return false;
+    for (; at && m->depth[at] >= held - h.hit.token; at = m->fail[at])
+    {
+        if (m->extends[at])
+            return false;
+    }
+    return true;
+}
+
+size_t phrase_stream_update(phrase_stream_t *s, const char *text, size_t len, int final, phrase_hit_t *hits,
+                            size_t max)
+{
+    const phrase_matcher_t *m = s->m;
+    try
+    {
+        // words before the first changed byte are unchanged, with their states and occurrences;
+        // one ending right at it only if it is still followed by a space or the end, not a longer word
+        size_t same = 0;
+        while (same < len && same < s->text.size() && text[same] == s->text[same])
+            same++;
+        bool closed = same == len || isspace((unsigned char)text[same]);
+        size_t keep = s->ids.size();
+        while (keep && (s->end[keep - 1] > same || (s->end[keep - 1] == same && !closed)))
+            keep--;
+        s->update++;
+        s->ids.resize(keep);
+        s->begin.resize(keep);
+        s->end.resize(keep);
+        s->state.resize(keep);
+        s->since.resize(keep);
+        s->hits.erase(std::remove_if(s->hits.begin(), s->hits.end(),
+                                     [keep](const stream_hit_t &h) { return h.c.last >= keep; }),
+                      s->hits.end());
+        s->text.assign(text, len);
+
+        // the revised tail through the automaton
+        size_t pos = keep ? s->end[keep - 1] : 0;
+        int32_t state = keep ? s->state[keep - 1] : 0;
+        uint32_t b, e;
+        while (next_token(text, len, &pos, &s->tok, &b, &e))
+        {
+            auto id = m->vocab.find(s->tok);
+            uint32_t n = (uint32_t)s->ids.size();
+            s->ids.push_back(id == m->vocab.end() ? -1 : id->second);
+            s->begin.push_back(b);
+            s->end.push_back(e);
+            state = step(m, state, s->ids.back());
+            s->state.push_back(state);
+            s->since.push_back(s->update);
+            s->scanned++;
+            for (int32_t st = m->out[state] >= 0 ? state : m->dict[state]; st >= 0; st = m->dict[st])
+            {
+                uint32_t first = n + 1 - m->depth[st];
+                for (int32_t p = m->out[st]; p >= 0; p = m->same[p])
+                {
+                    bool reported = std::find(s->reported.begin(), s->reported.end(),
+                                              std::make_pair(p, first)) != s->reported.end();
+                    s->hits.push_back({{{p, first, s->begin[first], e}, n}, reported});
+                }
+            }
+        }
+    }
+    catch (const std::bad_alloc &)
+    {
+        return 0;
+    }
+
+    // report the stable ones in text order
+    std::stable_sort(s->hits.begin(), s->hits.end(), [](const stream_hit_t &a, const stream_hit_t &b) {
+        return a.c.hit.token != b.c.hit.token ? a.c.hit.token < b.c.hit.token : a.c.last > b.c.last;
+    });
+    // words up to `held` have not changed for stable_updates hypotheses
+    size_t held = s->ids.size();
+    while (held && s->update - s->since[held - 1] + 1 < s->stable_updates)
+        held--;
+    int32_t at = held ? s->state[held - 1] : 0;
+    size_t count = 0;
+    for (stream_hit_t &h : s->hits)
+    {
+        if (h.reported || count == max)
+            continue;
+        if (!final && !settled(s, h.c, held, at))
+            continue;
+        if (covered(s, h.c))
+            continue;
+        hits[count++] = h.c.hit;
+        h.reported = true;
+        s->reported.push_back({h.c.hit.phrase, h.c.hit.token});
+    }
+    return count;
+}
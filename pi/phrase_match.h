@@ -0,0 +1,74 @@
+/* phrase_match.h - token-level Aho-Corasick matcher: every phrase occurrence in a transcript in one pass
+ *
+ * Phrases and text are tokenized the way main.py's normalize_text() does it:
+ * ASCII letters lowercased, ASCII punctuation dropped, split on whitespace
+ * (non-ASCII bytes are kept as they are). The phrase list is compiled once
+ * into an automaton over token ids, so matching costs one step per
+ * transcript token however many phrases there are. Plain C API so
+ * phrase_match.py can load libphrase_match.so with ctypes.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct phrase_matcher phrase_matcher_t;
+
+typedef struct
+{
+    int32_t phrase; // index into the list given to phrase_matcher_create()
+    uint32_t token; // first token of the occurrence
+    uint32_t begin; // byte offsets of the occurrence in the text
+    uint32_t end;
+} phrase_hit_t;
+
+#define PHRASE_MATCH_ALL 0     // every occurrence, overlapping ones too, ordered by where they end
+#define PHRASE_MATCH_LONGEST 1 // leftmost-longest, no overlaps: "bank account" hides "bank" and "account"
+
+/* NULL on allocation failure. Phrases with no tokens left after normalizing never match;
+ * phrases that normalize alike are all reported. */
+phrase_matcher_t *phrase_matcher_create(const char *const *phrases, size_t count);
+void phrase_matcher_destroy(phrase_matcher_t *m);
+
+/* Writes up to max hits and returns how many there are; safe from several threads at once. */
+size_t phrase_matcher_find(const phrase_matcher_t *m, const char *text, size_t len, int mode, phrase_hit_t *hits,
+                           size_t max);
+
+/* automaton states, root included */
+size_t phrase_matcher_states(const phrase_matcher_t *m);
+
+/* ---- streaming: the recognizer's growing hypothesis for one utterance ----
+ *
+ * Each update is the whole current hypothesis (a Vosk partial, then the
+ * final). Words before the first changed byte keep their automaton states,
+ * so an update only scans the revised tail. An occurrence is reported once,
+ * as soon as it is stable: the words up to its end were unchanged for
+ * `stable_updates` hypotheses in a row, and no partial match in progress at
+ * the end of those words reaches back to its start, so no longer phrase can
+ * still grow around it. The final hypothesis reports the rest. Occurrences
+ * inside a longer one are not reported.
+ */
+typedef struct phrase_stream phrase_stream_t;
+
+/* m must outlive the stream; stable_updates 0 counts as 1 */
+phrase_stream_t *phrase_stream_create(const phrase_matcher_t *m, uint32_t stable_updates);
+void phrase_stream_destroy(phrase_stream_t *s);
+/* forget the utterance; the next update starts a new one */
+void phrase_stream_reset(phrase_stream_t *s);
+
+/* Writes up to max newly stable occurrences (offsets into this text, in text
+ * order) and returns how many it wrote; any more are written by the next
+ * call, which may repeat the same text. One thread per stream. */
+size_t phrase_stream_update(phrase_stream_t *s, const char *text, size_t len, int final, phrase_hit_t *hits,
+                            size_t max);
+
+/* words run through the automaton since the stream was created */
+uint64_t phrase_stream_scanned(const phrase_stream_t *s);
+
+#ifdef __cplusplus
+}
+#endif
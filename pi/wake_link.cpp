@@ -0,0 +1,181 @@
+/* wake_link.cpp - reads the ESP32's event link from a serial port and prints one JSON line per frame
+ *
+ *   wake_link [--baud N] DEVICE     e.g. wake_link /dev/serial0
+ *   wake_link - < capture.bin       decode a raw byte capture (wake_sim --link)
+ *   wake_link --shutdown-after 30 /dev/serial0
+ *                                   also run --shutdown-cmd (default "sudo /sbin/shutdown -h now")
+ *                                   once the ESP32 reports that many seconds of silence, then exit
+ *
+ * stdout is line-buffered JSON for main.py and shutdown.py; decoder counters
+ * go to stderr at EOF or on SIGINT/SIGTERM.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "link_decoder.h"
+#include "phrase_table.h"
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig)
+{
+    stop = 1;
+}
+
+static speed_t baud_constant(int baud)
+{
+    switch (baud)
+    {
+    case 115200:
+        return B115200;
+    case 230400:
+        return B230400;
+    case 460800:
+        return B460800;
+    case 921600:
+        return B921600;
+    case 1000000:
+        return B1000000;
+    case 1500000:
+        return B1500000;
+    case 2000000:
+        return B2000000;
+    default:
+        return B0;
+    }
+}
+
+/* raw 8N1, no flow control, blocking reads of whatever has arrived */
+static bool serial_raw(int fd, int baud)
+{
+    struct termios t;
+    if (tcgetattr(fd, &t) != 0)
+        return false;
+    cfmakeraw(&t);
+    t.c_cflag |= CLOCAL | CREAD;
+    t.c_cflag &= ~(CSTOPB | CRTSCTS);
+    t.c_cc[VMIN] = 1;
+    t.c_cc[VTIME] = 0;
+    speed_t speed = baud_constant(baud);
+    if (speed == B0)
+        return false;
+    cfsetispeed(&t, speed);
+    cfsetospeed(&t, speed);
+    return tcsetattr(fd, TCSANOW, &t) == 0;
+}
+
+typedef struct
+{
+    unsigned shutdown_after_s; // 0 = never
+    const char *shutdown_cmd;
+    bool warned_table; // firmware built from another phrase manifest
+} link_opts_t;
+
+static void print_frame(const link_frame_t *f, void *ctx)
+{
+    link_opts_t *o = (link_opts_t *)ctx;
+    char line[256];
+    link_frame_json(f, line, sizeof(line));
+    puts(line);
+    fflush(stdout);
+
+    link_hello_t h;
+    if (f->type == LINK_HELLO && f->len >= sizeof(h) && !o->warned_table)
+    {
+        memcpy(&h, f->payload, sizeof(h));
+        if (h.phrase_table != PHRASE_TABLE_HASH)
+        {
+            fprintf(stderr, "wake_link: firmware phrase table 0x%08x, ours 0x%08x (phrase_manifest.csv v%d): "
+                            "categories and severities may be misnamed; rebuild both from the same manifest\n",
+                    (unsigned)h.phrase_table, (unsigned)PHRASE_TABLE_HASH, PHRASE_TABLE_VERSION);
+            o->warned_table = true;
+        }
+    }
+
+    link_silence_t l;
+    if (!o->shutdown_after_s || f->type != LINK_SILENCE || f->len < sizeof(l) || stop)
+        return;
+    memcpy(&l, f->payload, sizeof(l));
+    if (l.silent_s < o->shutdown_after_s)
+        return;
+    fprintf(stderr, "wake_link: silence for %us, running: %s\n", (unsigned)l.silent_s, o->shutdown_cmd);
+    int rc = system(o->shutdown_cmd);
+    if (rc != 0)
+        fprintf(stderr, "wake_link: shutdown command returned %d\n", rc);
+    stop = 1;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: wake_link [--baud N] [--shutdown-after SEC] [--shutdown-cmd CMD] DEVICE|-\n");
+}
+
+int main(int argc, char **argv)
+{
+    int baud = 921600;
+    const char *path = NULL;
+    link_opts_t opts = {0, "sudo /sbin/shutdown -h now", false};
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--baud") == 0 && i + 1 < argc)
+            baud = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--shutdown-after") == 0 && i + 1 < argc)
+            opts.shutdown_after_s = (unsigned)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--shutdown-cmd") == 0 && i + 1 < argc)
+            opts.shutdown_cmd = argv[++i];
+        else if (!path)
+            path = argv[i];
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (!path)
+    {
+        usage();
+        return 2;
+    }
+
+    int fd = 0;
+    if (strcmp(path, "-") != 0)
+    {
+        fd = open(path, O_RDONLY | O_NOCTTY);
+        if (fd < 0)
+        {
+            fprintf(stderr, "wake_link: cannot open %s: %s\n", path, strerror(errno));
+            return 1;
+        }
+        if (isatty(fd) && !serial_raw(fd, baud))
+        {
+            fprintf(stderr, "wake_link: cannot set %s to raw %d baud\n", path, baud);
+            return 1;
+        }
+    }
+
+    struct sigaction sa = {};
+    sa.sa_handler = on_signal; // no SA_RESTART: a signal ends the blocking read
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    link_decoder_t dec;
+    link_decoder_init(&dec);
+    uint8_t buf[512];
+    while (!stop)
+    {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        link_decoder_push(&dec, buf, (size_t)n, print_frame, &opts);
+    }
+    fprintf(stderr, "wake_link: frames=%u crc_errors=%u lost=%u skipped_bytes=%u\n", (unsigned)dec.frames,
+            (unsigned)dec.crc_errors, (unsigned)dec.lost, (unsigned)dec.skipped);
+    return 0;
+}
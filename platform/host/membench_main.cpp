@@ -0,0 +1,123 @@
+/* membench_main.cpp - runs the portable membench core on Linux
+ *
+ * Two first-fit pools sized like the ESP32-S3's internal SRAM and an 8 MB
+ * PSRAM stand in for the board's heaps, so the fragmentation numbers come
+ * from an allocator of the same shape; bandwidth and latency are the host's.
+ *
+ *   membench [--repeats N]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "membench.h"
+
+#define POOL_ALIGN MEMBENCH_LINE // block header size; keeps every payload line-aligned
+
+struct pool {
+  uint8_t *mem;
+  size_t size;
+};
+
+struct block {
+  size_t size; // header included
+  size_t used;
+};
+
+static pool small_pool, large_pool;
+
+static void pool_init(pool *p, size_t size) {
+  p->mem = (uint8_t *)aligned_alloc(POOL_ALIGN, size);
+  p->size = size;
+  block *b = (block *)p->mem;
+  b->size = size;
+  b->used = 0;
+}
+
+static void *pool_alloc(pool *p, size_t bytes) {
+  size_t need = (bytes + POOL_ALIGN - 1) / POOL_ALIGN * POOL_ALIGN + POOL_ALIGN;
+  for (size_t off = 0; off < p->size;) {
+    block *b = (block *)(p->mem + off);
+    if (!b->used && b->size >= need) {
+      if (b->size - need >= 2 * POOL_ALIGN) {
+        block *rest = (block *)(p->mem + off + need);
+        rest->size = b->size - need;
+        rest->used = 0;
+        b->size = need;
+      }
+      b->used = 1;
+      return (uint8_t *)b + POOL_ALIGN;
+    }
+    off += b->size;
+  }
+  return NULL;
+}
+
+static void pool_free(pool *p, void *ptr) {
+  ((block *)((uint8_t *)ptr - POOL_ALIGN))->used = 0;
+  for (size_t off = 0; off < p->size;) {
+    block *b = (block *)(p->mem + off);
+    block *next = off + b->size < p->size ? (block *)(p->mem + off + b->size) : NULL;
+    if (!b->used && next && !next->used)
+      b->size += next->size; // coalesce, then look at the new neighbour
+    else
+      off += b->size;
+  }
+}
+
+static void pool_stats(const pool *p, size_t *free_bytes, size_t *largest) {
+  *free_bytes = *largest = 0;
+  for (size_t off = 0; off < p->size;) {
+    const block *b = (const block *)(p->mem + off);
+    if (!b->used) {
+      *free_bytes += b->size - POOL_ALIGN;
+      *largest = b->size - POOL_ALIGN > *largest ? b->size - POOL_ALIGN : *largest;
+    }
+    off += b->size;
+  }
+}
+
+static void *small_alloc(size_t bytes) { return pool_alloc(&small_pool, bytes); }
+static void small_release(void *p) { pool_free(&small_pool, p); }
+static size_t small_free() { size_t f, l; pool_stats(&small_pool, &f, &l); return f; }
+static size_t small_largest() { size_t f, l; pool_stats(&small_pool, &f, &l); return l; }
+
+static void *large_alloc(size_t bytes) { return pool_alloc(&large_pool, bytes); }
+static void large_release(void *p) { pool_free(&large_pool, p); }
+static size_t large_free() { size_t f, l; pool_stats(&large_pool, &f, &l); return f; }
+static size_t large_largest() { size_t f, l; pool_stats(&large_pool, &f, &l); return l; }
+
+static uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void emit(const char *line) { puts(line); }
+
+int main(int argc, char **argv) {
+  int repeats = 5;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+      repeats = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: membench [--repeats N]\n");
+      return 2;
+    }
+  }
+  if (repeats < 1)
+    repeats = 1;
+
+  pool_init(&small_pool, 320 * 1024);
+  pool_init(&large_pool, 8 * 1024 * 1024);
+  const membench_region regions[] = {
+      {"host_sram", small_alloc, small_release, small_free, small_largest, 64 * 1024},
+      {"host_psram", large_alloc, large_release, large_free, large_largest, 1024 * 1024},
+  };
+  const membench_env env = {now_ns, emit, repeats};
+
+  printf("membench test=info host=1 psram_fix=%d\n", MEMBENCH_PSRAM_FIX);
+  membench_run_all(&env, regions, 2);
+  puts("membench test=done");
+  free(small_pool.mem);
+  free(large_pool.mem);
+  return 0;
+}
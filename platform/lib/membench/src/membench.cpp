@@ -0,0 +1,261 @@
+/* membench.cpp - portable memory benchmark core; see membench.h */
+#include "membench.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__XTENSA__)
+#define MEMBENCH_STORE_FENCE() __asm__ __volatile__("memw" ::: "memory")
+#else
+#define MEMBENCH_STORE_FENCE() __asm__ __volatile__("" ::: "memory") // no memw off Xtensa: compiler barrier only
+#endif
+
+#define CHURN_SLOTS 256
+#define CHURN_OPS 8192
+#define CACHE_RESIDENT_BYTES (16 * 1024)
+
+static volatile uint32_t sink;
+
+static void emit(const membench_env *env, const char *fmt, ...) {
+  char line[224];
+  int n = snprintf(line, sizeof(line), "membench ");
+  va_list ap;
+  va_start(ap, fmt);
+  n += vsnprintf(line + n, sizeof(line) - n, fmt, ap);
+  va_end(ap);
+  snprintf(line + n, sizeof(line) - n, " psram_fix=%d", MEMBENCH_PSRAM_FIX);
+  env->emit(line);
+}
+
+static uint32_t xorshift(uint32_t *s) {
+  uint32_t x = *s;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *s = x;
+}
+
+static double mbps(size_t bytes, uint64_t ns) {
+  return ns ? (double)bytes * 1000.0 / (double)ns : 0.0;
+}
+
+typedef void (*kernel_fn)(uint32_t *p, size_t words);
+
+__attribute__((noinline)) static void seq_read(uint32_t *p, size_t words) {
+  uint32_t sum = 0;
+  for (size_t i = 0; i < words; ++i)
+    sum += p[i];
+  sink = sum;
+}
+
+__attribute__((noinline)) static void seq_write(uint32_t *p, size_t words) {
+  for (size_t i = 0; i < words; ++i)
+    p[i] = (uint32_t)i;
+  __asm__ __volatile__("" ::: "memory");
+}
+
+__attribute__((noinline)) static void seq_write_fenced(uint32_t *p, size_t words) {
+  for (size_t i = 0; i < words; ++i) {
+    p[i] = (uint32_t)i;
+    MEMBENCH_STORE_FENCE();
+  }
+}
+
+// random kernels include one xorshift per access; seq_* over the same words is the reference
+__attribute__((noinline)) static void rand_read(uint32_t *p, size_t words) {
+  uint32_t s = 2463534242u, sum = 0, mask = (uint32_t)words - 1;
+  for (size_t i = 0; i < words; ++i)
+    sum += p[xorshift(&s) & mask];
+  sink = sum;
+}
+
+__attribute__((noinline)) static void rand_write(uint32_t *p, size_t words) {
+  uint32_t s = 2463534242u, mask = (uint32_t)words - 1;
+  for (size_t i = 0; i < words; ++i) {
+    uint32_t x = xorshift(&s);
+    p[x & mask] = x;
+  }
+  __asm__ __volatile__("" ::: "memory");
+}
+
+static uint64_t best_of(const membench_env *env, kernel_fn fn, uint32_t *p, size_t words) {
+  uint64_t best = UINT64_MAX;
+  fn(p, words); // warm-up: first touch and cache fill
+  for (int r = 0; r < env->repeats; ++r) {
+    uint64_t t0 = env->now_ns();
+    fn(p, words);
+    uint64_t dt = env->now_ns() - t0;
+    best = dt < best ? dt : best;
+  }
+  return best;
+}
+
+void membench_bandwidth(const membench_env *env, const membench_region *r) {
+  uint32_t *p = (uint32_t *)r->alloc(r->bench_bytes);
+  if (!p) {
+    emit(env, "test=bandwidth region=%s bytes=%u error=alloc", r->name, (unsigned)r->bench_bytes);
+    return;
+  }
+  static const struct {
+    const char *name;
+    kernel_fn fn;
+  } kernels[] = {
+      {"seq_read", seq_read},
+      {"seq_write", seq_write},
+      {"rand_read", rand_read},
+      {"rand_write", rand_write},
+  };
+  size_t words = r->bench_bytes / sizeof(uint32_t);
+  for (const auto &k : kernels) {
+    uint64_t ns = best_of(env, k.fn, p, words);
+    emit(env, "test=%s region=%s bytes=%u mbps=%.1f", k.name, r->name, (unsigned)r->bench_bytes, mbps(r->bench_bytes, ns));
+  }
+  r->release(p);
+}
+
+void membench_latency(const membench_env *env, const membench_region *r, size_t bytes) {
+  uint8_t *base = (uint8_t *)r->alloc(bytes);
+  if (!base) {
+    emit(env, "test=latency region=%s bytes=%u error=alloc", r->name, (unsigned)bytes);
+    return;
+  }
+  // Sattolo's shuffle of line indices gives a single cycle through every line,
+  // then each line's first word becomes a pointer to its successor
+  size_t lines = bytes / MEMBENCH_LINE;
+  for (size_t i = 0; i < lines; ++i)
+    *(size_t *)(base + i * MEMBENCH_LINE) = i;
+  uint32_t s = 88172645u;
+  for (size_t i = lines - 1; i > 0; --i) {
+    size_t j = xorshift(&s) % i;
+    size_t *a = (size_t *)(base + i * MEMBENCH_LINE);
+    size_t *b = (size_t *)(base + j * MEMBENCH_LINE);
+    size_t t = *a;
+    *a = *b;
+    *b = t;
+  }
+  for (size_t i = 0; i < lines; ++i) {
+    size_t next = *(size_t *)(base + i * MEMBENCH_LINE);
+    *(void **)(base + i * MEMBENCH_LINE) = base + next * MEMBENCH_LINE;
+  }
+
+  uint64_t best = UINT64_MAX;
+  void *p = base;
+  for (int rep = 0; rep <= env->repeats; ++rep) {
+    uint64_t t0 = env->now_ns();
+    for (size_t i = 0; i < lines; ++i)
+      p = *(void *volatile *)p;
+    uint64_t dt = env->now_ns() - t0;
+    if (rep > 0) // first pass warms the cache
+      best = dt < best ? dt : best;
+  }
+  sink = (uint32_t)(uintptr_t)p;
+  emit(env, "test=latency region=%s bytes=%u stride=%d ns_per_load=%.2f", r->name, (unsigned)bytes, MEMBENCH_LINE,
+       (double)best / (double)lines);
+  r->release(base);
+}
+
+void membench_memcpy(const membench_env *env, const membench_region *src, const membench_region *dst) {
+  size_t bytes = src->bench_bytes < dst->bench_bytes ? src->bench_bytes : dst->bench_bytes;
+  void *a = src->alloc(bytes);
+  void *b = dst->alloc(bytes);
+  if (!a || !b) {
+    emit(env, "test=memcpy src=%s dst=%s bytes=%u error=alloc", src->name, dst->name, (unsigned)bytes);
+  } else {
+    memset(a, 0x5a, bytes);
+    uint64_t best = UINT64_MAX;
+    for (int rep = 0; rep <= env->repeats; ++rep) {
+      uint64_t t0 = env->now_ns();
+      memcpy(b, a, bytes);
+      __asm__ __volatile__("" ::: "memory");
+      uint64_t dt = env->now_ns() - t0;
+      if (rep > 0)
+        best = dt < best ? dt : best;
+    }
+    emit(env, "test=memcpy src=%s dst=%s bytes=%u mbps=%.1f", src->name, dst->name, (unsigned)bytes, mbps(bytes, best));
+  }
+  if (a)
+    src->release(a);
+  if (b)
+    dst->release(b);
+}
+
+void membench_store_fence(const membench_env *env, const membench_region *r) {
+  uint32_t *p = (uint32_t *)r->alloc(r->bench_bytes);
+  if (!p) {
+    emit(env, "test=store_fence region=%s bytes=%u error=alloc", r->name, (unsigned)r->bench_bytes);
+    return;
+  }
+  size_t words = r->bench_bytes / sizeof(uint32_t);
+  uint64_t plain = best_of(env, seq_write, p, words);
+  uint64_t fenced = best_of(env, seq_write_fenced, p, words);
+  emit(env, "test=store_fence region=%s bytes=%u plain_mbps=%.1f fenced_mbps=%.1f overhead_pct=%.1f", r->name,
+       (unsigned)r->bench_bytes, mbps(r->bench_bytes, plain), mbps(r->bench_bytes, fenced),
+       plain ? 100.0 * ((double)fenced - (double)plain) / (double)plain : 0.0);
+  r->release(p);
+}
+
+static double frag_pct(size_t free_bytes, size_t largest) {
+  return free_bytes ? 100.0 * (1.0 - (double)largest / (double)free_bytes) : 0.0;
+}
+
+void membench_fragmentation(const membench_env *env, const membench_region *r) {
+  if (!r->free_bytes || !r->largest_free)
+    return;
+  void *slot[CHURN_SLOTS] = {};
+  size_t size[CHURN_SLOTS] = {};
+  size_t free_before = r->free_bytes(), largest_before = r->largest_free();
+  uint32_t s = 521288629u;
+  int failed = 0;
+
+  // sizes spread log-uniformly from 16 B to 32 KB, like a mix of queues, buffers and model tensors
+  for (int op = 0; op < CHURN_OPS; ++op) {
+    uint32_t x = xorshift(&s);
+    int i = x % CHURN_SLOTS;
+    if (slot[i]) {
+      r->release(slot[i]);
+      slot[i] = NULL;
+      size[i] = 0;
+      continue;
+    }
+    size_t base = (size_t)16 << ((x >> 8) % 11);
+    size_t bytes = base + (x >> 16) % base;
+    slot[i] = r->alloc(bytes);
+    size[i] = slot[i] ? bytes : 0;
+    failed += slot[i] == NULL;
+  }
+
+  int live = 0;
+  size_t live_bytes = 0;
+  for (int i = 0; i < CHURN_SLOTS; ++i) {
+    live += slot[i] != NULL;
+    live_bytes += size[i];
+  }
+  size_t free_live = r->free_bytes(), largest_live = r->largest_free();
+  emit(env, "test=fragmentation region=%s ops=%d failed=%d live=%d live_bytes=%u free=%u largest=%u frag_pct=%.1f", r->name,
+       CHURN_OPS, failed, live, (unsigned)live_bytes, (unsigned)free_live, (unsigned)largest_live, frag_pct(free_live, largest_live));
+
+  for (int i = 0; i < CHURN_SLOTS; ++i) {
+    if (slot[i])
+      r->release(slot[i]);
+  }
+  size_t free_after = r->free_bytes(), largest_after = r->largest_free();
+  emit(env, "test=fragmentation_released region=%s free=%u largest=%u frag_pct=%.1f largest_before=%u free_before=%u",
+       r->name, (unsigned)free_after, (unsigned)largest_after, frag_pct(free_after, largest_after), (unsigned)largest_before,
+       (unsigned)free_before);
+}
+
+void membench_run_all(const membench_env *env, const membench_region *regions, int n) {
+  for (int i = 0; i < n; ++i) {
+    const membench_region *r = &regions[i];
+    membench_bandwidth(env, r);
+    if (r->bench_bytes > CACHE_RESIDENT_BYTES)
+      membench_latency(env, r, CACHE_RESIDENT_BYTES);
+    membench_latency(env, r, r->bench_bytes);
+    membench_store_fence(env, r);
+    membench_fragmentation(env, r);
+  }
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      membench_memcpy(env, &regions[i], &regions[j]);
+}
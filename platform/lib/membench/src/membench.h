@@ -0,0 +1,50 @@
+/* membench.h - portable memory benchmark core: bandwidth, latency, memcpy, store fences, fragmentation
+ *
+ * The core knows nothing about the board. The caller describes each memory
+ * region (allocator, free/largest-block queries, working-set size) and
+ * supplies a nanosecond clock and a line sink. Every result is one line of
+ * space-separated key=value pairs starting with "membench", e.g.
+ *
+ *   membench test=seq_read region=psram bytes=1048576 mbps=41.7 psram_fix=1
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* 1 when the build passes -mfix-esp32-psram-cache-issue (set alongside the flag) */
+#ifndef MEMBENCH_PSRAM_FIX
+#define MEMBENCH_PSRAM_FIX 0
+#endif
+
+#define MEMBENCH_LINE 64 // pointer-chase stride: one cache line on every ESP32 data cache setting
+
+struct membench_region {
+  const char *name;
+  void *(*alloc)(size_t bytes);     // 4-byte aligned at least
+  void (*release)(void *p);
+  size_t (*free_bytes)(void);       // may be NULL: fragmentation is skipped
+  size_t (*largest_free)(void);     // may be NULL: fragmentation is skipped
+  size_t bench_bytes;               // working set, power of two
+};
+
+struct membench_env {
+  uint64_t (*now_ns)(void);
+  void (*emit)(const char *line);
+  int repeats;                      // best of this many passes per measurement
+};
+
+/* sequential and random 32-bit read/write bandwidth over bench_bytes */
+void membench_bandwidth(const membench_env *env, const membench_region *r);
+/* dependent loads one cache line apart in random order: ns per load, at `bytes` */
+void membench_latency(const membench_env *env, const membench_region *r, size_t bytes);
+/* memcpy of bench_bytes of the smaller region from `src` to `dst` */
+void membench_memcpy(const membench_env *env, const membench_region *src, const membench_region *dst);
+/* sequential writes with and without a memw after every store: what the PSRAM
+ * cache workaround inserts, measured in one build */
+void membench_store_fence(const membench_env *env, const membench_region *r);
+/* random alloc/free churn, then free bytes vs largest block with the survivors live and after freeing them */
+void membench_fragmentation(const membench_env *env, const membench_region *r);
+
+/* everything above for each region, plus memcpy for every ordered pair */
+void membench_run_all(const membench_env *env, const membench_region *regions, int n);
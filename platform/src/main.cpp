@@ -1,34 +1,52 @@
 #include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include "membench.h"
+
+// Memory benchmark suite: internal SRAM vs PSRAM bandwidth, latency, memcpy,
+// store-fence (PSRAM cache workaround) cost and fragmentation. One
+// "membench key=value ..." line per result; send 'r' to run it again.
+// Build both envs (esp32-wrover has -mfix-esp32-psram-cache-issue,
+// esp32-wrover-nofix does not) and compare the psram_fix=1/0 lines.
+
+#define INTERNAL_BENCH_BYTES (64 * 1024)
+#define PSRAM_BENCH_BYTES (1024 * 1024)
+
+static void *internal_alloc(size_t bytes) { return heap_caps_aligned_alloc(MEMBENCH_LINE, bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT); }
+static size_t internal_free() { return heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT); }
+static size_t internal_largest() { return heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT); }
+
+static void *psram_alloc(size_t bytes) { return heap_caps_aligned_alloc(MEMBENCH_LINE, bytes, MALLOC_CAP_SPIRAM); }
+static size_t psram_free() { return heap_caps_get_free_size(MALLOC_CAP_SPIRAM); }
+static size_t psram_largest() { return heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM); }
+
+static void caps_release(void *p) { heap_caps_free(p); }
+
+static uint64_t now_ns() { return (uint64_t)esp_timer_get_time() * 1000u; }
+static void emit(const char *line) { Serial.println(line); }
+
+static void run_suite() {
+  const membench_region regions[] = {
+      {"internal", internal_alloc, caps_release, internal_free, internal_largest, INTERNAL_BENCH_BYTES},
+      {"psram", psram_alloc, caps_release, psram_free, psram_largest, PSRAM_BENCH_BYTES},
+  };
+  const membench_env env = {now_ns, emit, 5};
+
+  Serial.printf("membench test=info cpu_mhz=%u psram_found=%d psram_total=%u psram_free=%u internal_free=%u psram_fix=%d\n",
+                (unsigned)getCpuFrequencyMhz(), psramFound() ? 1 : 0, (unsigned)ESP.getPsramSize(),
+                (unsigned)ESP.getFreePsram(), (unsigned)internal_free(), MEMBENCH_PSRAM_FIX);
+  membench_run_all(&env, regions, psramFound() ? 2 : 1);
+  Serial.println("membench test=done");
+}
 
 void setup() {
   Serial.begin(115200);
   delay(1000);
-
-  Serial.println();
-  Serial.println("=== PSRAM Diagnostic ===");
-
-  if (psramFound()) {
-    Serial.println("✅ PSRAM detected and initialized successfully!");
-
-    // Optional: show total and free PSRAM
-    Serial.printf("Total PSRAM: %u bytes\n", ESP.getPsramSize());
-    Serial.printf("Free PSRAM:  %u bytes\n", ESP.getFreePsram());
-    
-    // Try to allocate 1MB in PSRAM
-    uint8_t *psram_test = (uint8_t *)ps_malloc(1024 * 1024);
-    if (psram_test) {
-      Serial.println("✅ Successfully allocated 1MB from PSRAM!");
-      free(psram_test);
-    } else {
-      Serial.println("⚠️ Failed to allocate 1MB from PSRAM (maybe fragmented or too small)");
-    }
-  } else {
-    Serial.println("❌ PSRAM NOT detected!");
-  }
-
-  Serial.println("========================");
+  run_suite();
 }
 
 void loop() {
-  // Nothing to do here
+  if (Serial.available() && Serial.read() == 'r')
+    run_suite();
+  delay(10);
 }
@@ -2,10 +2,17 @@
 """
 SafePhrase Raspberry Pi: Auto-shutdown on prolonged silence.
 
-Listens to the default ALSA input device and measures loudness.
-If there is continuous silence for MIN_SILENCE_SECONDS, it issues a graceful shutdown.
+With the ESP32 event link (pi/wake_link built in build-pi/ and /dev/serial0
+present) the ESP32 tracks silence itself: it calibrates on its own microphone
+after the first wake word and reports each second of silence, and this script
+just hands over to `wake_link --shutdown-after`. Calibration window, margin and
+grace period are then the firmware's CONFIG_WAKE_SILENCE_* settings.
 
-Dependencies:
+Otherwise (or with --local-audio) it listens to the default ALSA input device
+and measures loudness. If there is continuous silence for MIN_SILENCE_SECONDS,
+it issues a graceful shutdown.
+
+Dependencies (local audio only):
   pip install pyaudio numpy
 """
 
@@ -18,19 +25,15 @@ import argparse
 import subprocess
 from contextlib import contextmanager
 
-try:
-    import pyaudio
-    import numpy as np
-except Exception as e:
-    print("Missing dependency. Please 'pip install pyaudio numpy'")
-    raise
-
 try:
     import RPi.GPIO as GPIO
 except ImportError:
     print("RPi.GPIO not available. This script requires Raspberry Pi.")
     GPIO = None
 
+pyaudio = None
+np = None
+
 # GPIO pin for shutdown trigger (from ESP32 GPIO 7)
 TRIGGER_PIN = 27
 
@@ -45,6 +48,25 @@ SILENCE_MARGIN_DB = float(os.getenv("SP_SILENCE_MARGIN_DB", "3.0"))
 GRACE_PERIOD_AFTER_START = float(os.getenv("SP_GRACE_PERIOD", "20"))
 CHECK_INTERVAL = 0.1
 
+LINK_DEVICE = "/dev/serial0"
+LINK_DECODER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "build-pi", "wake_link")
+
+def load_audio_deps():
+    global pyaudio, np
+    try:
+        import pyaudio
+        import numpy as np
+    except Exception:
+        print("Missing dependency. Please 'pip install pyaudio numpy'")
+        raise
+
+def exec_link_monitor(min_silence):
+    """Replace this process with wake_link; the ESP32 does the audio work."""
+    argv = [LINK_DECODER, "--shutdown-after", str(int(math.ceil(min_silence))), LINK_DEVICE]
+    print(f"Silence tracked on the ESP32, shutdown after {argv[2]}s (via {LINK_DEVICE})")
+    sys.stdout.flush()
+    os.execv(LINK_DECODER, argv)
+
 def list_devices(pa):
     print("Input devices:")
     for i in range(pa.get_device_count()):
@@ -70,7 +92,7 @@ def audio_stream(device_index=None):
             pass
         pa.terminate()
 
-def rms_dbfs(samples_int16: np.ndarray) -> float:
+def rms_dbfs(samples_int16) -> float:
     if samples_int16.size == 0:
         return -120.0
     samples = samples_int16.astype(np.float32) / 32768.0
@@ -93,18 +115,24 @@ def calibrate_ambient(stream, duration_s=CALIBRATION_SECONDS):
     return silence_threshold
 
 def main():
-    # GPIO setup for activation trigger
-    if GPIO:
-        GPIO.setmode(GPIO.BCM)
-        GPIO.setup(TRIGGER_PIN, GPIO.IN, pull_up_down=GPIO.PUD_DOWN)
-
     parser = argparse.ArgumentParser(description="Shutdown on prolonged silence after GPIO trigger")
     parser.add_argument("--device", type=int, default=None, help="ALSA device index")
     parser.add_argument("--list-devices", action="store_true", help="List input devices and exit")
     parser.add_argument("--min-silence", type=float, default=MIN_SILENCE_SECONDS, help="Seconds of continuous silence before shutdown")
-    parser.add_argument("--grace", type=float, default=GRACE_PERIOD_AFTER_START, help="Startup grace period seconds")
+    parser.add_argument("--grace", type=float, default=GRACE_PERIOD_AFTER_START, help="Startup grace period seconds (local audio)")
+    parser.add_argument("--local-audio", action="store_true", help="Measure silence on the Pi's microphone even if the ESP32 link is available")
     args = parser.parse_args()
 
+    if not args.local_audio and not args.list_devices and os.path.exists(LINK_DECODER) and os.path.exists(LINK_DEVICE):
+        exec_link_monitor(args.min_silence)
+
+    load_audio_deps()
+
+    # GPIO setup for activation trigger
+    if GPIO:
+        GPIO.setmode(GPIO.BCM)
+        GPIO.setup(TRIGGER_PIN, GPIO.IN, pull_up_down=GPIO.PUD_DOWN)
+
     if args.list_devices:
         pa = pyaudio.PyAudio()
         list_devices(pa)
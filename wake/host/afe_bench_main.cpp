@@ -0,0 +1,48 @@
+/* afe_bench_main.cpp - host entry point for the AFE configuration sweep
+ *
+ * The stand-in AFE runs no models and has one configuration's cost, so the
+ * rows should agree; this checks the sweep and its scoring. Each wake word
+ * of the audio set is scripted at its true end (plus --late-ms), so every
+ * row should read all detected, no false accepts. --feed-cost-us and
+ * --fetch-cost-us give the stand-in a cost.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "afe_bench.h"
+#include "model_registry.h"
+#include "pipeline.h"
+#include "sr_stub.h"
+
+int main(int argc, char **argv)
+{
+    uint32_t feed_cost = 0, fetch_cost = 0;
+    int late_ms = 300;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--feed-cost-us") == 0)
+            feed_cost = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--fetch-cost-us") == 0)
+            fetch_cost = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--late-ms") == 0)
+            late_ms = atoi(argv[i + 1]);
+    }
+    sr_stub_set_cost_us(feed_cost, fetch_cost);
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    uint64_t truth[AFE_BENCH_MAX_POSITIVES];
+    int n = afe_bench_truth(truth, AFE_BENCH_MAX_POSITIVES);
+    sr_stub_event_t events[AFE_BENCH_MAX_POSITIVES] = {};
+    for (int i = 0; i < n; ++i)
+    {
+        events[i].type = SR_STUB_WAKE;
+        events[i].sample = truth[i] + (uint64_t)late_ms * SAMPLE_RATE / 1000;
+    }
+    sr_stub_set_script(events, n);
+
+    srmodel_list_t *models = model_registry_init("model");
+    afe_bench_run(models);
+    model_registry_deinit();
+    return 0;
+}
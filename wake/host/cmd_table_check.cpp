@@ -0,0 +1,294 @@
+/* cmd_table_check.cpp - host check of the partition command table and the background MultiNet rebuild
+ *
+ * Plants a 300-phrase table in a stand-in "commands" partition and runs the
+ * firmware's capture, feed and detect tasks (pipeline.cpp) on quiet room
+ * noise at real time, with scripted wakes and commands. Phrases are added
+ * and removed during a command window. MultiNet's graph rebuild is simulated
+ * by a busy-wait of many chunks (--update-ms), so the check fails if it lands
+ * on detect_Task: the AFE backlog must stay within a few chunks. detect_Task
+ * must switch to an instance with the new list at a command window boundary,
+ * hear the added commands with it, and the old instances must be destroyed.
+ * The changes must then survive reloading the partition, including after it
+ * fills up and is rewritten, after an append torn by a reset and, as the
+ * previous table, after a rewrite torn by one.
+ *
+ *   cmd_table_check [--update-ms N]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_afe_sr_models.h"
+#include "arena.h"
+#include "capture.h"
+#include "cmd_table.h"
+#include "event_log.h"
+#include "model_registry.h"
+#include "pipeline.h"
+#include "signal_stats.h"
+#include "wake_log.h"
+#include "i2s_stub.h"
+#include "partition_stub.h"
+#include "sr_stub.h"
+
+#define CHUNK_MS 32
+#define BASE_PHRASES 300
+#define BASE_VERSION 7
+#define PART_SIZE (64 * 1024)
+#define AUDIO_S 11
+#define CHANGE_AT_S 1.0       // table changes, inside the first command window
+#define MAX_BACKLOG_CHUNKS 4  // a rebuild on detect_Task would back the AFE up by --update-ms
+#define NOISE_PEAK 173
+// the first window opens at 0.5 s and times out at 6.5 s; the commands are new in the table
+#define SCRIPT "wake@0.5,wake@8.0,cmd1000@9.0,cmd1001@10.0"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAILED");
+    failures += !ok;
+}
+
+static bool has_command(model_iface_data_t *md, int id, size_t *total)
+{
+    static int ids[CMD_TABLE_MAX];
+    *total = md ? sr_stub_mn_commands(md, ids, CMD_TABLE_MAX) : 0;
+    for (size_t i = 0; i < *total && i < CMD_TABLE_MAX; ++i)
+    {
+        if (ids[i] == id)
+            return true;
+    }
+    return false;
+}
+
+static bool table_has(const char *phrase, int id)
+{
+    cmd_entry_t e;
+    for (int i = 0; cmd_table_get(i, &e); ++i)
+    {
+        if (strcmp(e.phrase, phrase) == 0)
+            return e.command_id == id;
+    }
+    return false;
+}
+
+static void plant_base(const esp_partition_t *part)
+{
+    std::vector<uint8_t> seg(sizeof(cmd_seg_hdr_t) + BASE_PHRASES * CMD_TABLE_RECORD_MAX + 4);
+    uint8_t *body = seg.data() + sizeof(cmd_seg_hdr_t);
+    size_t len = 0;
+    char phrase[CMD_TABLE_PHRASE_MAX + 1];
+    for (int i = 0; i < BASE_PHRASES; ++i)
+    {
+        snprintf(phrase, sizeof(phrase), "command phrase %d", i);
+        len += cmd_table_put_record(body + len, CMD_OP_ADD, i, phrase);
+    }
+    size_t n = cmd_table_put_segment(seg.data(), CMD_SEG_BASE, BASE_VERSION, body, len, BASE_PHRASES);
+    ESP_ERROR_CHECK(esp_partition_write(part, 0, seg.data(), n));
+}
+
+/* app_main's bring-up, as wake_sim does it, on AUDIO_S seconds of room noise */
+static bool start_pipeline(std::vector<int16_t> &pcm)
+{
+    uint32_t noise = 2463534242u;
+    pcm.resize((size_t)AUDIO_S * SAMPLE_RATE);
+    for (int16_t &s : pcm)
+    {
+        noise ^= noise << 13;
+        noise ^= noise >> 17;
+        noise ^= noise << 5;
+        s = (int16_t)((int32_t)(noise % (2 * NOISE_PEAK + 1)) - NOISE_PEAK);
+    }
+    static sr_stub_event_t events[8];
+    int n = sr_stub_parse_script(SCRIPT, SAMPLE_RATE, events, 8);
+    sr_stub_set_script(events, n);
+
+    wake_log_init();
+    signal_stats_init();
+    srmodel_list_t *models = model_registry_init("model");
+    if (!models)
+        return false;
+    afe_config_t *afe_config = afe_config_init("M", models, AFE_TYPE_SR, AFE_MODE_LOW_COST);
+    afe_handle = esp_afe_handle_from_config(afe_config);
+    esp_afe_sr_data_t *afe_data = afe_handle->create_from_config(afe_config);
+    afe_config_free(afe_config);
+    size_t feed_samples =
+        (size_t)afe_handle->get_feed_chunksize(afe_data) * (size_t)afe_handle->get_feed_channel_num(afe_data);
+
+    i2s_stub_set_source(pcm.data(), pcm.size(), false);
+    i2s_stub_set_speed(1.0);
+    i2s_chan_handle_t rx = NULL;
+    i2s_chan_config_t chan_cfg = {};
+    chan_cfg.id = I2S_NUM_0;
+    chan_cfg.role = I2S_ROLE_MASTER;
+    chan_cfg.dma_desc_num = 8;
+    chan_cfg.dma_frame_num = capture_is_zero_copy() ? (uint32_t)feed_samples : 256;
+    ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, NULL, &rx));
+    i2s_std_config_t std_cfg = {};
+    std_cfg.clk_cfg.sample_rate_hz = SAMPLE_RATE;
+    ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx, &std_cfg));
+
+    arena_plan_t plan = {};
+    capture_plan(&plan, feed_samples);
+    pipeline_plan(&plan, afe_data);
+    if (!arena_init(&plan))
+        return false;
+    ESP_ERROR_CHECK(capture_start(rx, feed_samples, 8));
+    pipeline_start(afe_data);
+    return true;
+}
+
+static void wait_audio(double sec)
+{
+    while (i2s_stub_samples_delivered() < (uint64_t)(sec * SAMPLE_RATE) && !i2s_stub_done())
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+}
+
+int main(int argc, char **argv)
+{
+    int update_ms = 400;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--update-ms") == 0 && i + 1 < argc)
+            update_ms = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--update-ms N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const esp_partition_t *part = partition_stub_add("commands", CMD_TABLE_SUBTYPE, PART_SIZE);
+    plant_base(part);
+    sr_stub_set_commands_cost_us((uint32_t)update_ms * 1000);
+    std::vector<int16_t> pcm;
+    if (!start_pipeline(pcm))
+        return 1;
+
+    // detect_Task loads MultiNet in the background; the changes land during the first command window
+    wait_audio(CHANGE_AT_S);
+    model_iface_data_t *md = NULL;
+    for (int waited = 0; !model_registry_multinet_ready(&md) && waited < 10 * update_ms + 2000; waited += 10)
+        vTaskDelay(pdMS_TO_TICKS(10));
+    cmd_table_info_t info;
+    cmd_table_get_info(&info);
+    size_t total = 0;
+    printf("boot: table v%u from partition, %u commands; MultiNet update %d ms\n", (unsigned)info.version,
+           (unsigned)info.count, update_ms);
+    check(info.source == CMD_SRC_PARTITION && info.version == BASE_VERSION && info.count == BASE_PHRASES,
+          "base table loaded from the partition");
+    has_command(md, 0, &total);
+    check(total == BASE_PHRASES, "MultiNet loaded with the base table");
+
+    // the second change lands during the first rebuild and is merged into one more
+    check(cmd_table_add(1000, "open the garage door") == ESP_OK, "add");
+    check(cmd_table_remove("command phrase 3") == ESP_OK, "remove");
+    check(cmd_table_remove("no such phrase") == ESP_ERR_NOT_FOUND, "remove of an unknown phrase refused");
+    model_registry_multinet_rebuild();
+    vTaskDelay(pdMS_TO_TICKS(update_ms / 4));
+    check(cmd_table_add(1001, "close the garage door") == ESP_OK, "add during the rebuild");
+    model_registry_multinet_rebuild();
+
+    // the whole clip: the swaps wait for the window to close, the commands come in the next one
+    while (!i2s_stub_done() || capture_pending() > 0 || sr_stub_backlog() > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    task_flag = 0;
+    capture_stop();
+    event_log_stop();
+    sr_stub_counters_t sc;
+    for (int waited = 0; waited < 1000; waited += 10)
+    {
+        sr_stub_get_counters(&sc);
+        if (sc.mn_live == 1)
+            break;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    model_iface_data_t *now = sr_stub_mn_detecting();
+    bool updated = has_command(now, 1001, &total) && has_command(now, 1000, &total) && total == BASE_PHRASES + 1;
+    printf("update: AFE backlog at most %llu chunks (chunk %d ms), commands heard %llu, not in the list %llu, "
+           "MultiNet updates %llu, instances alive %llu\n",
+           (unsigned long long)sc.max_backlog, CHUNK_MS, (unsigned long long)sc.commands,
+           (unsigned long long)sc.unknown_commands, (unsigned long long)sc.mn_updates, (unsigned long long)sc.mn_live);
+    check(updated, "detect_Task runs the updated command list");
+    check(!has_command(now, 3, &total), "removed phrase gone from MultiNet");
+    check(sc.commands == 2 && sc.unknown_commands == 0, "added commands heard in the next window");
+    check(sc.max_backlog <= MAX_BACKLOG_CHUNKS && sc.dropped_chunks == 0, "no rebuild blocked detect_Task");
+    check(sc.mn_updates >= 2 && sc.mn_updates <= 3, "changes merged into at most two rebuilds");
+    check(sc.mn_live == 1, "swapped-out instances destroyed");
+
+    // the deltas survive a reload
+    cmd_table_init("commands");
+    cmd_table_get_info(&info);
+    printf("reload: v%u, %u commands, %u/%u bytes in %u segments\n", (unsigned)info.version, (unsigned)info.count,
+           (unsigned)info.used, (unsigned)info.size, (unsigned)info.segments);
+    check(info.version == BASE_VERSION + 3 && info.segments == 4 && info.count == BASE_PHRASES + 1 &&
+              table_has("open the garage door", 1000) && table_has("close the garage door", 1001) &&
+              !table_has("command phrase 3", 3),
+          "deltas replayed from the partition");
+
+    // churn until the partition is full and gets rewritten as one base segment
+    int churn = 0;
+    for (cmd_table_get_info(&info); info.compactions == 0 && churn < 10000; cmd_table_get_info(&info), ++churn)
+    {
+        if (cmd_table_add(2000, "weekly churn phrase") != ESP_OK || cmd_table_remove("weekly churn phrase") != ESP_OK)
+            break;
+    }
+    uint32_t version = info.version;
+    uint32_t used = info.used;
+    check(cmd_table_add(1000, "open the garage door") == ESP_OK, "re-adding an unchanged phrase");
+    cmd_table_get_info(&info);
+    check(info.used == used && info.version == version, "... writes nothing");
+    cmd_table_init("commands");
+    cmd_table_get_info(&info);
+    printf("churn: %d add/remove pairs before the rewrite; reload v%u, %u commands in %u segments\n", churn,
+           (unsigned)info.version, (unsigned)info.count, (unsigned)info.segments);
+    check(info.version == version && info.count == BASE_PHRASES + 1 && !table_has("weekly churn phrase", 2000),
+          "rewritten partition reloads the same table");
+
+    // an append cut short by a reset: header written, record still erased
+    uint32_t before = info.used;
+    check(cmd_table_add(3000, "torn append") == ESP_OK, "add before the reset");
+    cmd_table_get_info(&info);
+    memset(partition_stub_data(part) + info.slot + before + sizeof(cmd_seg_hdr_t), 0xFF,
+           info.used - before - sizeof(cmd_seg_hdr_t));
+    cmd_table_init("commands");
+    cmd_table_get_info(&info);
+    check(info.count == BASE_PHRASES + 1 && !table_has("torn append", 3000), "torn append dropped, table kept");
+    uint32_t old_slot = info.slot;
+    version = info.version;
+    check(cmd_table_add(3001, "after the reset") == ESP_OK, "next change rewrites past the torn append");
+    cmd_table_init("commands");
+    cmd_table_get_info(&info);
+    check(info.count == BASE_PHRASES + 2 && table_has("after the reset", 3001) && info.segments == 1 &&
+              info.slot != old_slot,
+          "table after the rewrite, in the other slot");
+
+    // that rewrite cut short by a reset: base header written, records still erased
+    memset(partition_stub_data(part) + info.slot + sizeof(cmd_seg_hdr_t), 0xFF, info.used - sizeof(cmd_seg_hdr_t));
+    cmd_table_init("commands");
+    cmd_table_get_info(&info);
+    printf("torn rewrite: reload v%u from slot at 0x%x, %u commands\n", (unsigned)info.version, (unsigned)info.slot,
+           (unsigned)info.count);
+    check(info.slot == old_slot && info.version == version && info.count == BASE_PHRASES + 1 &&
+              !table_has("after the reset", 3001),
+          "torn rewrite falls back to the previous table");
+    check(cmd_table_add(3001, "after the reset") == ESP_OK && table_has("after the reset", 3001),
+          "next change rewrites again");
+
+    partition_stub_counters_t pc;
+    partition_stub_get_counters(&pc);
+    printf("flash: %llu writes, %llu sectors erased, %llu writes over unerased bytes\n", (unsigned long long)pc.writes,
+           (unsigned long long)pc.erased_sectors, (unsigned long long)pc.unerased_writes);
+    check(pc.unerased_writes == 0, "every write went to erased flash");
+
+    model_registry_deinit();
+    host_task_join_all();
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,198 @@
+/* cmd_table_tool.cpp - builds and dumps "commands" partition images (format: wake/main/cmd_table.h)
+ *
+ *   cmd_table_tool build commands.txt commands.bin [--version N] [--size BYTES]
+ *   cmd_table_tool dump commands.bin
+ *
+ * commands.txt holds one "<command_id> <phrase>" per line; blank lines and
+ * '#' comments are skipped. build writes one base segment padded with 0xFF to
+ * the partition size (64 KB unless --size), ready for
+ *   parttool.py write_partition --partition-name commands --input commands.bin
+ * Console changes on the board count on from the image's version, so give a new
+ * image a higher one than the board shows ("cmd") to keep versions unique.
+ * The base goes in the first slot (the first half of the partition).
+ * dump replays an image, or a partition read back with parttool.py
+ * read_partition, the way the firmware does at boot: from the slot with the
+ * newer table.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <vector>
+#include "cmd_table.h"
+
+static int build(const char *txt, const char *bin, uint32_t version, size_t size)
+{
+    FILE *in = fopen(txt, "r");
+    if (!in)
+    {
+        perror(txt);
+        return 1;
+    }
+    static cmd_entry_t entries[CMD_TABLE_MAX];
+    std::vector<uint8_t> seg(sizeof(cmd_seg_hdr_t) + CMD_TABLE_MAX * CMD_TABLE_RECORD_MAX + 4);
+    uint8_t *body = seg.data() + sizeof(cmd_seg_hdr_t);
+    size_t len = 0;
+    int records = 0, count = 0, lineno = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), in))
+    {
+        lineno++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        char *p = line;
+        while (isspace((unsigned char)*p))
+            p++;
+        if (!*p)
+            continue;
+        char *end;
+        long id = strtol(p, &end, 10);
+        while (isspace((unsigned char)*end))
+            end++;
+        size_t n = strlen(end);
+        while (n && isspace((unsigned char)end[n - 1]))
+            end[--n] = '\0';
+        size_t rec = end != p ? cmd_table_put_record(body + len, CMD_OP_ADD, (int)id, end) : 0;
+        if (!rec || id < 0 || id > INT16_MAX)
+        {
+            fprintf(stderr, "%s:%d: expected \"<id 0..32767> <phrase of 1..%d chars>\"\n", txt, lineno,
+                    CMD_TABLE_PHRASE_MAX);
+            fclose(in);
+            return 1;
+        }
+        // replayed as we go so duplicates and the command limit fail here, not on the board
+        cmd_seg_hdr_t one = {CMD_TABLE_MAGIC, CMD_TABLE_FORMAT, CMD_SEG_DELTA, 1, 0, (uint32_t)rec, 0};
+        int before = count;
+        if (!cmd_table_replay(&one, body + len, entries, &count, CMD_TABLE_MAX))
+        {
+            fprintf(stderr, "%s:%d: more than %d commands\n", txt, lineno, CMD_TABLE_MAX);
+            fclose(in);
+            return 1;
+        }
+        if (count == before)
+        {
+            fprintf(stderr, "%s:%d: duplicate phrase \"%s\"\n", txt, lineno, end);
+            fclose(in);
+            return 1;
+        }
+        len += rec;
+        records++;
+    }
+    fclose(in);
+
+    size_t n = cmd_table_put_segment(seg.data(), CMD_SEG_BASE, version, body, len, (uint16_t)records);
+    if (n > CMD_TABLE_SLOT_SIZE(size))
+    {
+        fprintf(stderr, "%u bytes do not fit a %u byte partition's slot\n", (unsigned)n, (unsigned)size);
+        return 1;
+    }
+    seg.resize(n);
+    seg.resize(size, 0xFF);
+    FILE *out = fopen(bin, "wb");
+    if (!out || fwrite(seg.data(), 1, size, out) != size)
+    {
+        perror(bin);
+        return 1;
+    }
+    fclose(out);
+    printf("%s: v%u, %d commands, %u of %u bytes\n", bin, (unsigned)version, records, (unsigned)n, (unsigned)size);
+    return 0;
+}
+
+/* Replays the slot at `slot`; returns its segments (0: no valid base), printing them if asked. */
+static int replay(const std::vector<uint8_t> &image, size_t slot, size_t size, cmd_entry_t *entries, int *count,
+                  uint32_t *version, size_t *used, bool print)
+{
+    int segments = 0;
+    size_t at = 0;
+    *count = 0;
+    *version = 0;
+    while (at + sizeof(cmd_seg_hdr_t) <= size)
+    {
+        cmd_seg_hdr_t hdr;
+        memcpy(&hdr, image.data() + slot + at, sizeof(hdr));
+        if (hdr.magic == 0xFFFFFFFF)
+            break;
+        const uint8_t *body = image.data() + slot + at + sizeof(hdr);
+        bool ok = hdr.magic == CMD_TABLE_MAGIC && hdr.format == CMD_TABLE_FORMAT &&
+                  hdr.kind == (segments == 0 ? CMD_SEG_BASE : CMD_SEG_DELTA) &&
+                  (segments == 0 || hdr.version > *version) && at + sizeof(hdr) + hdr.body_len <= size &&
+                  cmd_table_crc32(0, body, hdr.body_len) == hdr.crc &&
+                  cmd_table_replay(&hdr, body, entries, count, CMD_TABLE_MAX);
+        if (!ok)
+        {
+            if (print)
+                printf("bad segment at 0x%x: the firmware stops here and rewrites on the next change\n",
+                       (unsigned)(slot + at));
+            if (segments == 0)
+                *count = 0;
+            break;
+        }
+        if (print)
+            printf("segment %d at 0x%x: %s v%u, %u records\n", segments, (unsigned)(slot + at),
+                   hdr.kind == CMD_SEG_BASE ? "base" : "delta", (unsigned)hdr.version, (unsigned)hdr.records);
+        segments++;
+        *version = hdr.version;
+        at += (sizeof(hdr) + hdr.body_len + 3) & ~(size_t)3;
+    }
+    *used = at;
+    return segments;
+}
+
+static int dump(const char *bin)
+{
+    FILE *in = fopen(bin, "rb");
+    if (!in)
+    {
+        perror(bin);
+        return 1;
+    }
+    std::vector<uint8_t> image;
+    uint8_t buf[4096];
+    size_t got;
+    while ((got = fread(buf, 1, sizeof(buf), in)) > 0)
+        image.insert(image.end(), buf, buf + got);
+    fclose(in);
+
+    // the live slot: a rewrite's new base always has a higher version than the table it replaces
+    static cmd_entry_t entries[CMD_TABLE_MAX];
+    size_t size = CMD_TABLE_SLOT_SIZE(image.size());
+    int count = 0;
+    uint32_t v0, v1;
+    size_t used;
+    int s0 = replay(image, 0, size, entries, &count, &v0, &used, false);
+    int s1 = replay(image, size, size, entries, &count, &v1, &used, false);
+    size_t slot = s1 && (!s0 || v1 > v0) ? size : 0;
+    uint32_t version;
+    int segments = replay(image, slot, size, entries, &count, &version, &used, true);
+    printf("table v%u in slot %d: %d commands, %u of %u bytes in %d segments\n", (unsigned)version, slot ? 1 : 0,
+           count, (unsigned)used, (unsigned)size, segments);
+    for (int i = 0; i < count; ++i)
+        printf("%5d  %s\n", entries[i].command_id, entries[i].phrase);
+    return segments ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 3 && strcmp(argv[1], "dump") == 0)
+        return dump(argv[2]);
+    if (argc >= 4 && strcmp(argv[1], "build") == 0)
+    {
+        uint32_t version = 1;
+        size_t size = 64 * 1024;
+        for (int i = 4; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "--version") == 0 && i + 1 < argc)
+                version = (uint32_t)strtoul(argv[++i], NULL, 0);
+            else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+                size = (size_t)strtoul(argv[++i], NULL, 0);
+            else
+                version = 0;
+        }
+        if (version)
+            return build(argv[2], argv[3], version, size);
+    }
+    fprintf(stderr, "usage: %s build commands.txt commands.bin [--version N] [--size BYTES]\n"
+                    "       %s dump commands.bin\n",
+            argv[0], argv[0]);
+    return 2;
+}
@@ -0,0 +1,77 @@
+/* event_decode.cpp - turns event log dumps from the firmware back into text
+ *
+ * Reads a serial capture (stdin or FILE) and replaces every "EVB <hex>" line
+ * written with CONFIG_WAKE_EVENT_LOG_BINARY by its formatted record; other
+ * lines pass through untouched. --raw reads FILE as back-to-back 48-byte
+ * event_rec_t records instead. Records the firmware's ring dropped are
+ * counted by an EV_LOG_DROPPED record; gaps in the record sequence are
+ * records lost on the way (garbled or missing lines).
+ *
+ *   event_decode [--raw] [FILE]
+ */
+#include <stdio.h>
+#include <string.h>
+#include "event_log.h"
+
+static bool have_seq = false;
+static uint32_t next_seq = 0;
+
+static void print_rec(const event_rec_t *rec)
+{
+    if (have_seq && rec->seq != next_seq)
+        printf("-- %u records lost in transfer\n", (unsigned)(rec->seq - next_seq)); // ring drops have their own record
+    have_seq = true;
+    next_seq = rec->seq + 1;
+
+    char line[256];
+    event_log_format(rec, line, sizeof(line));
+    printf("%s\n", line);
+}
+
+int main(int argc, char **argv)
+{
+    bool raw = false;
+    const char *path = NULL;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--raw") == 0)
+            raw = true;
+        else if (!path && argv[i][0] != '-')
+            path = argv[i];
+        else
+        {
+            fprintf(stderr, "usage: event_decode [--raw] [FILE]\n");
+            return 2;
+        }
+    }
+    FILE *in = path ? fopen(path, raw ? "rb" : "r") : stdin;
+    if (!in)
+    {
+        fprintf(stderr, "event_decode: cannot open %s\n", path);
+        return 2;
+    }
+
+    if (raw)
+    {
+        event_rec_t rec;
+        while (fread(&rec, sizeof(rec), 1, in) == 1)
+            print_rec(&rec);
+    }
+    else
+    {
+        char line[512];
+        while (fgets(line, sizeof(line), in))
+        {
+            // the EVB marker may follow a log prefix or stray console bytes
+            const char *evb = strstr(line, "EVB ");
+            event_rec_t rec;
+            if (evb && event_log_parse_hex(evb + 4, &rec))
+                print_rec(&rec);
+            else
+                fputs(line, stdout);
+        }
+    }
+    if (in != stdin)
+        fclose(in);
+    return 0;
+}
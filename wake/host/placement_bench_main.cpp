@@ -0,0 +1,39 @@
+/* placement_bench_main.cpp - host entry point for the buffer placement benchmark
+ *
+ * The host has one memory class, so the rows should agree; this checks the
+ * bench itself. --feed-cost-us/--fetch-cost-us give the stand-in AFE a cost.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_afe_sr_models.h"
+#include "signal_stats.h"
+#include "pipeline.h"
+#include "model_registry.h"
+#include "sr_stub.h"
+
+int main(int argc, char **argv)
+{
+    uint32_t feed_cost = 0, fetch_cost = 0;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--feed-cost-us") == 0)
+            feed_cost = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--fetch-cost-us") == 0)
+            fetch_cost = (uint32_t)atoi(argv[i + 1]);
+    }
+    sr_stub_set_cost_us(feed_cost, fetch_cost);
+    esp_log_level_set("*", ESP_LOG_WARN);
+    signal_stats_init();
+
+    srmodel_list_t *models = model_registry_init("model");
+    afe_config_t *afe_config = afe_config_init("M", models, AFE_TYPE_SR, AFE_MODE_LOW_COST);
+    afe_handle = esp_afe_handle_from_config(afe_config);
+    esp_afe_sr_data_t *afe_data = afe_handle->create_from_config(afe_config);
+    afe_config_free(afe_config);
+
+    pipeline_placement_bench(afe_data);
+    model_registry_deinit();
+    return 0;
+}
@@ -0,0 +1,9 @@
+/* signal_stats_bench_main.cpp - host entry point for the signal stats microbenchmark */
+#include "signal_stats.h"
+
+int main(void)
+{
+    signal_stats_init();
+    signal_stats_bench();
+    return 0;
+}
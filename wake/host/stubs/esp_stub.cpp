@@ -0,0 +1,275 @@
+/* esp_stub.cpp - logging, heap_caps accounting, GPIO, LEDC and UART for the host build */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "driver/uart.h"
+#include "esp_stub.h"
+
+static std::mutex log_lock;
+static std::map<std::string, esp_log_level_t> log_levels;
+static esp_log_level_t log_default = ESP_LOG_INFO;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    std::lock_guard<std::mutex> g(log_lock);
+    if (strcmp(tag, "*") == 0)
+    {
+        log_default = level;
+        log_levels.clear();
+        return;
+    }
+    log_levels[tag] = level;
+}
+
+esp_log_level_t esp_log_level_get(const char *tag)
+{
+    std::lock_guard<std::mutex> g(log_lock);
+    auto it = log_levels.find(tag);
+    return it == log_levels.end() ? log_default : it->second;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+}
+
+static const auto boot_time = std::chrono::steady_clock::now();
+
+int64_t esp_timer_get_time(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - boot_time).count();
+}
+
+/* Allocations carry a small header so usage can be reported per memory class,
+ * the way the target's heap_caps_get_free_size() would. */
+#define HOST_INTERNAL_BYTES (512u * 1024u)
+#define HOST_SPIRAM_BYTES (8u * 1024u * 1024u)
+
+typedef struct
+{
+    void *base;
+    size_t size;
+    bool spiram;
+} alloc_hdr_t;
+
+static std::atomic<size_t> used_internal(0);
+static std::atomic<size_t> used_spiram(0);
+
+static bool wants_spiram(uint32_t caps)
+{
+    return (caps & MALLOC_CAP_SPIRAM) && !(caps & (MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA));
+}
+
+extern "C" __attribute__((weak)) void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+}
+
+void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps)
+{
+    if (alignment < alignof(alloc_hdr_t))
+        alignment = alignof(alloc_hdr_t);
+    bool spiram = wants_spiram(caps);
+    std::atomic<size_t> &used = spiram ? used_spiram : used_internal;
+    size_t limit = spiram ? HOST_SPIRAM_BYTES : HOST_INTERNAL_BYTES;
+    if (used.load() + size > limit)
+        return NULL;
+
+    uint8_t *base = (uint8_t *)malloc(size + alignment + sizeof(alloc_hdr_t));
+    if (!base)
+        return NULL;
+    uintptr_t p = ((uintptr_t)(base + sizeof(alloc_hdr_t)) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    alloc_hdr_t *h = (alloc_hdr_t *)p - 1;
+    h->base = base;
+    h->size = size;
+    h->spiram = spiram;
+    used += size;
+    esp_heap_trace_alloc_hook((void *)p, size, caps);
+    return (void *)p;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return heap_caps_aligned_alloc(sizeof(void *), size, caps);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    void *p = heap_caps_malloc(n * size, caps);
+    if (p)
+        memset(p, 0, n * size);
+    return p;
+}
+
+void heap_caps_free(void *ptr)
+{
+    if (!ptr)
+        return;
+    alloc_hdr_t *h = (alloc_hdr_t *)ptr - 1;
+    (h->spiram ? used_spiram : used_internal) -= h->size;
+    free(h->base);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return wants_spiram(caps) ? HOST_SPIRAM_BYTES - used_spiram.load() : HOST_INTERNAL_BYTES - used_internal.load();
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return heap_caps_get_free_size(caps);
+}
+
+void heap_caps_print_heap_info(uint32_t caps)
+{
+    fprintf(stderr, "Heap summary for capabilities 0x%08x: free %u bytes\n", (unsigned)caps, (unsigned)heap_caps_get_free_size(caps));
+}
+
+static std::atomic<uint32_t> gpio_levels[GPIO_NUM_MAX];
+static void (*gpio_observer)(gpio_num_t, uint32_t) = NULL;
+
+void gpio_stub_set_observer(void (*fn)(gpio_num_t gpio, uint32_t level))
+{
+    gpio_observer = fn;
+}
+
+esp_err_t gpio_config(const gpio_config_t *cfg)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level)
+{
+    if (gpio < 0 || gpio >= GPIO_NUM_MAX)
+        return ESP_ERR_INVALID_ARG;
+    gpio_levels[gpio].store(level ? 1 : 0);
+    if (gpio_observer)
+        gpio_observer(gpio, level ? 1 : 0);
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio)
+{
+    if (gpio < 0 || gpio >= GPIO_NUM_MAX)
+        return 0;
+    return (int)gpio_levels[gpio].load();
+}
+
+static std::atomic<uint32_t> ledc_pending[LEDC_CHANNEL_MAX];
+static std::atomic<uint32_t> ledc_duty[LEDC_CHANNEL_MAX];
+static void (*ledc_observer)(ledc_channel_t, uint32_t) = NULL;
+
+void ledc_stub_set_observer(void (*fn)(ledc_channel_t channel, uint32_t duty))
+{
+    ledc_observer = fn;
+}
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *timer_conf)
+{
+    return ESP_OK;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *ledc_conf)
+{
+    if (ledc_conf->channel >= LEDC_CHANNEL_MAX)
+        return ESP_ERR_INVALID_ARG;
+    ledc_pending[ledc_conf->channel].store(ledc_conf->duty);
+    ledc_duty[ledc_conf->channel].store(ledc_conf->duty);
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty)
+{
+    if (channel >= LEDC_CHANNEL_MAX)
+        return ESP_ERR_INVALID_ARG;
+    ledc_pending[channel].store(duty);
+    return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    if (channel >= LEDC_CHANNEL_MAX)
+        return ESP_ERR_INVALID_ARG;
+    uint32_t duty = ledc_pending[channel].load();
+    ledc_duty[channel].store(duty);
+    if (ledc_observer)
+        ledc_observer(channel, duty);
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_duty_and_update(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty, uint32_t hpoint)
+{
+    esp_err_t err = ledc_set_duty(speed_mode, channel, duty);
+    return err == ESP_OK ? ledc_update_duty(speed_mode, channel) : err;
+}
+
+esp_err_t ledc_fade_func_install(int intr_alloc_flags)
+{
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_fade_time_and_start(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t target_duty,
+                                       uint32_t max_fade_time_ms, ledc_fade_mode_t fade_mode)
+{
+    return ledc_set_duty_and_update(speed_mode, channel, target_duty, 0);
+}
+
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    return channel < LEDC_CHANNEL_MAX ? ledc_duty[channel].load() : 0;
+}
+
+static std::atomic<int> uart_fd(-1);
+
+void uart_stub_set_fd(int fd)
+{
+    uart_fd.store(fd);
+}
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size, int queue_size,
+                              QueueHandle_t *uart_queue, int intr_alloc_flags)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *cfg)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t port, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num)
+{
+    return ESP_OK;
+}
+
+int uart_write_bytes(uart_port_t port, const void *src, size_t size)
+{
+    int fd = uart_fd.load();
+    if (fd < 0)
+        return (int)size;
+    const uint8_t *p = (const uint8_t *)src;
+    size_t left = size;
+    while (left)
+    {
+        ssize_t n = write(fd, p, left);
+        if (n <= 0)
+            return -1;
+        p += n;
+        left -= (size_t)n;
+    }
+    return (int)size;
+}
@@ -0,0 +1,13 @@
+/* esp_stub.h - host-only observers for GPIO, LEDC and UART writes */
+#pragma once
+
+#include <stdint.h>
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+
+/* called from the writing task on every gpio_set_level() */
+void gpio_stub_set_observer(void (*fn)(gpio_num_t gpio, uint32_t level));
+/* called from the writing task on every ledc_update_duty() with the latched duty */
+void ledc_stub_set_observer(void (*fn)(ledc_channel_t channel, uint32_t duty));
+/* uart_write_bytes() on any port writes to fd; -1 (the default) discards */
+void uart_stub_set_fd(int fd);
@@ -0,0 +1,189 @@
+/* freertos_stub.cpp - FreeRTOS tasks, notifications and queues on std::thread */
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+struct host_task
+{
+    std::mutex m;
+    std::condition_variable cv;
+    uint32_t notify = 0;
+};
+
+struct host_queue
+{
+    std::mutex m;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t item_size;
+};
+
+static const auto boot_time = std::chrono::steady_clock::now();
+static thread_local host_task *current_task = NULL;
+static std::mutex threads_lock;
+static std::vector<std::thread> threads;
+
+static std::chrono::steady_clock::time_point deadline_of(TickType_t ticks)
+{
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds((uint64_t)ticks * portTICK_PERIOD_MS);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *created, BaseType_t core_id)
+{
+    host_task *t = new host_task();
+    if (created)
+        *created = t;
+    std::lock_guard<std::mutex> g(threads_lock);
+    threads.emplace_back([t, fn, arg]()
+                         {
+                             current_task = t;
+                             fn(arg);
+                         });
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *created)
+{
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, arg, priority, created, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds((uint64_t)ticks * portTICK_PERIOD_MS));
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - boot_time);
+    return (TickType_t)(ms.count() / portTICK_PERIOD_MS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (!current_task)
+        current_task = new host_task();
+    return current_task;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    {
+        std::lock_guard<std::mutex> g(task->m);
+        task->notify++;
+    }
+    task->cv.notify_one();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    xTaskNotifyGive(task);
+    if (woken)
+        *woken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    host_task *t = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> l(t->m);
+    if (ticks == portMAX_DELAY)
+        t->cv.wait(l, [t]
+                   { return t->notify > 0; });
+    else
+        t->cv.wait_until(l, deadline_of(ticks), [t]
+                         { return t->notify > 0; });
+    uint32_t v = t->notify;
+    if (v)
+        t->notify = clear_on_exit ? 0 : v - 1;
+    return v;
+}
+
+void host_task_join_all(void)
+{
+    for (;;)
+    {
+        std::vector<std::thread> batch;
+        {
+            std::lock_guard<std::mutex> g(threads_lock);
+            batch.swap(threads);
+        }
+        if (batch.empty())
+            return;
+        for (auto &th : batch)
+            th.join();
+    }
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    host_queue *q = new host_queue();
+    q->length = length;
+    q->item_size = item_size;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    delete q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> l(q->m);
+    auto has_room = [q]
+    { return q->items.size() < q->length; };
+    if (ticks == portMAX_DELAY)
+        q->not_full.wait(l, has_room);
+    else if (!q->not_full.wait_until(l, deadline_of(ticks), has_room))
+        return pdFALSE;
+    const uint8_t *p = (const uint8_t *)item;
+    q->items.emplace_back(p, p + q->item_size);
+    l.unlock();
+    q->not_empty.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken)
+{
+    BaseType_t ok = xQueueSend(q, item, 0);
+    if (ok && woken)
+        *woken = pdTRUE;
+    return ok;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> l(q->m);
+    auto has_item = [q]
+    { return !q->items.empty(); };
+    if (ticks == portMAX_DELAY)
+        q->not_empty.wait(l, has_item);
+    else if (!q->not_empty.wait_until(l, deadline_of(ticks), has_item))
+        return pdFALSE;
+    memcpy(item, q->items.front().data(), q->item_size);
+    q->items.pop_front();
+    l.unlock();
+    q->not_full.notify_one();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    std::lock_guard<std::mutex> g(q->m);
+    return (UBaseType_t)q->items.size();
+}
@@ -0,0 +1,256 @@
+/* i2s_stub.cpp - I2S RX stand-in: a "DMA" thread fills a ring of buffers from a PCM source */
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "driver/i2s_std.h"
+#include "i2s_stub.h"
+
+struct host_i2s_chan
+{
+    uint32_t desc_num;
+    uint32_t frame_num;
+    uint32_t sample_rate = 16000;
+    std::vector<std::vector<int16_t>> dma;
+    std::vector<void *> dma_ptr;
+    i2s_event_callbacks_t cbs = {};
+    void *user = NULL;
+
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<uint32_t> filled; // driver message queue of completed DMA buffers
+    uint32_t read_off = 0;       // bytes already consumed from filled.front()
+    bool enabled = false;
+    std::thread dma_thread;
+};
+
+static const int16_t *src_pcm = NULL;
+static size_t src_samples = 0;
+static bool src_loop = false;
+static double speed = 1.0;
+static bool (*gate)(void) = NULL;
+static std::atomic<bool> done(false);
+static std::atomic<uint64_t> delivered(0);
+static host_i2s_chan *active = NULL;
+
+void i2s_stub_set_source(const int16_t *pcm, size_t samples, bool loop)
+{
+    src_pcm = pcm;
+    src_samples = samples;
+    src_loop = loop;
+    done = false;
+    delivered = 0;
+}
+
+void i2s_stub_set_speed(double factor)
+{
+    speed = factor;
+}
+
+void i2s_stub_set_gate(bool (*ready)(void))
+{
+    gate = ready;
+}
+
+bool i2s_stub_is_dma_buffer(const void *p)
+{
+    if (!active)
+        return false;
+    return std::find(active->dma_ptr.begin(), active->dma_ptr.end(), p) != active->dma_ptr.end();
+}
+
+bool i2s_stub_overlaps_dma(const void *p, size_t len)
+{
+    if (!active)
+        return false;
+    const uint8_t *a = (const uint8_t *)p;
+    size_t buf_bytes = active->frame_num * sizeof(int16_t);
+    for (void *d : active->dma_ptr)
+    {
+        const uint8_t *b = (const uint8_t *)d;
+        if (a < b + buf_bytes && b < a + len)
+            return true;
+    }
+    return false;
+}
+
+bool i2s_stub_done(void)
+{
+    return done.load();
+}
+
+uint64_t i2s_stub_samples_delivered(void)
+{
+    return delivered.load();
+}
+
+static void dma_loop(host_i2s_chan *ch)
+{
+    size_t pos = 0;
+    uint32_t k = 0;
+    auto next = std::chrono::steady_clock::now();
+    auto period = std::chrono::duration<double>(speed > 0 ? ch->frame_num / (ch->sample_rate * speed) : 0.0);
+
+    for (;;)
+    {
+        if (!src_loop && pos >= src_samples)
+            break;
+
+        // the DMA engine writes the buffer; on target this costs no CPU, so it is not a memcpy we count
+        int16_t *dst = ch->dma[k].data();
+        for (uint32_t i = 0; i < ch->frame_num; ++i)
+        {
+            if (pos >= src_samples && src_loop && src_samples)
+                pos = 0;
+            dst[i] = pos < src_samples ? src_pcm[pos] : 0;
+            pos++;
+        }
+
+        if (speed > 0)
+        {
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+            std::this_thread::sleep_until(next);
+        }
+        else if (gate)
+        {
+            while (!gate() && ch->enabled)
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+
+        std::unique_lock<std::mutex> l(ch->m);
+        if (!ch->enabled)
+            return;
+        if (speed <= 0 && !ch->cbs.on_recv)
+            ch->cv.wait(l, [ch]
+                        { return ch->filled.size() < ch->desc_num || !ch->enabled; });
+        if (!ch->enabled)
+            return;
+        if (ch->filled.size() == ch->desc_num)
+        {
+            ch->filled.pop_front(); // queue overflow: the driver drops the oldest buffer
+            ch->read_off = 0;
+        }
+        ch->filled.push_back(k);
+        l.unlock();
+        ch->cv.notify_all();
+
+        delivered += ch->frame_num;
+        if (ch->cbs.on_recv)
+        {
+            i2s_event_data_t ev = {};
+            ev.data = &ch->dma_ptr[k];
+            ev.dma_buf = ch->dma_ptr[k];
+            ev.size = ch->frame_num * sizeof(int16_t);
+            ch->cbs.on_recv(ch, &ev, ch->user);
+        }
+        k = (k + 1) % ch->desc_num;
+    }
+
+    done = true;
+    ch->cv.notify_all();
+}
+
+esp_err_t i2s_new_channel(const i2s_chan_config_t *chan_cfg, i2s_chan_handle_t *ret_tx, i2s_chan_handle_t *ret_rx)
+{
+    if (!ret_rx || chan_cfg->dma_desc_num < 2 || chan_cfg->dma_frame_num == 0)
+        return ESP_ERR_INVALID_ARG;
+    host_i2s_chan *ch = new host_i2s_chan();
+    ch->desc_num = chan_cfg->dma_desc_num;
+    ch->frame_num = chan_cfg->dma_frame_num;
+    ch->dma.assign(ch->desc_num, std::vector<int16_t>(ch->frame_num));
+    for (auto &b : ch->dma)
+        ch->dma_ptr.push_back(b.data());
+    *ret_rx = ch;
+    active = ch;
+    return ESP_OK;
+}
+
+esp_err_t i2s_del_channel(i2s_chan_handle_t handle)
+{
+    i2s_channel_disable(handle);
+    if (active == handle)
+        active = NULL;
+    delete handle;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_init_std_mode(i2s_chan_handle_t handle, const i2s_std_config_t *std_cfg)
+{
+    handle->sample_rate = std_cfg->clk_cfg.sample_rate_hz;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_register_event_callback(i2s_chan_handle_t handle, const i2s_event_callbacks_t *callbacks, void *user_data)
+{
+    if (handle->enabled)
+        return ESP_ERR_INVALID_STATE;
+    handle->cbs = *callbacks;
+    handle->user = user_data;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_enable(i2s_chan_handle_t handle)
+{
+    if (handle->enabled)
+        return ESP_ERR_INVALID_STATE;
+    handle->enabled = true;
+    handle->dma_thread = std::thread(dma_loop, handle);
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_disable(i2s_chan_handle_t handle)
+{
+    {
+        std::lock_guard<std::mutex> g(handle->m);
+        if (!handle->enabled)
+            return ESP_ERR_INVALID_STATE;
+        handle->enabled = false;
+    }
+    handle->cv.notify_all();
+    if (handle->dma_thread.joinable())
+        handle->dma_thread.join();
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_read(i2s_chan_handle_t handle, void *dest, size_t size, size_t *bytes_read, uint32_t timeout_ms)
+{
+    uint8_t *out = (uint8_t *)dest;
+    size_t got = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    std::unique_lock<std::mutex> l(handle->m);
+
+    while (got < size)
+    {
+        auto ready = [handle]
+        { return !handle->filled.empty() || !handle->enabled || done.load(); };
+        if (timeout_ms == portMAX_DELAY)
+            handle->cv.wait(l, ready);
+        else if (!handle->cv.wait_until(l, deadline, ready))
+            break;
+        if (handle->filled.empty())
+            break;
+
+        const uint8_t *buf = (const uint8_t *)handle->dma_ptr[handle->filled.front()];
+        size_t buf_bytes = handle->frame_num * sizeof(int16_t);
+        size_t n = std::min(size - got, buf_bytes - handle->read_off);
+        memcpy(out + got, buf + handle->read_off, n);
+        got += n;
+        handle->read_off += n;
+        if (handle->read_off == buf_bytes)
+        {
+            handle->filled.pop_front();
+            handle->read_off = 0;
+            handle->cv.notify_all();
+        }
+    }
+
+    *bytes_read = got;
+    if (got == 0)
+        return (done.load() || !handle->enabled) ? ESP_ERR_INVALID_STATE : ESP_ERR_TIMEOUT;
+    return ESP_OK;
+}
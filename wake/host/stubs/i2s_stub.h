@@ -0,0 +1,27 @@
+/* i2s_stub.h - controls for the host I2S stand-in: what it streams and how fast */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* PCM the RX channel streams once enabled; not copied, must outlive the channel */
+void i2s_stub_set_source(const int16_t *pcm, size_t samples, bool loop);
+
+/* 1.0 = real time, 4.0 = four times faster, 0 = as fast as the reader drains it */
+void i2s_stub_set_speed(double factor);
+
+/* speed 0 only: the DMA thread waits until ready() before delivering each
+ * buffer, so a consumer further down the pipeline can apply backpressure */
+void i2s_stub_set_gate(bool (*ready)(void));
+
+/* true when p is the start of one of the channel's DMA buffers */
+bool i2s_stub_is_dma_buffer(const void *p);
+
+/* true when [p, p + len) touches any DMA buffer */
+bool i2s_stub_overlaps_dma(const void *p, size_t len);
+
+/* true once a non-looping source has been fully delivered */
+bool i2s_stub_done(void);
+
+/* samples delivered to DMA buffers so far */
+uint64_t i2s_stub_samples_delivered(void);
@@ -0,0 +1,40 @@
+/* esp_afe_config.h - host stand-in; only the fields the wake firmware touches */
+#pragma once
+
+#include "model_path.h"
+#include "esp_wn_iface.h"
+
+typedef enum
+{
+    AFE_TYPE_SR = 0,
+    AFE_TYPE_VC = 1,
+} afe_type_t;
+
+typedef enum
+{
+    AFE_MODE_LOW_COST = 0,
+    AFE_MODE_HIGH_PERF = 1,
+} afe_mode_t;
+
+typedef struct
+{
+    afe_type_t afe_type;
+    afe_mode_t afe_mode;
+    char input_format[8];
+    bool wakenet_init;
+    char *wakenet_model_name;
+    char *wakenet_model_name_2;
+    det_mode_t wakenet_mode;
+    bool vad_init;
+    bool ns_init;
+    bool agc_init;
+    bool aec_init;
+    int afe_perferred_core;
+    int afe_perferred_priority;
+    int afe_ringbuf_size;
+    int memory_alloc_mode;
+    int feed_chunk_samples; // host only: stand-in chunk geometry
+} afe_config_t;
+
+afe_config_t *afe_config_init(const char *input_format, srmodel_list_t *models, afe_type_t type, afe_mode_t mode);
+void afe_config_free(afe_config_t *afe_config);
@@ -0,0 +1,49 @@
+/* esp_afe_sr_iface.h - host stand-in for the AFE speech-recognition interface (see sr_stub.h) */
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_afe_config.h"
+#include "esp_wn_iface.h"
+
+typedef enum
+{
+    AFE_VAD_SILENCE = 0,
+    AFE_VAD_SPEECH = 1,
+} afe_vad_state_t;
+
+typedef struct
+{
+    int16_t *data;
+    int data_size;
+    int trigger_channel_id;
+    int wake_word_index;
+    int wakenet_model_index;
+    float data_volume;
+    afe_vad_state_t vad_state;
+    wakenet_state_t wakeup_state;
+    int wake_word_length;
+    int ret_value;
+    int16_t *raw_data;
+    int raw_data_channels;
+} afe_fetch_result_t;
+
+typedef struct esp_afe_sr_data_t esp_afe_sr_data_t;
+
+typedef struct
+{
+    esp_afe_sr_data_t *(*create_from_config)(afe_config_t *afe_config);
+    int (*feed)(esp_afe_sr_data_t *afe, const int16_t *in);
+    afe_fetch_result_t *(*fetch)(esp_afe_sr_data_t *afe);
+    afe_fetch_result_t *(*fetch_with_delay)(esp_afe_sr_data_t *afe, TickType_t ticks_to_wait);
+    int (*reset_buffer)(esp_afe_sr_data_t *afe);
+    int (*get_feed_chunksize)(esp_afe_sr_data_t *afe);
+    int (*get_fetch_chunksize)(esp_afe_sr_data_t *afe);
+    int (*get_feed_channel_num)(esp_afe_sr_data_t *afe);
+    int (*get_fetch_channel_num)(esp_afe_sr_data_t *afe);
+    int (*get_samp_rate)(esp_afe_sr_data_t *afe);
+    int (*set_wakenet)(esp_afe_sr_data_t *afe, char *model_name);
+    int (*disable_wakenet)(esp_afe_sr_data_t *afe);
+    int (*enable_wakenet)(esp_afe_sr_data_t *afe);
+    void (*destroy)(esp_afe_sr_data_t *afe);
+} esp_afe_sr_iface_t;
@@ -0,0 +1,6 @@
+/* esp_afe_sr_models.h - host stand-in */
+#pragma once
+
+#include "esp_afe_sr_iface.h"
+
+esp_afe_sr_iface_t *esp_afe_handle_from_config(const afe_config_t *config);
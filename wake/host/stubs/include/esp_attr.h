@@ -0,0 +1,6 @@
+/* esp_attr.h - host stand-in */
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_BSS_ATTR
@@ -0,0 +1,6 @@
+/* esp_mn_models.h - host stand-in */
+#pragma once
+
+#include "esp_mn_iface.h"
+
+esp_mn_iface_t *esp_mn_handle_from_name(char *model_name);
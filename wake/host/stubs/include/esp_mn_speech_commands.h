@@ -0,0 +1,29 @@
+/* esp_mn_speech_commands.h - host stand-in for the MultiNet command list API */
+#pragma once
+
+#include "esp_err.h"
+#include "esp_mn_iface.h"
+
+typedef struct
+{
+    char *string;
+    char *phonemes;
+    int16_t command_id;
+    float threshold;
+    int16_t *wave;
+} esp_mn_phrase_t;
+
+typedef struct
+{
+    int num;
+    esp_mn_phrase_t **phrases;
+} esp_mn_error_t;
+
+/* The command list is one global, bound to an instance by alloc; update loads it into that instance. */
+esp_err_t esp_mn_commands_alloc(esp_mn_iface_t *multinet, model_iface_data_t *model_data);
+void esp_mn_commands_free(void);
+esp_err_t esp_mn_commands_add(int command_id, const char *phrase_string);
+esp_err_t esp_mn_commands_remove(const char *phrase_string);
+esp_err_t esp_mn_commands_clear(void);
+esp_mn_error_t *esp_mn_commands_update(void);
+esp_mn_phrase_t *esp_mn_commands_get_from_index(int index);
@@ -0,0 +1,8 @@
+/* esp_process_sdkconfig.h - host stand-in */
+#pragma once
+
+#include "esp_err.h"
+#include "esp_mn_iface.h"
+#include "esp_mn_speech_commands.h"
+
+esp_mn_error_t *esp_mn_commands_update_from_sdkconfig(esp_mn_iface_t *multinet, model_iface_data_t *model_data);
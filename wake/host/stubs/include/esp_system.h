@@ -0,0 +1,6 @@
+/* esp_system.h - host stand-in */
+#pragma once
+
+#include "esp_err.h"
+
+void esp_restart(void) __attribute__((noreturn));
@@ -0,0 +1,6 @@
+/* esp_timer.h - host stand-in: microseconds since process start */
+#pragma once
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
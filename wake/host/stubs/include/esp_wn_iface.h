@@ -0,0 +1,17 @@
+/* esp_wn_iface.h - host stand-in */
+#pragma once
+
+typedef enum
+{
+    WAKENET_NO_DETECT = 0,
+    WAKENET_CHANNEL_VERIFIED = -1,
+    WAKENET_DETECTED = 1,
+} wakenet_state_t;
+
+typedef enum
+{
+    DET_MODE_90 = 0,
+    DET_MODE_95 = 1,
+} det_mode_t;
+
+typedef struct model_iface_data_t model_iface_data_t;
@@ -0,0 +1,4 @@
+/* esp_wn_models.h - host stand-in */
+#pragma once
+
+#include "esp_wn_iface.h"
@@ -0,0 +1,42 @@
+/* semphr.h - host stand-in: semaphores are queues of one-byte tokens, as in FreeRTOS */
+#pragma once
+
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xQueueCreate(1, 1);
+}
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t s = xQueueCreate(1, 1);
+    uint8_t token = 0;
+    xQueueSend(s, &token, 0);
+    return s;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks)
+{
+    uint8_t token;
+    return xQueueReceive(s, &token, ticks);
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    uint8_t token = 0;
+    return xQueueSend(s, &token, 0);
+}
+
+static inline BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t s, BaseType_t *woken)
+{
+    uint8_t token = 0;
+    return xQueueSendFromISR(s, &token, woken);
+}
+
+static inline void vSemaphoreDelete(SemaphoreHandle_t s)
+{
+    vQueueDelete(s);
+}
@@ -0,0 +1,20 @@
+/* model_path.h - host stand-in for the esp-sr model partition index */
+#pragma once
+
+typedef struct
+{
+    char **model_name;
+    char **model_info;
+    void **model_data;
+    int num;
+} srmodel_list_t;
+
+#define ESP_WN_PREFIX "wn"
+#define ESP_MN_PREFIX "mn"
+#define ESP_MN_ENGLISH "en"
+#define ESP_MN_CHINESE "cn"
+
+srmodel_list_t *esp_srmodel_init(const char *partition_label);
+void esp_srmodel_deinit(srmodel_list_t *models);
+char *esp_srmodel_filter(srmodel_list_t *models, const char *keyword1, const char *keyword2);
+int esp_srmodel_exists(srmodel_list_t *models, char *model_name);
@@ -0,0 +1,76 @@
+/* sdkconfig.h - host stand-in for the generated ESP-IDF config; targets override with -D */
+#pragma once
+
+#if !defined(CONFIG_WAKE_CAPTURE_RING) && !defined(CONFIG_WAKE_CAPTURE_ZERO_COPY)
+#define CONFIG_WAKE_CAPTURE_RING 1
+#endif
+
+#if !defined(CONFIG_WAKE_DETECT_NOTIFY) && !defined(CONFIG_WAKE_DETECT_POLL)
+#define CONFIG_WAKE_DETECT_NOTIFY 1
+#endif
+
+#if !defined(CONFIG_WAKE_LOG_PROFILE_PRODUCTION) && !defined(CONFIG_WAKE_LOG_PROFILE_TRACE)
+#define CONFIG_WAKE_LOG_PROFILE_DIAGNOSTIC 1
+#endif
+
+#define CONFIG_FREERTOS_HZ 1000
+#define CONFIG_HEAP_USE_HOOKS 1
+
+/* Kconfig.projbuild defaults */
+#ifndef CONFIG_WAKE_STATS_WINDOW_MS
+#define CONFIG_WAKE_STATS_WINDOW_MS 5000
+#endif
+#ifndef CONFIG_WAKE_STATS_SILENT_RMS
+#define CONFIG_WAKE_STATS_SILENT_RMS 2
+#endif
+#ifndef CONFIG_WAKE_ARENA_INTERNAL_BUDGET_KB
+#define CONFIG_WAKE_ARENA_INTERNAL_BUDGET_KB 32
+#endif
+#ifndef CONFIG_WAKE_EVENT_LOG_RECORDS
+#define CONFIG_WAKE_EVENT_LOG_RECORDS 128
+#endif
+#ifndef CONFIG_WAKE_LED_FADE_MS
+#define CONFIG_WAKE_LED_FADE_MS 200
+#endif
+#ifndef CONFIG_WAKE_LINK
+#define CONFIG_WAKE_LINK 1
+#endif
+#ifndef CONFIG_WAKE_LINK_UART_NUM
+#define CONFIG_WAKE_LINK_UART_NUM 1
+#endif
+#ifndef CONFIG_WAKE_LINK_TX_GPIO
+#define CONFIG_WAKE_LINK_TX_GPIO 17
+#endif
+#ifndef CONFIG_WAKE_LINK_BAUD
+#define CONFIG_WAKE_LINK_BAUD 921600
+#endif
+#ifndef CONFIG_WAKE_CMD_TABLE
+#define CONFIG_WAKE_CMD_TABLE 1
+#endif
+#ifndef CONFIG_WAKE_CMD_TABLE_PARTITION
+#define CONFIG_WAKE_CMD_TABLE_PARTITION "commands"
+#endif
+#ifndef CONFIG_WAKE_GATE_OPEN_DB_X10
+#define CONFIG_WAKE_GATE_OPEN_DB_X10 90
+#endif
+#ifndef CONFIG_WAKE_GATE_MIN_RMS
+#define CONFIG_WAKE_GATE_MIN_RMS 64
+#endif
+#ifndef CONFIG_WAKE_GATE_HOLD_MS
+#define CONFIG_WAKE_GATE_HOLD_MS 1500
+#endif
+#ifndef CONFIG_WAKE_GATE_PREROLL_MS
+#define CONFIG_WAKE_GATE_PREROLL_MS 480
+#endif
+#ifndef CONFIG_WAKE_SILENCE_CALIB_MS
+#define CONFIG_WAKE_SILENCE_CALIB_MS 3000
+#endif
+#ifndef CONFIG_WAKE_SILENCE_MARGIN_DB_X10
+#define CONFIG_WAKE_SILENCE_MARGIN_DB_X10 30
+#endif
+#ifndef CONFIG_WAKE_SILENCE_GRACE_S
+#define CONFIG_WAKE_SILENCE_GRACE_S 20
+#endif
+#ifndef CONFIG_WAKE_LATENCY_REPORT_S
+#define CONFIG_WAKE_LATENCY_REPORT_S 60
+#endif
@@ -0,0 +1,102 @@
+/* partition_stub.cpp - RAM-backed flash partitions with NOR write semantics for the host build */
+#include <string.h>
+#include <mutex>
+#include <vector>
+#include "partition_stub.h"
+
+#define STUB_SECTOR 4096
+
+struct stub_partition_t
+{
+    esp_partition_t part;
+    std::vector<uint8_t> data;
+};
+
+static std::mutex parts_lock;
+static std::vector<stub_partition_t *> parts;
+static partition_stub_counters_t counters;
+
+const esp_partition_t *partition_stub_add(const char *label, uint8_t subtype, size_t size)
+{
+    stub_partition_t *p = new stub_partition_t();
+    p->part.type = ESP_PARTITION_TYPE_DATA;
+    p->part.subtype = (esp_partition_subtype_t)subtype;
+    p->part.size = (uint32_t)size;
+    p->part.erase_size = STUB_SECTOR;
+    strncpy(p->part.label, label, sizeof(p->part.label) - 1);
+    p->data.assign(size, 0xFF);
+    std::lock_guard<std::mutex> g(parts_lock);
+    p->part.address = 0x400000 + (uint32_t)parts.size() * 0x100000;
+    parts.push_back(p);
+    return &p->part;
+}
+
+static stub_partition_t *of(const esp_partition_t *partition)
+{
+    return (stub_partition_t *)partition; // part is the first member
+}
+
+uint8_t *partition_stub_data(const esp_partition_t *partition)
+{
+    return of(partition)->data.data();
+}
+
+void partition_stub_get_counters(partition_stub_counters_t *out)
+{
+    std::lock_guard<std::mutex> g(parts_lock);
+    *out = counters;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    std::lock_guard<std::mutex> g(parts_lock);
+    for (stub_partition_t *p : parts)
+    {
+        if ((type == ESP_PARTITION_TYPE_ANY || p->part.type == type) &&
+            (subtype == ESP_PARTITION_SUBTYPE_ANY || p->part.subtype == subtype) &&
+            (!label || strcmp(p->part.label, label) == 0))
+            return &p->part;
+    }
+    return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    if (src_offset + size > partition->size)
+        return ESP_ERR_INVALID_SIZE;
+    std::lock_guard<std::mutex> g(parts_lock);
+    memcpy(dst, of(partition)->data.data() + src_offset, size);
+    counters.reads++;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    if (dst_offset + size > partition->size)
+        return ESP_ERR_INVALID_SIZE;
+    std::lock_guard<std::mutex> g(parts_lock);
+    uint8_t *d = of(partition)->data.data() + dst_offset;
+    const uint8_t *s = (const uint8_t *)src;
+    bool unerased = false;
+    for (size_t i = 0; i < size; ++i)
+    {
+        unerased |= (s[i] & ~d[i]) != 0;
+        d[i] &= s[i];
+    }
+    counters.writes++;
+    counters.unerased_writes += unerased;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    if (offset % STUB_SECTOR || size % STUB_SECTOR)
+        return ESP_ERR_INVALID_ARG;
+    if (offset + size > partition->size)
+        return ESP_ERR_INVALID_SIZE;
+    std::lock_guard<std::mutex> g(parts_lock);
+    memset(of(partition)->data.data() + offset, 0xFF, size);
+    counters.erased_sectors += size / STUB_SECTOR;
+    return ESP_OK;
+}
@@ -0,0 +1,25 @@
+/* partition_stub.h - controls for the host flash partition stand-in
+ *
+ * Partitions live in RAM and behave like NOR flash: erase sets whole 4 KB
+ * sectors to 0xFF and a write can only clear bits, so writing over data that
+ * was not erased first corrupts it the way it would on the chip.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_partition.h"
+
+typedef struct
+{
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t erased_sectors;
+    uint64_t unerased_writes; // writes that tried to set a cleared bit
+} partition_stub_counters_t;
+
+/* A data partition of `size` bytes (a multiple of 4096), erased. */
+const esp_partition_t *partition_stub_add(const char *label, uint8_t subtype, size_t size);
+/* the partition's bytes, to plant images or tear writes */
+uint8_t *partition_stub_data(const esp_partition_t *partition);
+void partition_stub_get_counters(partition_stub_counters_t *out);
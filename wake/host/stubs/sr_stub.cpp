@@ -0,0 +1,678 @@
+/* sr_stub.cpp - scripted AFE / MultiNet stand-ins and the model partition index for the host build */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "esp_afe_sr_models.h"
+#include "esp_mn_models.h"
+#include "esp_process_sdkconfig.h"
+#include "esp_system.h"
+#include "model_path.h"
+#include "sr_stub.h"
+
+#define STUB_CHUNK 512       // WakeNet9 / MultiNet chunk at 16 kHz
+#define STUB_RINGBUF_CHUNKS 50
+
+struct stub_chunk_t
+{
+    std::vector<int16_t> pcm;
+    uint64_t end; // input sample offset just past the chunk
+};
+
+struct esp_afe_sr_data_t
+{
+    int chunk;
+    int channels;
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<stub_chunk_t> queue;
+    std::vector<int16_t> out; // owned by the last fetch result
+    afe_fetch_result_t res;
+    uint64_t in_samples = 0;  // samples fed
+    uint64_t fed_samples = 0; // input offset just past the last fetched chunk
+    bool wakenet_enabled = true;
+};
+
+struct model_iface_data_t
+{
+    int duration_samples;
+    uint64_t since;
+    esp_mn_results_t results;
+    std::vector<int> command_ids; // loaded by esp_mn_commands_update(); empty: every scripted command is known
+};
+
+struct stub_phrase_t
+{
+    std::string text;
+    esp_mn_phrase_t phrase;
+};
+
+static std::mutex script_lock;
+static std::vector<sr_stub_event_t> script;
+static size_t next_wake = 0;
+static size_t next_cmd = 0;
+static uint32_t feed_cost_us = 0;
+static uint32_t fetch_cost_us = 0;
+static std::atomic<uint64_t> fetch_pos(0);
+static sr_stub_counters_t counters;
+static std::mutex counters_lock;
+static esp_afe_sr_data_t *active_afe = NULL;
+static uint64_t (*skip_source)(void) = NULL;
+static uint32_t commands_cost_us = 0;
+static std::vector<stub_phrase_t> mn_commands; // the esp_mn_commands_* list
+static model_iface_data_t *mn_commands_target = NULL;
+static std::atomic<model_iface_data_t *> mn_detecting(NULL);
+
+typedef std::chrono::steady_clock clk;
+
+static uint64_t elapsed_ns(clk::time_point t0)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clk::now() - t0).count();
+}
+
+static void burn_us(uint32_t us)
+{
+    if (!us)
+        return;
+    auto end = clk::now() + std::chrono::microseconds(us);
+    while (clk::now() < end)
+    {
+    }
+}
+
+int sr_stub_parse_script(const char *spec, int sample_rate, sr_stub_event_t *out, int max)
+{
+    int n = 0;
+    const char *p = spec;
+    while (p && *p)
+    {
+        if (n == max)
+            return -1;
+        sr_stub_event_t ev = {};
+        ev.prob = 0.9f;
+        char *end = NULL;
+        if (strncmp(p, "wake", 4) == 0)
+        {
+            ev.type = SR_STUB_WAKE;
+            p += 4;
+        }
+        else if (strncmp(p, "cmd", 3) == 0)
+        {
+            ev.type = SR_STUB_COMMAND;
+            ev.command_id = (int)strtol(p + 3, &end, 10);
+            if (end == p + 3)
+                return -1;
+            p = end;
+            if (*p == ':')
+            {
+                ev.prob = strtof(p + 1, &end);
+                p = end;
+            }
+        }
+        else
+        {
+            return -1;
+        }
+        if (*p != '@')
+            return -1;
+        double sec = strtod(p + 1, &end);
+        if (end == p + 1)
+            return -1;
+        ev.sample = (uint64_t)(sec * sample_rate);
+        out[n++] = ev;
+        p = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',')
+            return -1;
+    }
+    return n;
+}
+
+void sr_stub_set_script(const sr_stub_event_t *events, size_t n)
+{
+    std::lock_guard<std::mutex> g(script_lock);
+    script.assign(events, events + n);
+    std::stable_sort(script.begin(), script.end(), [](const sr_stub_event_t &a, const sr_stub_event_t &b)
+                     { return a.sample < b.sample; });
+    next_wake = 0;
+    next_cmd = 0;
+}
+
+void sr_stub_set_cost_us(uint32_t feed_us, uint32_t fetch_us)
+{
+    feed_cost_us = feed_us;
+    fetch_cost_us = fetch_us;
+}
+
+void sr_stub_set_commands_cost_us(uint32_t update_us)
+{
+    commands_cost_us = update_us;
+}
+
+model_iface_data_t *sr_stub_mn_detecting(void)
+{
+    return mn_detecting.load();
+}
+
+size_t sr_stub_mn_commands(const model_iface_data_t *mn, int *ids, size_t max)
+{
+    size_t n = std::min(max, mn->command_ids.size());
+    std::copy(mn->command_ids.begin(), mn->command_ids.begin() + n, ids);
+    return mn->command_ids.size();
+}
+
+size_t sr_stub_backlog(void)
+{
+    if (!active_afe)
+        return 0;
+    std::lock_guard<std::mutex> g(active_afe->m);
+    return active_afe->queue.size();
+}
+
+void sr_stub_set_skip_source(uint64_t (*skipped_chunks)(void))
+{
+    skip_source = skipped_chunks;
+}
+
+uint64_t sr_stub_fetch_position(void)
+{
+    return fetch_pos.load();
+}
+
+void sr_stub_get_counters(sr_stub_counters_t *out)
+{
+    std::lock_guard<std::mutex> g(counters_lock);
+    *out = counters;
+}
+
+/* first unconsumed scripted event of `type` that falls before `end`, or NULL */
+static const sr_stub_event_t *take_event(sr_stub_event_type_t type, uint64_t end)
+{
+    std::lock_guard<std::mutex> g(script_lock);
+    size_t &next = type == SR_STUB_WAKE ? next_wake : next_cmd;
+    while (next < script.size() && script[next].type != type)
+        next++;
+    if (next < script.size() && script[next].sample < end)
+        return &script[next++];
+    return NULL;
+}
+
+/* scripted events of `type` inside audio the pipeline never fed (before `begin`) are lost, not deferred */
+static uint64_t skip_events(sr_stub_event_type_t type, uint64_t begin)
+{
+    uint64_t n = 0;
+    const sr_stub_event_t *ev;
+    while ((ev = take_event(type, begin)) != NULL)
+        n++;
+    return n;
+}
+
+/* ---------------- model partition ---------------- */
+
+static char wn_name[] = "wn9_hilexin";
+static char mn_name[] = "mn5q8_en";
+static char *stub_names[] = {wn_name, mn_name};
+static char *stub_info[] = {wn_name, mn_name};
+
+srmodel_list_t *esp_srmodel_init(const char *partition_label)
+{
+    {
+        std::lock_guard<std::mutex> g(counters_lock);
+        counters.srmodel_inits++;
+    }
+    srmodel_list_t *models = (srmodel_list_t *)calloc(1, sizeof(srmodel_list_t));
+    models->model_name = stub_names;
+    models->model_info = stub_info;
+    models->num = 2;
+    return models;
+}
+
+void esp_srmodel_deinit(srmodel_list_t *models)
+{
+    free(models);
+}
+
+char *esp_srmodel_filter(srmodel_list_t *models, const char *keyword1, const char *keyword2)
+{
+    if (!models)
+        return NULL;
+    for (int i = 0; i < models->num; ++i)
+    {
+        const char *name = models->model_name[i];
+        if ((!keyword1 || strstr(name, keyword1)) && (!keyword2 || strstr(name, keyword2)))
+            return models->model_name[i];
+    }
+    return NULL;
+}
+
+int esp_srmodel_exists(srmodel_list_t *models, char *model_name)
+{
+    for (int i = 0; models && i < models->num; ++i)
+    {
+        if (strcmp(models->model_name[i], model_name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/* ---------------- AFE ---------------- */
+
+afe_config_t *afe_config_init(const char *input_format, srmodel_list_t *models, afe_type_t type, afe_mode_t mode)
+{
+    afe_config_t *cfg = (afe_config_t *)calloc(1, sizeof(afe_config_t));
+    cfg->afe_type = type;
+    cfg->afe_mode = mode;
+    snprintf(cfg->input_format, sizeof(cfg->input_format), "%s", input_format);
+    cfg->wakenet_init = true;
+    cfg->wakenet_model_name = esp_srmodel_filter(models, ESP_WN_PREFIX, NULL);
+    cfg->vad_init = true;
+    cfg->afe_ringbuf_size = STUB_RINGBUF_CHUNKS;
+    cfg->feed_chunk_samples = STUB_CHUNK;
+    return cfg;
+}
+
+void afe_config_free(afe_config_t *afe_config)
+{
+    free(afe_config);
+}
+
+static esp_afe_sr_data_t *afe_create(afe_config_t *cfg)
+{
+    esp_afe_sr_data_t *afe = new esp_afe_sr_data_t();
+    afe->chunk = cfg->feed_chunk_samples;
+    afe->channels = 0;
+    for (const char *c = cfg->input_format; *c; ++c)
+        afe->channels += (*c == 'M' || *c == 'R');
+    if (afe->channels == 0)
+        afe->channels = 1;
+    afe->wakenet_enabled = cfg->wakenet_init;
+    active_afe = afe;
+    {
+        std::lock_guard<std::mutex> g(script_lock);
+        next_wake = next_cmd = 0; // input offsets restart with every AFE instance
+    }
+    return afe;
+}
+
+static int afe_feed(esp_afe_sr_data_t *afe, const int16_t *in)
+{
+    auto t0 = clk::now();
+    burn_us(feed_cost_us);
+    // keep only the first (mic) channel; the stand-in has no AEC reference to use
+    stub_chunk_t chunk;
+    chunk.pcm.resize(afe->chunk);
+    for (int i = 0; i < afe->chunk; ++i)
+        chunk.pcm[i] = in[i * afe->channels];
+    afe->in_samples += afe->chunk;
+    chunk.end = afe->in_samples + (skip_source ? skip_source() * afe->chunk : 0);
+    bool dropped = false;
+    size_t backlog;
+    {
+        std::lock_guard<std::mutex> g(afe->m);
+        if (afe->queue.size() == STUB_RINGBUF_CHUNKS)
+        {
+            afe->queue.pop_front();
+            dropped = true;
+        }
+        afe->queue.push_back(std::move(chunk));
+        backlog = afe->queue.size();
+    }
+    afe->cv.notify_one();
+    std::lock_guard<std::mutex> g(counters_lock);
+    counters.fed_chunks++;
+    counters.dropped_chunks += dropped;
+    counters.max_backlog = std::max<uint64_t>(counters.max_backlog, backlog);
+    counters.feed_ns += elapsed_ns(t0);
+    return afe->chunk;
+}
+
+static afe_fetch_result_t *afe_fetch_wait(esp_afe_sr_data_t *afe, TickType_t ticks)
+{
+    auto t0 = clk::now();
+    std::unique_lock<std::mutex> l(afe->m);
+    auto ready = [afe]
+    { return !afe->queue.empty(); };
+    if (ticks == portMAX_DELAY)
+        afe->cv.wait(l, ready);
+    else
+        afe->cv.wait_for(l, std::chrono::milliseconds((uint64_t)ticks * portTICK_PERIOD_MS), ready);
+    if (afe->queue.empty())
+    {
+        l.unlock();
+        std::lock_guard<std::mutex> g(counters_lock);
+        counters.fetch_empty++;
+        return NULL;
+    }
+    afe->out = std::move(afe->queue.front().pcm);
+    uint64_t end = afe->queue.front().end;
+    afe->queue.pop_front();
+    l.unlock();
+
+    burn_us(fetch_cost_us);
+    uint64_t begin = end - afe->chunk;
+    uint64_t gated = begin > afe->fed_samples ? skip_events(SR_STUB_WAKE, begin) : 0;
+    afe->fed_samples = end;
+    fetch_pos.store(afe->fed_samples);
+
+    memset(&afe->res, 0, sizeof(afe->res));
+    afe->res.data = afe->out.data();
+    afe->res.data_size = afe->chunk * sizeof(int16_t);
+    afe->res.raw_data_channels = 1;
+    afe->res.ret_value = ESP_OK;
+    afe->res.wakeup_state = WAKENET_NO_DETECT;
+    const sr_stub_event_t *ev = afe->wakenet_enabled ? take_event(SR_STUB_WAKE, afe->fed_samples) : NULL;
+    if (ev)
+    {
+        afe->res.wakeup_state = WAKENET_DETECTED;
+        afe->res.wake_word_index = 1;
+        afe->res.wakenet_model_index = 0;
+    }
+
+    std::lock_guard<std::mutex> g(counters_lock);
+    counters.fetched_chunks++;
+    counters.wakes += ev != NULL;
+    counters.gated_wakes += gated;
+    counters.fetch_ns += elapsed_ns(t0);
+    return &afe->res;
+}
+
+static afe_fetch_result_t *afe_fetch(esp_afe_sr_data_t *afe)
+{
+    return afe_fetch_wait(afe, 0);
+}
+
+static int afe_reset_buffer(esp_afe_sr_data_t *afe)
+{
+    std::lock_guard<std::mutex> g(afe->m);
+    afe->queue.clear();
+    return 0;
+}
+
+static int afe_get_chunk(esp_afe_sr_data_t *afe)
+{
+    return afe->chunk;
+}
+
+static int afe_get_feed_channels(esp_afe_sr_data_t *afe)
+{
+    return afe->channels;
+}
+
+static int afe_get_fetch_channels(esp_afe_sr_data_t *afe)
+{
+    return 1;
+}
+
+static int afe_get_samp_rate(esp_afe_sr_data_t *afe)
+{
+    return 16000;
+}
+
+static int afe_set_wakenet(esp_afe_sr_data_t *afe, char *model_name)
+{
+    return 1;
+}
+
+static int afe_disable_wakenet(esp_afe_sr_data_t *afe)
+{
+    afe->wakenet_enabled = false;
+    return 0;
+}
+
+static int afe_enable_wakenet(esp_afe_sr_data_t *afe)
+{
+    afe->wakenet_enabled = true;
+    return 1;
+}
+
+static void afe_destroy(esp_afe_sr_data_t *afe)
+{
+    if (active_afe == afe)
+        active_afe = NULL;
+    delete afe;
+}
+
+static esp_afe_sr_iface_t stub_afe_iface = {
+    afe_create,
+    afe_feed,
+    afe_fetch,
+    afe_fetch_wait,
+    afe_reset_buffer,
+    afe_get_chunk,
+    afe_get_chunk,
+    afe_get_feed_channels,
+    afe_get_fetch_channels,
+    afe_get_samp_rate,
+    afe_set_wakenet,
+    afe_disable_wakenet,
+    afe_enable_wakenet,
+    afe_destroy,
+};
+
+esp_afe_sr_iface_t *esp_afe_handle_from_config(const afe_config_t *config)
+{
+    return &stub_afe_iface;
+}
+
+/* ---------------- MultiNet ---------------- */
+
+static model_iface_data_t *mn_create(const char *model_name, int duration)
+{
+    model_iface_data_t *mn = new model_iface_data_t();
+    mn->duration_samples = duration * 16;
+    mn->since = 0;
+    memset(&mn->results, 0, sizeof(mn->results));
+    std::lock_guard<std::mutex> g(counters_lock);
+    counters.mn_live++;
+    return mn;
+}
+
+static int mn_get_samp_rate(model_iface_data_t *mn)
+{
+    return 16000;
+}
+
+static int mn_get_chunksize(model_iface_data_t *mn)
+{
+    return STUB_CHUNK;
+}
+
+static int mn_get_chunknum(model_iface_data_t *mn)
+{
+    return mn->duration_samples / STUB_CHUNK;
+}
+
+static int mn_set_det_threshold(model_iface_data_t *mn, float det_threshold)
+{
+    return 0;
+}
+
+static char mn_lang[] = "en";
+
+static char *mn_get_language(model_iface_data_t *mn)
+{
+    return mn_lang;
+}
+
+static esp_mn_state_t mn_detect(model_iface_data_t *mn, int16_t *samples)
+{
+    uint64_t pos = sr_stub_fetch_position();
+    const sr_stub_event_t *ev;
+    mn_detecting.store(mn);
+    // commands spoken while MultiNet was not listening are missed, not deferred
+    while ((ev = take_event(SR_STUB_COMMAND, pos)) && ev->sample + 2 * STUB_CHUNK < pos)
+    {
+        std::lock_guard<std::mutex> g(counters_lock);
+        counters.missed_commands++;
+    }
+    if (ev && !mn->command_ids.empty() &&
+        std::find(mn->command_ids.begin(), mn->command_ids.end(), ev->command_id) == mn->command_ids.end())
+    {
+        std::lock_guard<std::mutex> g(counters_lock);
+        counters.unknown_commands++; // not in this instance's command list: MultiNet would not hear it
+        ev = NULL;
+    }
+    if (ev)
+    {
+        memset(&mn->results, 0, sizeof(mn->results));
+        mn->results.state = ESP_MN_STATE_DETECTED;
+        mn->results.num = 1;
+        mn->results.command_id[0] = ev->command_id;
+        mn->results.phrase_id[0] = ev->command_id;
+        mn->results.prob[0] = ev->prob;
+        snprintf(mn->results.string, sizeof(mn->results.string), "command %d", ev->command_id);
+        mn->since = 0;
+        std::lock_guard<std::mutex> g(counters_lock);
+        counters.commands++;
+        return ESP_MN_STATE_DETECTED;
+    }
+
+    mn->since += STUB_CHUNK;
+    if (mn->since >= (uint64_t)mn->duration_samples)
+    {
+        memset(&mn->results, 0, sizeof(mn->results));
+        mn->results.state = ESP_MN_STATE_TIMEOUT;
+        mn->since = 0;
+        std::lock_guard<std::mutex> g(counters_lock);
+        counters.timeouts++;
+        return ESP_MN_STATE_TIMEOUT;
+    }
+    return ESP_MN_STATE_DETECTING;
+}
+
+static void mn_destroy(model_iface_data_t *mn)
+{
+    model_iface_data_t *was = mn;
+    mn_detecting.compare_exchange_strong(was, NULL);
+    delete mn;
+    std::lock_guard<std::mutex> g(counters_lock);
+    counters.mn_live--;
+}
+
+static esp_mn_results_t *mn_get_results(model_iface_data_t *mn)
+{
+    return &mn->results;
+}
+
+static void mn_clean(model_iface_data_t *mn)
+{
+    mn->since = 0;
+}
+
+static void mn_print_commands(model_iface_data_t *mn)
+{
+    printf("stub multinet: commands come from the simulation script\n");
+}
+
+static esp_mn_iface_t stub_mn_iface = {
+    mn_create,
+    mn_get_samp_rate,
+    mn_get_chunksize,
+    mn_get_chunknum,
+    mn_set_det_threshold,
+    mn_get_language,
+    mn_detect,
+    mn_destroy,
+    mn_get_results,
+    mn_clean,
+    mn_print_commands,
+};
+
+esp_mn_iface_t *esp_mn_handle_from_name(char *model_name)
+{
+    return &stub_mn_iface;
+}
+
+/* The stand-in has no Kconfig commands: the list stays empty and the script decides. */
+esp_mn_error_t *esp_mn_commands_update_from_sdkconfig(esp_mn_iface_t *multinet, model_iface_data_t *model_data)
+{
+    esp_mn_commands_alloc(multinet, model_data);
+    return esp_mn_commands_update();
+}
+
+esp_err_t esp_mn_commands_alloc(esp_mn_iface_t *multinet, model_iface_data_t *model_data)
+{
+    mn_commands.clear();
+    mn_commands_target = model_data;
+    return ESP_OK;
+}
+
+void esp_mn_commands_free(void)
+{
+    mn_commands.clear();
+    mn_commands_target = NULL;
+}
+
+esp_err_t esp_mn_commands_add(int command_id, const char *phrase_string)
+{
+    size_t len = strlen(phrase_string);
+    if (!mn_commands_target)
+        return ESP_ERR_INVALID_STATE;
+    if (len == 0 || len > ESP_MN_MAX_PHRASE_LEN)
+        return ESP_ERR_INVALID_ARG;
+    for (const stub_phrase_t &p : mn_commands)
+    {
+        if (p.text == phrase_string)
+            return ESP_ERR_INVALID_STATE;
+    }
+    stub_phrase_t p;
+    p.text = phrase_string;
+    memset(&p.phrase, 0, sizeof(p.phrase));
+    p.phrase.command_id = (int16_t)command_id;
+    mn_commands.push_back(p);
+    return ESP_OK;
+}
+
+esp_err_t esp_mn_commands_remove(const char *phrase_string)
+{
+    for (size_t i = 0; i < mn_commands.size(); ++i)
+    {
+        if (mn_commands[i].text == phrase_string)
+        {
+            mn_commands.erase(mn_commands.begin() + i);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t esp_mn_commands_clear(void)
+{
+    mn_commands.clear();
+    return mn_commands_target ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+/* stands in for MultiNet rebuilding its decoding graph, which is the slow part on the chip */
+esp_mn_error_t *esp_mn_commands_update(void)
+{
+    if (!mn_commands_target)
+        return NULL;
+    burn_us(commands_cost_us);
+    mn_commands_target->command_ids.clear();
+    for (const stub_phrase_t &p : mn_commands)
+        mn_commands_target->command_ids.push_back(p.phrase.command_id);
+    std::lock_guard<std::mutex> g(counters_lock);
+    counters.mn_updates++;
+    return NULL;
+}
+
+esp_mn_phrase_t *esp_mn_commands_get_from_index(int index)
+{
+    if (index < 0 || (size_t)index >= mn_commands.size())
+        return NULL;
+    stub_phrase_t &p = mn_commands[index];
+    p.phrase.string = &p.text[0];
+    return &p.phrase;
+}
+
+void esp_restart(void)
+{
+    fprintf(stderr, "esp_restart() called\n");
+    exit(1);
+}
@@ -0,0 +1,70 @@
+/* sr_stub.h - controls for the host AFE / WakeNet / MultiNet stand-ins
+ *
+ * The stand-ins run no models. They move audio through with the same chunk
+ * geometry as the real AFE and raise scripted wake and command results when
+ * the fetched audio crosses the scripted sample offsets.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_wn_iface.h"
+
+typedef enum
+{
+    SR_STUB_WAKE,    // AFE fetch reports WAKENET_DETECTED
+    SR_STUB_COMMAND, // MultiNet detect reports ESP_MN_STATE_DETECTED
+} sr_stub_event_type_t;
+
+typedef struct
+{
+    sr_stub_event_type_t type;
+    uint64_t sample; // absolute input sample offset
+    int command_id;
+    float prob;
+} sr_stub_event_t;
+
+typedef struct
+{
+    uint64_t fed_chunks;
+    uint64_t fetched_chunks;
+    uint64_t fetch_empty; // fetch calls that found nothing ready
+    uint64_t dropped_chunks;
+    uint64_t max_backlog; // most chunks fed and not yet fetched at once
+    uint64_t wakes;
+    uint64_t commands;
+    uint64_t missed_commands; // scripted while MultiNet was not running
+    uint64_t timeouts;
+    uint64_t gated_wakes; // scripted inside audio that was never fed
+    uint64_t unknown_commands; // scripted but not in the MultiNet instance's command list
+    uint64_t srmodel_inits; // esp_srmodel_init() calls, i.e. model partition parses
+    uint64_t mn_live;       // MultiNet instances created and not destroyed
+    uint64_t mn_updates;    // esp_mn_commands_update() calls
+    uint64_t feed_ns; // time spent inside feed() including the simulated cost
+    uint64_t fetch_ns;
+} sr_stub_counters_t;
+
+/* "wake@1.5,cmd3@2.25,cmd7:0.4@5" - seconds at sample_rate; cmdN[:prob]. Returns events parsed or -1. */
+int sr_stub_parse_script(const char *spec, int sample_rate, sr_stub_event_t *out, int max);
+void sr_stub_set_script(const sr_stub_event_t *events, size_t n);
+
+/* busy-wait per call to stand in for model compute */
+void sr_stub_set_cost_us(uint32_t feed_us, uint32_t fetch_us);
+
+/* Chunks the pipeline skipped instead of feeding (its energy gate), read on
+ * every feed; keeps each fed chunk at its true input offset. NULL: none. */
+void sr_stub_set_skip_source(uint64_t (*skipped_chunks)(void));
+
+/* busy-wait in esp_mn_commands_update(), for MultiNet's graph rebuild */
+void sr_stub_set_commands_cost_us(uint32_t update_us);
+/* Command ids the instance was loaded with, up to max into ids; returns how
+ * many it has. An instance with none accepts every scripted command. */
+size_t sr_stub_mn_commands(const model_iface_data_t *mn, int *ids, size_t max);
+/* the instance detect() last ran on, NULL before the first call */
+model_iface_data_t *sr_stub_mn_detecting(void);
+
+/* chunks fed but not yet fetched */
+size_t sr_stub_backlog(void);
+/* input sample offset just past the most recently fetched chunk */
+uint64_t sr_stub_fetch_position(void);
+void sr_stub_get_counters(sr_stub_counters_t *out);
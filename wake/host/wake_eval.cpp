@@ -0,0 +1,418 @@
+/* wake_eval.cpp - offline corpus evaluator for the wake/command decision logic
+ *
+ * Walks a directory of WAV/PCM recordings and runs every file through the
+ * feed chunking, signal stats and decision.cpp state machine on a work-stealing
+ * pool, one file per job, all cores by default. esp-sr models only run on the
+ * target, so model outputs come from a sidecar per recording:
+ *
+ *   <file>.script  what WakeNet/MultiNet fired, sr_stub script syntax
+ *                  (wake@SEC,cmdID[:PROB]@SEC), e.g. exported from a board run
+ *   <file>.truth   ground truth in the same syntax (probabilities ignored)
+ *
+ * A file without a .truth is pure negative audio; every actuation on it is a
+ * false accept. Output is one JSON document with per-file detections, latency
+ * percentiles and false accepts per hour.
+ *
+ *   wake_eval [--threads N] [--cmd-threshold P] [--window-ms N] [--out FILE] PATH...
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "signal_stats.h"
+#include "decision.h"
+#include "sr_stub.h"
+#include "wav_io.h"
+#include "work_pool.h"
+
+#define EVAL_SAMPLE_RATE 16000
+#define EVAL_CHUNK 512          // AFE fetch / MultiNet chunk
+#define EVAL_MN_DURATION_MS 6000 // detect_Task's multinet->create() duration
+#define EVAL_MAX_EVENTS 4096
+
+namespace fs = std::filesystem;
+
+typedef struct
+{
+    sr_stub_event_type_t type;
+    int command_id;
+    double t;          // actuation time, seconds into the file
+    double latency_ms; // from the matched truth event, < 0 when a false accept
+} eval_detection_t;
+
+typedef struct
+{
+    std::string path;
+    uintmax_t bytes;
+    bool ok;
+    double seconds;
+    float rms_dbfs;
+    std::vector<eval_detection_t> detections;
+    std::vector<sr_stub_event_t> missed;
+    int truth_wakes, truth_commands;
+    int wake_fa, command_fa;
+} eval_file_t;
+
+static float cmd_threshold = 0.5f;
+static double window_s = 1.5;
+
+static bool read_events(const std::string &path, std::vector<sr_stub_event_t> &out)
+{
+    out.clear();
+    FILE *f = fopen(path.c_str(), "r");
+    if (!f)
+        return true; // no sidecar: nothing fired / nothing to find
+    std::string spec;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        spec.append(buf, n);
+    fclose(f);
+    // accept one event per line as well as comma-separated
+    for (char &c : spec)
+        if (c == '\n' || c == '\r' || c == ' ' || c == '\t')
+            c = ',';
+    std::string clean;
+    for (size_t i = 0; i < spec.size(); ++i)
+        if (!(spec[i] == ',' && (clean.empty() || clean.back() == ',')))
+            clean += spec[i];
+    if (!clean.empty() && clean.back() == ',')
+        clean.pop_back();
+
+    std::vector<sr_stub_event_t> ev(EVAL_MAX_EVENTS);
+    int k = sr_stub_parse_script(clean.c_str(), EVAL_SAMPLE_RATE, ev.data(), EVAL_MAX_EVENTS);
+    if (k < 0)
+        return false;
+    out.assign(ev.begin(), ev.begin() + k);
+    std::stable_sort(out.begin(), out.end(), [](const sr_stub_event_t &a, const sr_stub_event_t &b)
+                     { return a.sample < b.sample; });
+    return true;
+}
+
+/* Scripted stand-in for one file's WakeNet + MultiNet, same rules as sr_stub.cpp
+ * but per instance so files can run concurrently. */
+typedef struct
+{
+    const std::vector<sr_stub_event_t> *script;
+    size_t next_wake, next_cmd;
+    uint64_t since;
+    esp_mn_results_t results;
+} eval_model_t;
+
+static const sr_stub_event_t *eval_take(eval_model_t *m, sr_stub_event_type_t type, uint64_t end)
+{
+    size_t &next = type == SR_STUB_WAKE ? m->next_wake : m->next_cmd;
+    const std::vector<sr_stub_event_t> &s = *m->script;
+    while (next < s.size() && s[next].type != type)
+        next++;
+    if (next < s.size() && s[next].sample < end)
+        return &s[next++];
+    return NULL;
+}
+
+static esp_mn_state_t eval_mn_detect(eval_model_t *m, uint64_t end)
+{
+    const sr_stub_event_t *ev;
+    while ((ev = eval_take(m, SR_STUB_COMMAND, end)) && ev->sample + 2 * EVAL_CHUNK < end)
+    {
+    }
+    if (ev)
+    {
+        memset(&m->results, 0, sizeof(m->results));
+        m->results.state = ESP_MN_STATE_DETECTED;
+        m->results.num = 1;
+        m->results.command_id[0] = ev->command_id;
+        m->results.prob[0] = ev->prob;
+        m->since = 0;
+        return ESP_MN_STATE_DETECTED;
+    }
+    m->since += EVAL_CHUNK;
+    if (m->since >= (uint64_t)EVAL_MN_DURATION_MS * EVAL_SAMPLE_RATE / 1000)
+    {
+        m->since = 0;
+        return ESP_MN_STATE_TIMEOUT;
+    }
+    return ESP_MN_STATE_DETECTING;
+}
+
+static void eval_file(eval_file_t *f)
+{
+    std::vector<int16_t> pcm;
+    wav_info_t info;
+    std::vector<sr_stub_event_t> script, truth;
+    f->ok = wav_read(f->path.c_str(), pcm, &info) && read_events(f->path + ".script", script) &&
+            read_events(f->path + ".truth", truth);
+    if (!f->ok)
+        return;
+    f->seconds = (double)pcm.size() / EVAL_SAMPLE_RATE;
+
+    decision_t d;
+    decision_config_t cfg = {.cmd_threshold = cmd_threshold};
+    decision_init(&d, &cfg);
+    eval_model_t model = {&script, 0, 0, 0, {}};
+
+    signal_stats_t total = {};
+    afe_fetch_result_t res;
+    std::vector<eval_detection_t> acts;
+
+    for (size_t off = 0; off + EVAL_CHUNK <= pcm.size(); off += EVAL_CHUNK)
+    {
+        signal_stats_t st;
+        signal_stats_compute(&pcm[off], EVAL_CHUNK, &st);
+        total.sum_sq += st.sum_sq;
+        total.samples += st.samples;
+
+        uint64_t end = off + EVAL_CHUNK;
+        double t = (double)end / EVAL_SAMPLE_RATE;
+        memset(&res, 0, sizeof(res));
+        res.data = &pcm[off];
+        res.raw_data_channels = 1;
+        res.wakeup_state = eval_take(&model, SR_STUB_WAKE, end) ? WAKENET_DETECTED : WAKENET_NO_DETECT;
+
+        decision_actions_t act;
+        if (decision_on_fetch(&d, &res, &act))
+        {
+            if (act.flags & DECISION_TRIGGER_HIGH)
+                model.since = 0; // detect_Task cleans MultiNet on a wake
+            esp_mn_state_t st_mn = eval_mn_detect(&model, end);
+            if (st_mn != ESP_MN_STATE_DETECTING)
+                decision_on_command(&d, st_mn, &model.results, &act);
+        }
+        if (act.flags & DECISION_TRIGGER_HIGH)
+            acts.push_back({SR_STUB_WAKE, 0, t, -1});
+        for (int i = 0; i < act.commands; ++i)
+            acts.push_back({SR_STUB_COMMAND, act.command_id[i], t, -1});
+    }
+    f->rms_dbfs = signal_stats_rms(&total) > 0 ? 20.0f * log10f(signal_stats_rms(&total) / 32768.0f) : -120.0f;
+
+    // each truth event takes the first unmatched actuation of its kind inside the window
+    std::vector<bool> used(acts.size(), false);
+    for (const sr_stub_event_t &ev : truth)
+    {
+        double t = (double)ev.sample / EVAL_SAMPLE_RATE;
+        (ev.type == SR_STUB_WAKE ? f->truth_wakes : f->truth_commands)++;
+        bool hit = false;
+        for (size_t i = 0; i < acts.size() && !hit; ++i)
+        {
+            eval_detection_t &a = acts[i];
+            if (used[i] || a.type != ev.type || (ev.type == SR_STUB_COMMAND && a.command_id != ev.command_id))
+                continue;
+            if (a.t >= t && a.t <= t + window_s)
+            {
+                used[i] = true;
+                a.latency_ms = (a.t - t) * 1000.0;
+                hit = true;
+            }
+        }
+        if (!hit)
+            f->missed.push_back(ev);
+    }
+    for (size_t i = 0; i < acts.size(); ++i)
+    {
+        if (!used[i])
+            (acts[i].type == SR_STUB_WAKE ? f->wake_fa : f->command_fa)++;
+    }
+    f->detections = acts;
+}
+
+static double percentile(std::vector<double> v, double p)
+{
+    if (v.empty())
+        return 0;
+    std::sort(v.begin(), v.end());
+    size_t rank = (size_t)ceil(p / 100.0 * v.size());
+    return v[rank ? rank - 1 : 0];
+}
+
+static void json_string(FILE *o, const std::string &s)
+{
+    fputc('"', o);
+    for (unsigned char c : s)
+    {
+        if (c == '"' || c == '\\')
+            fprintf(o, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(o, "\\u%04x", c);
+        else
+            fputc(c, o);
+    }
+    fputc('"', o);
+}
+
+static void json_class(FILE *o, const char *name, int truth, int detected, int fa, double hours, const std::vector<double> &lat)
+{
+    fprintf(o, "  \"%s\": {\"truth\": %d, \"detected\": %d, \"missed\": %d, \"false_accepts\": %d, "
+               "\"fa_per_hour\": %.4f, \"latency_ms\": {\"n\": %zu, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f}},\n",
+            name, truth, detected, truth - detected, fa, hours > 0 ? fa / hours : 0.0, lat.size(),
+            percentile(lat, 50), percentile(lat, 90), percentile(lat, 99), percentile(lat, 100));
+}
+
+static bool is_audio(const fs::path &p)
+{
+    std::string ext = p.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".wav" || ext == ".pcm" || ext == ".raw";
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: wake_eval [--threads N] [--cmd-threshold P] [--window-ms N] [--out FILE] PATH...\n"
+                    "  PATH: audio file or directory (searched recursively for .wav/.pcm/.raw)\n");
+}
+
+int main(int argc, char **argv)
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    const char *out_path = NULL;
+    std::vector<std::string> roots;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *a = argv[i];
+        bool has_val = i + 1 < argc;
+        if (strcmp(a, "--threads") == 0 && has_val)
+            threads = (unsigned)atoi(argv[++i]);
+        else if (strcmp(a, "--cmd-threshold") == 0 && has_val)
+            cmd_threshold = (float)atof(argv[++i]);
+        else if (strcmp(a, "--window-ms") == 0 && has_val)
+            window_s = atof(argv[++i]) / 1000.0;
+        else if (strcmp(a, "--out") == 0 && has_val)
+            out_path = argv[++i];
+        else if (a[0] == '-')
+        {
+            usage();
+            return 2;
+        }
+        else
+            roots.push_back(a);
+    }
+    if (roots.empty())
+    {
+        usage();
+        return 2;
+    }
+
+    std::vector<eval_file_t> files;
+    for (const std::string &r : roots)
+    {
+        std::error_code ec;
+        if (fs::is_directory(r, ec))
+        {
+            for (auto &e : fs::recursive_directory_iterator(r, ec))
+                if (e.is_regular_file() && is_audio(e.path()))
+                    files.push_back(eval_file_t{e.path().string(), e.file_size(), false, 0, 0, {}, {}, 0, 0, 0, 0});
+        }
+        else if (fs::is_regular_file(r, ec))
+        {
+            files.push_back(eval_file_t{r, fs::file_size(r, ec), false, 0, 0, {}, {}, 0, 0, 0, 0});
+        }
+        else
+        {
+            fprintf(stderr, "wake_eval: %s: not found\n", r.c_str());
+            return 2;
+        }
+    }
+    // largest first so the long recordings start early and stealing evens out the tail
+    std::sort(files.begin(), files.end(), [](const eval_file_t &a, const eval_file_t &b)
+              { return a.bytes != b.bytes ? a.bytes > b.bytes : a.path < b.path; });
+
+    signal_stats_init();
+    std::vector<work_pool_worker_stats_t> wstats;
+    auto t0 = std::chrono::steady_clock::now();
+    work_pool_run(files.size(), threads, [&](size_t i)
+                  { eval_file(&files[i]); },
+                  &wstats);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::sort(files.begin(), files.end(), [](const eval_file_t &a, const eval_file_t &b)
+              { return a.path < b.path; });
+
+    double seconds = 0;
+    int bad = 0, tw = 0, tc = 0, dw = 0, dc = 0, faw = 0, fac = 0;
+    std::vector<double> lat_w, lat_c;
+    for (const eval_file_t &f : files)
+    {
+        if (!f.ok)
+        {
+            bad++;
+            continue;
+        }
+        seconds += f.seconds;
+        tw += f.truth_wakes;
+        tc += f.truth_commands;
+        faw += f.wake_fa;
+        fac += f.command_fa;
+        for (const eval_detection_t &d : f.detections)
+        {
+            if (d.latency_ms < 0)
+                continue;
+            (d.type == SR_STUB_WAKE ? lat_w : lat_c).push_back(d.latency_ms);
+            (d.type == SR_STUB_WAKE ? dw : dc)++;
+        }
+    }
+    double hours = seconds / 3600.0;
+
+    FILE *o = out_path ? fopen(out_path, "w") : stdout;
+    if (!o)
+    {
+        fprintf(stderr, "wake_eval: cannot write %s\n", out_path);
+        return 2;
+    }
+    fprintf(o, "{\n  \"files\": %zu,\n  \"unreadable\": %d,\n  \"audio_hours\": %.4f,\n  \"wall_s\": %.3f,\n"
+               "  \"realtime_factor\": %.1f,\n  \"threads\": %u,\n  \"cmd_threshold\": %.3f,\n  \"window_ms\": %.0f,\n",
+            files.size(), bad, hours, wall, wall > 0 ? seconds / wall : 0.0, threads ? threads : 1, cmd_threshold,
+            window_s * 1000.0);
+    json_class(o, "wake", tw, dw, faw, hours, lat_w);
+    json_class(o, "command", tc, dc, fac, hours, lat_c);
+
+    fprintf(o, "  \"workers\": [");
+    for (size_t i = 0; i < wstats.size(); ++i)
+        fprintf(o, "%s{\"executed\": %zu, \"stolen\": %zu}", i ? ", " : "", wstats[i].executed, wstats[i].stolen);
+    fprintf(o, "],\n  \"per_file\": [\n");
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        const eval_file_t &f = files[i];
+        fprintf(o, "    {\"file\": ");
+        json_string(o, f.path);
+        if (!f.ok)
+        {
+            fprintf(o, ", \"error\": \"unreadable audio or sidecar\"}%s\n", i + 1 < files.size() ? "," : "");
+            continue;
+        }
+        fprintf(o, ", \"seconds\": %.3f, \"rms_dbfs\": %.1f, \"false_accepts\": %d, \"detections\": [",
+                f.seconds, f.rms_dbfs, f.wake_fa + f.command_fa);
+        for (size_t k = 0; k < f.detections.size(); ++k)
+        {
+            const eval_detection_t &d = f.detections[k];
+            fprintf(o, "%s{\"type\": \"%s\"", k ? ", " : "", d.type == SR_STUB_WAKE ? "wake" : "command");
+            if (d.type == SR_STUB_COMMAND)
+                fprintf(o, ", \"id\": %d", d.command_id);
+            fprintf(o, ", \"t\": %.3f, ", d.t);
+            if (d.latency_ms < 0)
+                fprintf(o, "\"false_accept\": true}");
+            else
+                fprintf(o, "\"latency_ms\": %.1f}", d.latency_ms);
+        }
+        fprintf(o, "], \"missed\": [");
+        for (size_t k = 0; k < f.missed.size(); ++k)
+        {
+            const sr_stub_event_t &m = f.missed[k];
+            fprintf(o, "%s{\"type\": \"%s\"", k ? ", " : "", m.type == SR_STUB_WAKE ? "wake" : "command");
+            if (m.type == SR_STUB_COMMAND)
+                fprintf(o, ", \"id\": %d", m.command_id);
+            fprintf(o, ", \"t\": %.3f}", (double)m.sample / EVAL_SAMPLE_RATE);
+        }
+        fprintf(o, "]}%s\n", i + 1 < files.size() ? "," : "");
+    }
+    fprintf(o, "  ]\n}\n");
+    if (o != stdout)
+        fclose(o);
+    fprintf(stderr, "wake_eval: %zu files, %.2f h of audio in %.2f s on %u threads (%.0fx real time)\n",
+            files.size(), hours, wall, threads ? threads : 1, wall > 0 ? seconds / wall : 0.0);
+    return bad ? 1 : 0;
+}
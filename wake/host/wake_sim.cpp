@@ -0,0 +1,367 @@
+/* wake_sim.cpp - runs the firmware's capture, feed and detect tasks on Linux against stand-in drivers
+ *
+ * PCM (a WAV file or the built-in hilexin clip) is replayed through the stub
+ * I2S channel at real time, at a multiple of it, or as fast as the pipeline
+ * drains it. WakeNet and MultiNet are replaced by a script of timed events
+ * (see sr_stub.h), so the run exercises the real task code, buffering and
+ * GPIO/LED actuation without any models. Exits non-zero when a scripted wake
+ * or command does not reach TRIGGER_GPIO or an LED, or when a pipeline task
+ * allocates from the heap once it is running.
+ *
+ *   wake_sim [--wav FILE] [--speed X | --fast] [--loops N] [--gap SEC] [--script SPEC]
+ *            [--feed-cost-us N] [--fetch-cost-us N] [--base-ma N] [--busy-ma N]
+ *            [--place CLASS] [--link PATH] [--verbose]
+ *
+ * --place pins the capture ring and feed buffer to internal, dma or psram
+ * instead of the Kconfig placement. --link writes the Pi link's UART bytes to
+ * PATH (a file, or a pty for pi/wake_link to read). --gap puts SEC seconds
+ * of quiet room noise (about -50 dBFS) between loops, for a mostly silent
+ * corpus. The cost line turns the time spent in feed and fetch (the stand-in
+ * model cost, set with --feed-cost-us/--fetch-cost-us) into a core duty and
+ * a current estimate of base + duty * busy mA; wake_sim_gate runs the same
+ * corpus behind the energy gate.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_afe_sr_models.h"
+#include "actuator.h"
+#include "arena.h"
+#include "capture.h"
+#include "event_log.h"
+#include "signal_stats.h"
+#include "pipeline.h"
+#include "phrase_table.h"
+#include "model_registry.h"
+#include "boot_profile.h"
+#include "wake_log.h"
+#include "esp_stub.h"
+#include "i2s_stub.h"
+#include "sr_stub.h"
+#include "wav_io.h"
+#include "hilexin.h"
+
+#define SIM_DESC_NUM 8
+#define SIM_FRAME_NUM 256
+#define SIM_MAX_EVENTS 256
+#define SIM_LED_ON 255
+#define SIM_GAP_PEAK 173 // uniform noise of RMS ~100, about -50 dBFS like the clip's own background
+
+typedef struct
+{
+    uint64_t sample; // input samples delivered when the write happened
+    int led;         // -1 for TRIGGER_GPIO
+    uint32_t value;
+} sim_edge_t;
+
+static std::mutex edges_lock;
+static std::vector<sim_edge_t> edges;
+static size_t feed_samples = 0;
+
+static void on_gpio(gpio_num_t gpio, uint32_t level)
+{
+    if (gpio != TRIGGER_GPIO)
+        return;
+    std::lock_guard<std::mutex> g(edges_lock);
+    edges.push_back({i2s_stub_samples_delivered(), -1, level});
+}
+
+static void on_ledc(ledc_channel_t channel, uint32_t duty)
+{
+    std::lock_guard<std::mutex> g(edges_lock);
+    edges.push_back({i2s_stub_samples_delivered(), (int)channel, duty});
+}
+
+#if CONFIG_WAKE_GATE
+static uint64_t gate_skipped(void)
+{
+    energy_gate_stats_t gs;
+    pipeline_gate_stats(&gs);
+    return gs.dropped;
+}
+#endif
+
+/* --fast: only hand the pipeline more audio once it has caught up */
+static bool pipeline_ready(void)
+{
+    return capture_pending() < 4 * feed_samples && sr_stub_backlog() < 4;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: wake_sim [--wav FILE] [--speed X | --fast] [--loops N] [--gap SEC] [--script SPEC]\n"
+                    "                [--feed-cost-us N] [--fetch-cost-us N] [--base-ma N] [--busy-ma N]\n"
+                    "                [--place internal|dma|psram] [--link PATH] [--verbose]\n"
+                    "  SPEC: comma-separated wake@SEC and cmdID[:PROB]@SEC, e.g. wake@1.2,cmd3@2.0\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *wav = NULL;
+    const char *script_spec = NULL;
+    double speed = 1.0;
+    int loops = 1;
+    uint32_t feed_cost = 0, fetch_cost = 0;
+    double gap = 0;
+    double base_ma = 33, busy_ma = 17; // rough ESP32-S3 at 240 MHz, RF off: idle cores, and one core fully busy on top
+    bool verbose = false;
+    const char *link_path = NULL;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *a = argv[i];
+        bool has_val = i + 1 < argc;
+        if (strcmp(a, "--wav") == 0 && has_val)
+            wav = argv[++i];
+        else if (strcmp(a, "--speed") == 0 && has_val)
+            speed = atof(argv[++i]);
+        else if (strcmp(a, "--fast") == 0)
+            speed = 0;
+        else if (strcmp(a, "--loops") == 0 && has_val)
+            loops = atoi(argv[++i]);
+        else if (strcmp(a, "--gap") == 0 && has_val)
+            gap = atof(argv[++i]);
+        else if (strcmp(a, "--base-ma") == 0 && has_val)
+            base_ma = atof(argv[++i]);
+        else if (strcmp(a, "--busy-ma") == 0 && has_val)
+            busy_ma = atof(argv[++i]);
+        else if (strcmp(a, "--script") == 0 && has_val)
+            script_spec = argv[++i];
+        else if (strcmp(a, "--feed-cost-us") == 0 && has_val)
+            feed_cost = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(a, "--fetch-cost-us") == 0 && has_val)
+            fetch_cost = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(a, "--place") == 0 && has_val)
+        {
+            const char *cls = argv[++i];
+            arena_place_t place = strcmp(cls, "internal") == 0 ? ARENA_PLACE_INTERNAL
+                                  : strcmp(cls, "dma") == 0    ? ARENA_PLACE_DMA
+                                  : strcmp(cls, "psram") == 0  ? ARENA_PLACE_PSRAM
+                                                               : ARENA_PLACE_AUTO;
+            if (place == ARENA_PLACE_AUTO)
+            {
+                usage();
+                return 2;
+            }
+            arena_set_place(ARENA_BUF_CAPTURE_RING, place);
+            arena_set_place(ARENA_BUF_FEED, place);
+        }
+        else if (strcmp(a, "--link") == 0 && has_val)
+            link_path = argv[++i];
+        else if (strcmp(a, "--verbose") == 0)
+            verbose = true;
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (loops < 1 || speed < 0 || gap < 0)
+    {
+        usage();
+        return 2;
+    }
+
+    int link_fd = -1;
+    if (link_path)
+    {
+        link_fd = open(link_path, O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, 0644);
+        if (link_fd < 0)
+        {
+            fprintf(stderr, "wake_sim: cannot open %s\n", link_path);
+            return 2;
+        }
+        uart_stub_set_fd(link_fd);
+    }
+
+    std::vector<int16_t> clip;
+    if (wav)
+    {
+        wav_info_t info;
+        if (!wav_read(wav, clip, &info))
+        {
+            fprintf(stderr, "wake_sim: cannot read %s as PCM16\n", wav);
+            return 2;
+        }
+        if (info.sample_rate && info.sample_rate != SAMPLE_RATE)
+            fprintf(stderr, "wake_sim: %s is %d Hz, replaying as %d Hz\n", wav, info.sample_rate, SAMPLE_RATE);
+    }
+    else
+    {
+        clip.resize(sizeof(hilexin) / sizeof(int16_t));
+        memcpy(clip.data(), hilexin, clip.size() * sizeof(int16_t));
+    }
+    std::vector<int16_t> pcm;
+    uint32_t noise = 2463534242u;
+    for (int i = 0; i < loops; ++i)
+    {
+        if (i > 0)
+        {
+            for (size_t n = (size_t)(gap * SAMPLE_RATE); n > 0; --n)
+            {
+                noise ^= noise << 13;
+                noise ^= noise >> 17;
+                noise ^= noise << 5;
+                pcm.push_back((int16_t)((int32_t)(noise % (2 * SIM_GAP_PEAK + 1)) - SIM_GAP_PEAK));
+            }
+        }
+        pcm.insert(pcm.end(), clip.begin(), clip.end());
+    }
+
+    sr_stub_event_t events[SIM_MAX_EVENTS];
+    int n_events = 0;
+    if (script_spec)
+    {
+        n_events = sr_stub_parse_script(script_spec, SAMPLE_RATE, events, SIM_MAX_EVENTS);
+        if (n_events < 0)
+        {
+            fprintf(stderr, "wake_sim: bad script '%s'\n", script_spec);
+            return 2;
+        }
+    }
+    sr_stub_set_script(events, n_events);
+    sr_stub_set_cost_us(feed_cost, fetch_cost);
+#if CONFIG_WAKE_GATE
+    sr_stub_set_skip_source(gate_skipped);
+#endif
+
+    wake_log_init();
+    if (verbose)
+        wake_log_set("WAKE_DBG", ESP_LOG_DEBUG);
+    gpio_stub_set_observer(on_gpio);
+    ledc_stub_set_observer(on_ledc);
+    signal_stats_init();
+
+    // same bring-up order as app_main: models, AFE, then I2S sized from the AFE chunk
+    int phase = boot_phase_begin("models");
+    srmodel_list_t *models = model_registry_init("model");
+    boot_phase_end(phase);
+    afe_config_t *afe_config = afe_config_init("M", models, AFE_TYPE_SR, AFE_MODE_LOW_COST);
+    afe_handle = esp_afe_handle_from_config(afe_config);
+    model_registry_mark_t afe_mark;
+    model_registry_mark(&afe_mark);
+    phase = boot_phase_begin("afe");
+    esp_afe_sr_data_t *afe_data = afe_handle->create_from_config(afe_config);
+    boot_phase_end(phase);
+    model_registry_record(afe_config->wakenet_model_name, &afe_mark);
+    afe_config_free(afe_config);
+    feed_samples = (size_t)afe_handle->get_feed_chunksize(afe_data) * (size_t)afe_handle->get_feed_channel_num(afe_data);
+
+    i2s_stub_set_source(pcm.data(), pcm.size(), false);
+    i2s_stub_set_speed(speed);
+    i2s_stub_set_gate(pipeline_ready);
+
+    i2s_chan_handle_t rx = NULL;
+    i2s_chan_config_t chan_cfg = {};
+    chan_cfg.id = I2S_NUM_0;
+    chan_cfg.role = I2S_ROLE_MASTER;
+    chan_cfg.dma_desc_num = SIM_DESC_NUM;
+    chan_cfg.dma_frame_num = capture_is_zero_copy() ? (uint32_t)feed_samples : SIM_FRAME_NUM;
+    ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, NULL, &rx));
+    i2s_std_config_t std_cfg = {};
+    std_cfg.clk_cfg.sample_rate_hz = SAMPLE_RATE;
+    ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx, &std_cfg));
+
+    auto t0 = std::chrono::steady_clock::now();
+    arena_plan_t plan = {};
+    capture_plan(&plan, feed_samples);
+    pipeline_plan(&plan, afe_data);
+    if (!arena_init(&plan))
+        return 2;
+    ESP_ERROR_CHECK(capture_start(rx, feed_samples, SIM_DESC_NUM));
+    gpio_set_level(TRIGGER_GPIO, 0);
+    pipeline_start(afe_data);
+
+    // run until the source is delivered and everything full-chunk has been fetched
+    while (!i2s_stub_done() || capture_pending() >= feed_samples || sr_stub_backlog() > 0 || actuator_pending() > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    task_flag = 0;
+    capture_stop();
+    event_log_stop();
+    host_task_join_all();
+    if (link_fd >= 0)
+        close(link_fd);
+
+    sr_stub_counters_t c;
+    sr_stub_get_counters(&c);
+    capture_stats_t cs;
+    capture_get_stats(&cs);
+    double audio = (double)pcm.size() / SAMPLE_RATE;
+
+    printf("wake_sim: mode=%s source=%s audio=%.2fs wall=%.2fs realtime=%.1fx\n",
+           capture_is_zero_copy() ? "zero-copy" : "ring", wav ? wav : "hilexin", audio, wall, wall > 0 ? audio / wall : 0.0);
+    printf("chunks: fed=%llu fetched=%llu afe_dropped=%llu capture_overruns=%u capture_underruns=%u lapped=%u\n",
+           (unsigned long long)c.fed_chunks, (unsigned long long)c.fetched_chunks, (unsigned long long)c.dropped_chunks,
+           (unsigned)cs.overruns, (unsigned)cs.underruns, (unsigned)cs.lapped);
+    printf("cost: feed=%.1fus/chunk fetch=%.1fus/chunk\n",
+           c.fed_chunks ? c.feed_ns / 1e3 / c.fed_chunks : 0.0, c.fetched_chunks ? c.fetch_ns / 1e3 / c.fetched_chunks : 0.0);
+    // one core's share of the stand-in model cost; the real chain costs this per fed chunk
+    double duty = audio > 0 ? (double)(c.feed_ns + c.fetch_ns) / 1e9 / audio : 0.0;
+    printf("afe cpu: %.1f ms per s of audio (duty %.1f%%), est. current %.1f mA = %.0f + duty * %.0f\n", duty * 1e3,
+           duty * 100.0, base_ma + duty * busy_ma, base_ma, busy_ma);
+#if CONFIG_WAKE_GATE
+    energy_gate_stats_t gs;
+    pipeline_gate_stats(&gs);
+    printf("gate: chunks=%u fed=%u replayed=%u dropped=%u opens=%u skipped=%.1f%% floor=%.1f dBFS gated_wakes=%llu\n",
+           (unsigned)gs.chunks, (unsigned)gs.fed, (unsigned)gs.replayed, (unsigned)gs.dropped, (unsigned)gs.opens,
+           gs.chunks ? 100.0 * gs.dropped / gs.chunks : 0.0, gs.floor_dbfs_x10 / 10.0, (unsigned long long)c.gated_wakes);
+#endif
+    pipeline_print_latency();
+    model_registry_report();
+    model_registry_deinit();
+    arena_report();
+    printf("model index loads: %llu\n", (unsigned long long)c.srmodel_inits);
+    printf("events: wakes=%llu commands=%llu missed_commands=%llu timeouts=%llu\n",
+           (unsigned long long)c.wakes, (unsigned long long)c.commands, (unsigned long long)c.missed_commands,
+           (unsigned long long)c.timeouts);
+
+    // every scripted event must surface as an actuation: wake -> TRIGGER_GPIO high, command -> its manifest LEDs on
+    int failures = 0;
+    std::lock_guard<std::mutex> g(edges_lock);
+    for (int i = 0; i < n_events; ++i)
+    {
+        const sr_stub_event_t &ev = events[i];
+        const sim_edge_t *hit = NULL;
+        unsigned leds = ev.type == SR_STUB_WAKE ? 0 : phrase_leds(phrase_entry(ev.command_id));
+        for (const sim_edge_t &e : edges)
+        {
+            bool match = ev.type == SR_STUB_WAKE ? (e.led < 0 && e.value == 1)
+                                                 : (e.led >= 0 && (leds >> e.led & 1) && e.value == SIM_LED_ON);
+            if (match && e.sample >= ev.sample)
+            {
+                hit = &e;
+                break;
+            }
+        }
+        bool expect = ev.type == SR_STUB_WAKE || (ev.prob > 0.5f && leds);
+        const char *name = ev.type == SR_STUB_WAKE ? "wake" : "cmd";
+        if (hit)
+            printf("  %s%s@%.3fs -> %s at %.3fs (+%.1f ms audio)\n", name,
+                   ev.type == SR_STUB_WAKE ? "" : std::to_string(ev.command_id).c_str(), (double)ev.sample / SAMPLE_RATE,
+                   hit->led < 0 ? "TRIGGER_GPIO=1" : ("LED" + std::to_string(hit->led) + " on").c_str(),
+                   (double)hit->sample / SAMPLE_RATE, (double)(hit->sample - ev.sample) * 1000.0 / SAMPLE_RATE);
+        else
+            printf("  %s%s@%.3fs -> %s\n", name, ev.type == SR_STUB_WAKE ? "" : std::to_string(ev.command_id).c_str(),
+                   (double)ev.sample / SAMPLE_RATE,
+                   expect ? "MISSING" : leds ? "no actuation (prob <= 0.5)" : "no actuation (no LEDs in the manifest)");
+        failures += expect && !hit;
+    }
+
+    failures += arena_hot_violations() != 0;
+    printf("%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+/* wav_io.cpp - minimal RIFF/WAVE PCM16 reader for the host tools */
+#include <stdio.h>
+#include <string.h>
+#include "wav_io.h"
+
+static uint32_t le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool wav_read(const char *path, std::vector<int16_t> &pcm, wav_info_t *info)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+    std::vector<uint8_t> bytes;
+    uint8_t tmp[65536];
+    size_t n;
+    while ((n = fread(tmp, 1, sizeof(tmp), f)) > 0)
+        bytes.insert(bytes.end(), tmp, tmp + n);
+    fclose(f);
+
+    info->sample_rate = 0;
+    info->channels = 1;
+    const uint8_t *data = bytes.data();
+    size_t data_len = bytes.size();
+
+    if (bytes.size() >= 12 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WAVE", 4) == 0)
+    {
+        bool have_fmt = false;
+        const uint8_t *payload = NULL;
+        size_t off = 12;
+        while (off + 8 <= bytes.size())
+        {
+            const uint8_t *c = data + off;
+            uint32_t len = le32(c + 4);
+            if (off + 8 + len > bytes.size())
+                len = (uint32_t)(bytes.size() - off - 8);
+            if (memcmp(c, "fmt ", 4) == 0 && len >= 16)
+            {
+                if (le16(c + 8) != 1 || le16(c + 22) != 16)
+                    return false; // only integer PCM16
+                info->channels = le16(c + 10);
+                info->sample_rate = (int)le32(c + 12);
+                have_fmt = true;
+            }
+            else if (memcmp(c, "data", 4) == 0)
+            {
+                payload = c + 8;
+                data_len = len;
+            }
+            off += 8 + len + (len & 1);
+        }
+        if (!have_fmt || !payload || info->channels < 1)
+            return false;
+        data = payload;
+    }
+
+    size_t frames = data_len / (2 * info->channels);
+    pcm.resize(frames);
+    for (size_t i = 0; i < frames; ++i)
+        pcm[i] = (int16_t)le16(data + 2 * i * info->channels);
+    return true;
+}
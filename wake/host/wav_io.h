@@ -0,0 +1,15 @@
+/* wav_io.h - minimal RIFF/WAVE PCM16 reader for the host tools */
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+typedef struct
+{
+    int sample_rate;
+    int channels;
+} wav_info_t;
+
+/* Reads a 16-bit PCM WAV, or raw little-endian PCM16 mono when the file has no
+ * RIFF header (info->sample_rate is then 0). Multi-channel input keeps channel 0. */
+bool wav_read(const char *path, std::vector<int16_t> &pcm, wav_info_t *info);
@@ -0,0 +1,95 @@
+/* work_pool.cpp - fixed set of worker threads with per-worker deques and work stealing */
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "work_pool.h"
+
+typedef struct
+{
+    std::mutex m;
+    std::deque<size_t> jobs;
+} work_deque_t;
+
+static bool pop_own(work_deque_t *q, size_t *job)
+{
+    std::lock_guard<std::mutex> g(q->m);
+    if (q->jobs.empty())
+        return false;
+    *job = q->jobs.front();
+    q->jobs.pop_front();
+    return true;
+}
+
+/* steal from the back of the victim with the most queued jobs; false when every deque is empty */
+static bool steal(std::vector<std::unique_ptr<work_deque_t>> &queues, size_t self, size_t *job)
+{
+    for (;;)
+    {
+        size_t victim = self;
+        size_t most = 0;
+        for (size_t i = 0; i < queues.size(); ++i)
+        {
+            if (i == self)
+                continue;
+            std::lock_guard<std::mutex> g(queues[i]->m);
+            if (queues[i]->jobs.size() > most)
+            {
+                most = queues[i]->jobs.size();
+                victim = i;
+            }
+        }
+        if (victim == self)
+            return false;
+
+        std::lock_guard<std::mutex> g(queues[victim]->m);
+        if (queues[victim]->jobs.empty())
+            continue; // raced with its owner, look again
+        *job = queues[victim]->jobs.back();
+        queues[victim]->jobs.pop_back();
+        return true;
+    }
+}
+
+void work_pool_run(size_t n, unsigned threads, const std::function<void(size_t)> &job,
+                   std::vector<work_pool_worker_stats_t> *stats)
+{
+    if (threads == 0)
+        threads = 1;
+    std::vector<std::unique_ptr<work_deque_t>> queues;
+    for (unsigned t = 0; t < threads; ++t)
+        queues.emplace_back(new work_deque_t());
+    for (size_t i = 0; i < n; ++i)
+        queues[i % threads]->jobs.push_back(i);
+
+    std::vector<work_pool_worker_stats_t> local(threads, work_pool_worker_stats_t{0, 0});
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]
+                             {
+            size_t i;
+            for (;;)
+            {
+                if (pop_own(queues[t].get(), &i))
+                {
+                    job(i);
+                    local[t].executed++;
+                }
+                else if (steal(queues, t, &i))
+                {
+                    job(i);
+                    local[t].executed++;
+                    local[t].stolen++;
+                }
+                else
+                {
+                    return; // no job is ever added after start, so empty everywhere means done
+                }
+            } });
+    }
+    for (auto &w : workers)
+        w.join();
+    if (stats)
+        *stats = local;
+}
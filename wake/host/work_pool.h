@@ -0,0 +1,19 @@
+/* work_pool.h - fixed set of worker threads with per-worker deques and work stealing */
+#pragma once
+
+#include <stddef.h>
+#include <functional>
+#include <vector>
+
+typedef struct
+{
+    size_t executed; // jobs run by this worker
+    size_t stolen;   // of those, jobs taken from another worker's deque
+} work_pool_worker_stats_t;
+
+/* Runs job(i) for every i in [0, n) on `threads` workers and returns when all
+ * are done. Jobs are dealt round-robin in the order given (put the largest
+ * first); a worker pops from the front of its own deque and, once empty,
+ * steals from the back of the fullest other deque. */
+void work_pool_run(size_t n, unsigned threads, const std::function<void(size_t)> &job,
+                   std::vector<work_pool_worker_stats_t> *stats);
@@ -0,0 +1,106 @@
+/* actuator.cpp - actuation task: applies decision events to TRIGGER_GPIO and the LEDC channels */
+#include <stdio.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "sdkconfig.h"
+#include "decision.h"
+#include "event_log.h"
+#include "latency_trace.h"
+#include "pipeline.h"
+#include "actuator.h"
+
+#define TAG "WAKE_DBG"
+#define ACT_QUEUE_LEN 8
+#define ACT_LED_ON 255
+#define ACT_LED_OFF 0
+
+static QueueHandle_t act_queue = NULL;
+static std::atomic<uint32_t> act_dropped(0);
+
+static void led_fade(int led, uint32_t duty)
+{
+#if CONFIG_WAKE_LED_FADE_MS > 0
+    // hardware fade: returns once started, a fade still running on the channel is waited out
+    ledc_set_fade_time_and_start(LEDC_LOW_SPEED_MODE, (ledc_channel_t)led, duty, CONFIG_WAKE_LED_FADE_MS, LEDC_FADE_NO_WAIT);
+#else
+    ledc_set_duty_and_update(LEDC_LOW_SPEED_MODE, (ledc_channel_t)led, duty, 0);
+#endif
+}
+
+static void apply(const actuator_event_t *ev)
+{
+    switch (ev->kind)
+    {
+    case ACT_WAKE:
+        gpio_set_level(TRIGGER_GPIO, 1);
+        latency_trace_since(TRACE_DECISION_GPIO, ev->decided_at);
+        latency_trace_since(TRACE_CAPTURE_GPIO, ev->captured_at);
+        EVENT_LOG(EV_GPIO_HIGH, ev_i(TRIGGER_GPIO));
+        break;
+    case ACT_COMMAND:
+        for (int led = 0; led < DECISION_LED_COUNT; led++)
+        {
+            if (ev->leds & (1u << led))
+                led_fade(led, ACT_LED_ON);
+        }
+        break;
+    case ACT_TIMEOUT:
+        if (ev->flags & DECISION_LEDS_OFF)
+        {
+            for (int led = 0; led < DECISION_LED_COUNT; led++)
+                led_fade(led, ACT_LED_OFF);
+        }
+        if (ev->flags & DECISION_TRIGGER_LOW)
+        {
+            gpio_set_level(TRIGGER_GPIO, 0);
+            EVENT_LOG(EV_GPIO_LOW, ev_i(TRIGGER_GPIO));
+        }
+        break;
+    }
+}
+
+/* actuation task: the only task that drives the LEDs and TRIGGER_GPIO once the pipeline runs */
+static void actuator_Task(void *arg)
+{
+    uint32_t reported_drops = 0;
+    while (task_flag)
+    {
+        actuator_event_t ev;
+        if (xQueueReceive(act_queue, &ev, pdMS_TO_TICKS(100)) == pdTRUE)
+            apply(&ev);
+        uint32_t d = act_dropped.load(std::memory_order_relaxed);
+        if (d != reported_drops)
+        {
+            EVENT_LOG(EV_ACT_DROPPED, ev_i((int32_t)(d - reported_drops)));
+            reported_drops = d;
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+void actuator_start(void)
+{
+    act_queue = xQueueCreate(ACT_QUEUE_LEN, sizeof(actuator_event_t));
+    // below feed (7) and detect (6), above the event log and console (1); core 0 so a wake
+    // reaches the GPIO while detect_Task keeps core 1 busy with MultiNet
+    xTaskCreatePinnedToCore(actuator_Task, "actuate", 3072, NULL, 2, NULL, 0);
+}
+
+bool actuator_post(const actuator_event_t *ev)
+{
+    if (xQueueSend(act_queue, ev, 0) == pdTRUE)
+        return true;
+    act_dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+int actuator_pending(void)
+{
+    return act_queue ? (int)uxQueueMessagesWaiting(act_queue) : 0;
+}
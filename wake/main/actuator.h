@@ -0,0 +1,34 @@
+/* actuator.h - LEDs and TRIGGER_GPIO driven by a low-priority task from a queue of decision events
+ *
+ * detect_Task only posts; every LEDC and GPIO driver call happens on the
+ * actuation task, so no driver lock or fade wait sits in the recognition loop.
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef enum
+{
+    ACT_WAKE,    // raise TRIGGER_GPIO
+    ACT_COMMAND, // fade in the LEDs in `leds`
+    ACT_TIMEOUT, // command window over: `flags` DECISION_LEDS_OFF / DECISION_TRIGGER_LOW
+} actuator_kind_t;
+
+typedef struct
+{
+    uint8_t kind;  // actuator_kind_t
+    uint8_t leds;  // ACT_COMMAND: LED bitmask
+    uint16_t flags;
+    int64_t captured_at; // ACT_WAKE: the chunk's capture stamp, for the capture->GPIO trace
+    int64_t decided_at;  // ACT_WAKE: when the decision was made
+} actuator_event_t;
+
+/* Creates the queue and starts the actuation task (priority 2, core 0).
+ * Needs LEDC, TRIGGER_GPIO and ledc_fade_func_install() set up. */
+void actuator_start(void);
+
+/* Never blocks; returns false and counts a drop when the queue is full. */
+bool actuator_post(const actuator_event_t *ev);
+
+/* events posted but not yet applied */
+int actuator_pending(void);
@@ -0,0 +1,306 @@
+/* afe_bench.cpp - AFE configuration sweep; see afe_bench.h */
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_wn_iface.h"
+#include "esp_wn_models.h"
+#include "model_path.h"
+#include "freertos/FreeRTOS.h"
+#include "afe_bench.h"
+#include "pipeline.h"
+#include "hilexin.h"
+
+#define TAG "WAKE_DBG"
+#define BENCH_WORD_END_MS 1700 // hilexin.h: the word spans about 0.7-1.7 s
+#define BENCH_LATE_MS 1500     // a wake this long after an item's end still counts for it
+#define BENCH_MAX_ROWS 48
+#define BENCH_MAX_MODELS 4
+
+typedef struct
+{
+    const char *name;
+    bool word;        // hilexin clip in it; otherwise noise only
+    float gain_db;    // applied to the clip
+    float noise_dbfs; // uniform white noise RMS; 0 for none
+    uint32_t samples; // noise-only length; clip items are the clip's length
+} bench_item_t;
+
+/* fixed audio set: everything is generated from the embedded clip and a seeded generator */
+static const bench_item_t items[] = {
+    {"clean", true, 0.0f, 0.0f, 0},
+    {"far", true, -15.0f, 0.0f, 0},
+    {"noisy", true, 0.0f, -35.0f, 0},
+    {"far_noisy", true, -15.0f, -45.0f, 0},
+    {"noise", false, 0.0f, -45.0f, 10 * SAMPLE_RATE},
+};
+#define BENCH_ITEMS (int)(sizeof(items) / sizeof(items[0]))
+
+static const afe_mode_t modes[] = {AFE_MODE_LOW_COST, AFE_MODE_HIGH_PERF};
+static const char *const formats[] = {"M", "MR", "MM"};
+static const det_mode_t det_modes[] = {DET_MODE_90, DET_MODE_95};
+
+typedef struct
+{
+    afe_mode_t mode;
+    const char *format;
+    const char *wakenet;
+    det_mode_t det;
+    bool ok;
+    uint32_t feed_cycles;  // per fed chunk
+    uint32_t fetch_cycles; // per fetched chunk
+    uint32_t internal_kb;  // peak use while the AFE existed
+    uint32_t psram_kb;
+    int detected;
+    int positives;
+    int false_accepts;
+    float latency_ms_avg;
+    float latency_ms_max;
+} bench_row_t;
+
+static bench_row_t rows[BENCH_MAX_ROWS];
+
+static uint32_t clip_samples(void)
+{
+    return (uint32_t)(sizeof(hilexin) / sizeof(int16_t));
+}
+
+static uint32_t item_samples(const bench_item_t *it)
+{
+    return it->word ? clip_samples() : it->samples;
+}
+
+int afe_bench_truth(uint64_t *word_end, int max)
+{
+    uint64_t at = 0;
+    int n = 0;
+    for (int i = 0; i < BENCH_ITEMS; ++i)
+    {
+        if (items[i].word && n < max)
+            word_end[n++] = at + (uint64_t)BENCH_WORD_END_MS * SAMPLE_RATE / 1000;
+        at += item_samples(&items[i]);
+    }
+    return n;
+}
+
+/* sample i of the whole set, walking items in order; the noise seed restarts per item */
+typedef struct
+{
+    int item;
+    uint32_t pos;
+    uint32_t seed;
+    int32_t gain_q15;
+    int32_t noise_peak;
+} bench_source_t;
+
+static void source_item(bench_source_t *s, int item)
+{
+    const bench_item_t *it = &items[item];
+    s->item = item;
+    s->pos = 0;
+    s->seed = 2463534242u + (uint32_t)item;
+    s->gain_q15 = (int32_t)lrintf(32768.0f * powf(10.0f, it->gain_db / 20.0f));
+    // uniform in [-p, p] has RMS p / sqrt(3)
+    s->noise_peak = it->noise_dbfs < 0 ? (int32_t)lrintf(32768.0f * powf(10.0f, it->noise_dbfs / 20.0f) * 1.7320508f) : 0;
+}
+
+static bool source_next(bench_source_t *s, int16_t *out)
+{
+    while (s->item < BENCH_ITEMS && s->pos >= item_samples(&items[s->item]))
+        source_item(s, s->item + 1);
+    if (s->item >= BENCH_ITEMS)
+        return false;
+    const bench_item_t *it = &items[s->item];
+    int32_t v = 0;
+    if (it->word)
+    {
+        int16_t x = (int16_t)(hilexin[2 * s->pos] | hilexin[2 * s->pos + 1] << 8);
+        v = (x * s->gain_q15) >> 15;
+    }
+    if (s->noise_peak)
+    {
+        s->seed ^= s->seed << 13;
+        s->seed ^= s->seed >> 17;
+        s->seed ^= s->seed << 5;
+        v += (int32_t)(s->seed % (uint32_t)(2 * s->noise_peak + 1)) - s->noise_peak;
+    }
+    s->pos++;
+    *out = (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+    return true;
+}
+
+static const char *mode_name(afe_mode_t m)
+{
+    return m == AFE_MODE_HIGH_PERF ? "high_perf" : "low_cost";
+}
+
+static void score(bench_row_t *row, const uint64_t *wakes, int n_wakes)
+{
+    uint64_t truth[AFE_BENCH_MAX_POSITIVES];
+    row->positives = afe_bench_truth(truth, AFE_BENCH_MAX_POSITIVES);
+    uint64_t late = (uint64_t)BENCH_LATE_MS * SAMPLE_RATE / 1000;
+    uint64_t early = (uint64_t)BENCH_WORD_END_MS * SAMPLE_RATE / 1000; // no earlier than the word's own item
+    bool hit[AFE_BENCH_MAX_POSITIVES] = {};
+    double sum_ms = 0;
+    for (int w = 0; w < n_wakes; ++w)
+    {
+        int match = -1;
+        for (int t = 0; t < row->positives && match < 0; ++t)
+        {
+            if (wakes[w] + early >= truth[t] && wakes[w] <= truth[t] + late)
+                match = t;
+        }
+        if (match < 0)
+        {
+            row->false_accepts++;
+            continue;
+        }
+        if (hit[match])
+            continue; // a second trigger on the same word
+        hit[match] = true;
+        row->detected++;
+        float ms = wakes[w] > truth[match] ? (float)(wakes[w] - truth[match]) * 1000.0f / SAMPLE_RATE : 0.0f;
+        sum_ms += ms;
+        row->latency_ms_max = ms > row->latency_ms_max ? ms : row->latency_ms_max;
+    }
+    row->latency_ms_avg = row->detected ? (float)(sum_ms / row->detected) : 0.0f;
+}
+
+static void bench_config(srmodel_list_t *models, bench_row_t *row)
+{
+    afe_config_t *cfg = afe_config_init(row->format, models, AFE_TYPE_SR, row->mode);
+    if (!cfg)
+        return;
+    cfg->wakenet_model_name = (char *)row->wakenet;
+    cfg->wakenet_mode = row->det;
+
+    size_t internal0 = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    size_t psram0 = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    size_t internal_min = internal0, psram_min = psram0;
+
+    esp_afe_sr_iface_t *afe = esp_afe_handle_from_config(cfg);
+    esp_afe_sr_data_t *data = afe ? afe->create_from_config(cfg) : NULL;
+    afe_config_free(cfg);
+    if (!data)
+        return;
+
+    int feed_chunk = afe->get_feed_chunksize(data);
+    int channels = afe->get_feed_channel_num(data);
+    int fetch_chunk = afe->get_fetch_chunksize(data);
+    int16_t *buf = (int16_t *)heap_caps_malloc((size_t)feed_chunk * channels * sizeof(int16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!buf)
+    {
+        afe->destroy(data);
+        return;
+    }
+
+    uint64_t wakes[16];
+    int n_wakes = 0;
+    uint64_t feed_cycles = 0, fetch_cycles = 0, fed = 0, fetched = 0;
+    bench_source_t src;
+    source_item(&src, 0);
+    bool more = true;
+    while (more)
+    {
+        // mic channels all get the set; reference and unused channels stay silent (no playback)
+        for (int i = 0; i < feed_chunk; ++i)
+        {
+            int16_t x = 0;
+            more = more && source_next(&src, &x);
+            for (int c = 0; c < channels; ++c)
+                buf[i * channels + c] = row->format[c] == 'M' ? x : 0;
+        }
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        afe->feed(data, buf);
+        feed_cycles += esp_cpu_get_cycle_count() - t0;
+        fed++;
+
+        for (;;)
+        {
+            t0 = esp_cpu_get_cycle_count();
+            afe_fetch_result_t *res = afe->fetch_with_delay(data, 0);
+            uint32_t dt = esp_cpu_get_cycle_count() - t0;
+            if (!res || res->ret_value == ESP_FAIL)
+                break;
+            fetch_cycles += dt;
+            fetched++;
+            if (res->wakeup_state == WAKENET_DETECTED && n_wakes < (int)(sizeof(wakes) / sizeof(wakes[0])))
+                wakes[n_wakes++] = fetched * (uint64_t)fetch_chunk;
+        }
+        size_t f = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+        internal_min = f < internal_min ? f : internal_min;
+        f = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+        psram_min = f < psram_min ? f : psram_min;
+    }
+    heap_caps_free(buf);
+    afe->destroy(data);
+
+    row->ok = fetched > 0;
+    row->feed_cycles = fed ? (uint32_t)(feed_cycles / fed) : 0;
+    row->fetch_cycles = fetched ? (uint32_t)(fetch_cycles / fetched) : 0;
+    row->internal_kb = (uint32_t)((internal0 - internal_min) / 1024);
+    row->psram_kb = (uint32_t)((psram0 - psram_min) / 1024);
+    score(row, wakes, n_wakes);
+}
+
+void afe_bench_run(srmodel_list_t *models)
+{
+    const char *wakenets[BENCH_MAX_MODELS];
+    int n_wn = 0;
+    for (int i = 0; models && i < models->num && n_wn < BENCH_MAX_MODELS; ++i)
+    {
+        if (strstr(models->model_name[i], ESP_WN_PREFIX))
+            wakenets[n_wn++] = models->model_name[i];
+    }
+    if (n_wn == 0)
+    {
+        ESP_LOGE(TAG, "afe_bench: no WakeNet model in the partition");
+        return;
+    }
+
+    int n = 0;
+    for (int w = 0; w < n_wn; ++w)
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+            for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+                for (size_t d = 0; d < sizeof(det_modes) / sizeof(det_modes[0]) && n < BENCH_MAX_ROWS; ++d)
+                {
+                    bench_row_t *row = &rows[n++];
+                    memset(row, 0, sizeof(*row));
+                    row->mode = modes[m];
+                    row->format = formats[f];
+                    row->wakenet = wakenets[w];
+                    row->det = det_modes[d];
+                    bench_config(models, row);
+                    if (!row->ok)
+                    {
+                        printf("afe_bench mode=%s format=%s wakenet=%s det=%d error=create\n", mode_name(row->mode),
+                               row->format, row->wakenet, row->det == DET_MODE_95 ? 95 : 90);
+                        continue;
+                    }
+                    printf("afe_bench mode=%s format=%s wakenet=%s det=%d feed_cycles=%u fetch_cycles=%u "
+                           "internal_kb=%u psram_kb=%u detected=%d/%d false_accepts=%d latency_ms_avg=%.0f latency_ms_max=%.0f\n",
+                           mode_name(row->mode), row->format, row->wakenet, row->det == DET_MODE_95 ? 95 : 90,
+                           (unsigned)row->feed_cycles, (unsigned)row->fetch_cycles, (unsigned)row->internal_kb,
+                           (unsigned)row->psram_kb, row->detected, row->positives, row->false_accepts,
+                           row->latency_ms_avg, row->latency_ms_max);
+                }
+
+    printf("\n%-10s %-6s %-16s %-4s %12s %12s %8s %8s %9s %6s %8s %8s\n", "mode", "format", "wakenet", "det",
+           "feed_cyc", "fetch_cyc", "int_kb", "psram_kb", "detected", "false", "lat_avg", "lat_max");
+    for (int i = 0; i < n; ++i)
+    {
+        const bench_row_t *r = &rows[i];
+        if (!r->ok)
+        {
+            printf("%-10s %-6s %-16s %-4d %12s\n", mode_name(r->mode), r->format, r->wakenet,
+                   r->det == DET_MODE_95 ? 95 : 90, "(no AFE)");
+            continue;
+        }
+        printf("%-10s %-6s %-16s %-4d %12u %12u %8u %8u %6d/%-2d %6d %6.0fms %6.0fms\n", mode_name(r->mode), r->format,
+               r->wakenet, r->det == DET_MODE_95 ? 95 : 90, (unsigned)r->feed_cycles, (unsigned)r->fetch_cycles,
+               (unsigned)r->internal_kb, (unsigned)r->psram_kb, r->detected, r->positives, r->false_accepts,
+               r->latency_ms_avg, r->latency_ms_max);
+    }
+}
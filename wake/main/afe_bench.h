@@ -0,0 +1,22 @@
+/* afe_bench.h - A/B sweep of AFE mode, input format, WakeNet model and detection mode over a fixed audio set
+ *
+ * Each configuration gets a fresh AFE, is fed the same generated items (the
+ * hilexin clip clean, far, in noise, and a wake-free noise stretch), and is
+ * scored on cycles per chunk, peak internal/PSRAM use, detections, false
+ * accepts and latency from the end of the word. Runs at boot with
+ * CONFIG_WAKE_AFE_BENCH and on the host via wake/host (afe_bench).
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_afe_sr_models.h"
+
+#define AFE_BENCH_MAX_POSITIVES 8
+
+/* Input sample offset where each wake word of the audio set ends, in feed
+ * order; returns how many. The host uses it to script the stand-in WakeNet. */
+int afe_bench_truth(uint64_t *word_end, int max);
+
+/* Sweeps every WakeNet model in `models`; prints one line per configuration
+ * as it finishes and the comparison table at the end. */
+void afe_bench_run(srmodel_list_t *models);
@@ -0,0 +1,223 @@
+/* arena.cpp - one heap_caps region per memory class, bump-carved at boot, plus the hot-path heap guard */
+#include <stdio.h>
+#include <assert.h>
+#include <atomic>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "arena.h"
+
+#define TAG "WAKE_DBG"
+#define ARENA_HOT_TASKS 4
+
+typedef struct
+{
+    uint8_t *base;
+    size_t size;
+    size_t used;
+    uint32_t caps; // caps the region was actually allocated with
+} arena_region_t;
+
+static const char *const class_name[ARENA_CLASSES] = {"internal", "dma", "psram"};
+static const uint32_t class_caps[ARENA_CLASSES] = {
+    MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT,
+    MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT,
+    MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT,
+};
+static arena_region_t regions[ARENA_CLASSES];
+
+#if CONFIG_WAKE_PLACE_RING_INTERNAL
+#define PLACE_RING ARENA_PLACE_INTERNAL
+#elif CONFIG_WAKE_PLACE_RING_DMA
+#define PLACE_RING ARENA_PLACE_DMA
+#elif CONFIG_WAKE_PLACE_RING_PSRAM
+#define PLACE_RING ARENA_PLACE_PSRAM
+#else
+#define PLACE_RING ARENA_PLACE_AUTO
+#endif
+#if CONFIG_WAKE_PLACE_FEED_INTERNAL
+#define PLACE_FEED ARENA_PLACE_INTERNAL
+#elif CONFIG_WAKE_PLACE_FEED_DMA
+#define PLACE_FEED ARENA_PLACE_DMA
+#elif CONFIG_WAKE_PLACE_FEED_PSRAM
+#define PLACE_FEED ARENA_PLACE_PSRAM
+#else
+#define PLACE_FEED ARENA_PLACE_AUTO
+#endif
+
+static const char *const buf_name[ARENA_BUFFERS] = {"capture_ring", "capture_scratch", "feed", "preroll"};
+static arena_place_t places[ARENA_BUFFERS] = {PLACE_RING, ARENA_PLACE_AUTO, PLACE_FEED, ARENA_PLACE_AUTO};
+static arena_class_t buf_class[ARENA_BUFFERS];
+static size_t buf_bytes[ARENA_BUFFERS];
+
+static std::atomic<TaskHandle_t> hot_tasks[ARENA_HOT_TASKS]; // NULL until its task has written it
+static std::atomic<int> hot_count(0);                          // slots claimed, may run past ARENA_HOT_TASKS
+static std::atomic<uint32_t> hot_violations(0);
+static size_t last_violation_size = 0;
+static uint32_t last_violation_caps = 0;
+
+static size_t round_up(size_t v)
+{
+    return (v + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+void arena_set_place(arena_buf_t buf, arena_place_t place)
+{
+    places[buf] = place;
+}
+
+arena_place_t arena_get_place(arena_buf_t buf)
+{
+    return places[buf];
+}
+
+void arena_place_auto(arena_class_t cls)
+{
+    static const arena_place_t of_class[ARENA_CLASSES] = {ARENA_PLACE_INTERNAL, ARENA_PLACE_DMA, ARENA_PLACE_PSRAM};
+    for (int b = 0; b < ARENA_BUFFERS; ++b)
+    {
+        if (places[b] == ARENA_PLACE_AUTO)
+            places[b] = of_class[cls];
+    }
+}
+
+void arena_plan_add(arena_plan_t *plan, arena_buf_t buf, size_t bytes)
+{
+    size_t need = round_up(bytes);
+    arena_class_t cls;
+    switch (places[buf])
+    {
+    case ARENA_PLACE_INTERNAL:
+        cls = ARENA_INTERNAL;
+        break;
+    case ARENA_PLACE_DMA:
+        cls = ARENA_DMA;
+        break;
+    case ARENA_PLACE_PSRAM:
+        cls = ARENA_PSRAM;
+        break;
+    default:
+        cls = plan->bytes[ARENA_INTERNAL] + need <= (size_t)CONFIG_WAKE_ARENA_INTERNAL_BUDGET_KB * 1024 ? ARENA_INTERNAL : ARENA_PSRAM;
+        break;
+    }
+    plan->cls[buf] = cls;
+    plan->bytes[cls] += need;
+    plan->buffers[cls]++;
+}
+
+bool arena_init(const arena_plan_t *plan)
+{
+    for (int b = 0; b < ARENA_BUFFERS; ++b)
+        buf_class[b] = plan->cls[b];
+    for (int c = 0; c < ARENA_CLASSES; ++c)
+    {
+        arena_region_t *r = &regions[c];
+        if (!plan->bytes[c])
+            continue;
+        r->caps = class_caps[c];
+        r->base = (uint8_t *)heap_caps_aligned_alloc(ARENA_ALIGN, plan->bytes[c], r->caps);
+        if (!r->base && c == ARENA_PSRAM)
+        {
+            ESP_LOGW(TAG, "Arena: no PSRAM for %u bytes, using internal RAM", (unsigned)plan->bytes[c]);
+            r->caps = class_caps[ARENA_INTERNAL];
+            r->base = (uint8_t *)heap_caps_aligned_alloc(ARENA_ALIGN, plan->bytes[c], r->caps);
+        }
+        if (!r->base)
+        {
+            ESP_LOGE(TAG, "Arena: cannot reserve %u bytes of %s", (unsigned)plan->bytes[c], class_name[c]);
+            return false;
+        }
+        r->size = plan->bytes[c];
+        r->used = 0;
+        ESP_LOGI(TAG, "Arena: %s %u bytes for %d buffer(s) at %p", class_name[c], (unsigned)r->size, plan->buffers[c], r->base);
+    }
+    return true;
+}
+
+void *arena_alloc(arena_buf_t buf, size_t bytes)
+{
+    arena_class_t cls = buf_class[buf];
+    arena_region_t *r = &regions[cls];
+    size_t need = round_up(bytes);
+    if (!r->base || r->used + need > r->size)
+    {
+        ESP_LOGE(TAG, "Arena: %s (%u bytes of %s) not in the plan", buf_name[buf], (unsigned)bytes, class_name[cls]);
+        return NULL;
+    }
+    void *p = r->base + r->used;
+    r->used += need;
+    buf_bytes[buf] = bytes;
+    return p;
+}
+
+void arena_hot_enter(void)
+{
+    // the capture and feed tasks enter at the same moment on different cores
+    int i = hot_count.fetch_add(1, std::memory_order_relaxed);
+    if (i >= ARENA_HOT_TASKS)
+        return;
+    hot_tasks[i].store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+}
+
+uint32_t arena_hot_violations(void)
+{
+    return hot_violations.load(std::memory_order_relaxed);
+}
+
+const char *arena_class_name(arena_class_t cls)
+{
+    return class_name[cls];
+}
+
+void arena_report(void)
+{
+    for (int c = 0; c < ARENA_CLASSES; ++c)
+    {
+        const arena_region_t *r = &regions[c];
+        if (!r->base)
+            continue;
+        printf("arena %-8s %7u/%7u bytes%s\n", class_name[c], (unsigned)r->used, (unsigned)r->size,
+               r->caps == class_caps[c] ? "" : " (fallback to internal)");
+    }
+    for (int b = 0; b < ARENA_BUFFERS; ++b)
+    {
+        if (buf_bytes[b])
+            printf("arena   %-16s %6u bytes in %s\n", buf_name[b], (unsigned)buf_bytes[b], class_name[buf_class[b]]);
+    }
+    uint32_t v = arena_hot_violations();
+    if (v)
+        printf("arena hot-path heap allocations: %u (last %u bytes, caps 0x%x)\n", (unsigned)v,
+               (unsigned)last_violation_size, (unsigned)last_violation_caps);
+    else
+        printf("arena hot-path heap allocations: 0\n");
+}
+
+#if CONFIG_HEAP_USE_HOOKS
+/* Called by the heap after every successful allocation, so it must not log or
+ * allocate itself. esp-sr's own per-call allocations land here too. */
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    int n = hot_count.load(std::memory_order_relaxed);
+    if (!n)
+        return;
+    n = n < ARENA_HOT_TASKS ? n : ARENA_HOT_TASKS;
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < n; ++i)
+    {
+        // a claimed slot reads NULL until its task has stored the handle
+        if (hot_tasks[i].load(std::memory_order_acquire) == self)
+        {
+            last_violation_size = size;
+            last_violation_caps = caps;
+            hot_violations.fetch_add(1, std::memory_order_relaxed);
+#if CONFIG_WAKE_ARENA_HOT_ASSERT
+            assert(!"heap allocation on a wake hot-path task");
+#endif
+            return;
+        }
+    }
+}
+#endif
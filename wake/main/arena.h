@@ -0,0 +1,81 @@
+/* arena.h - boot-time static arena for the wake pipeline's buffers, one region per memory class */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Every buffer the pipeline owns is declared up front in an arena_plan_t,
+ * sized from the AFE chunk geometry, and carved out of one heap_caps block
+ * per class by arena_init(). Nothing is ever returned; the regions live for
+ * the life of the firmware, so steady state cannot fragment the heap. */
+typedef enum
+{
+    ARENA_INTERNAL, // internal 8-bit RAM
+    ARENA_DMA,      // internal, DMA capable
+    ARENA_PSRAM,    // external SPI RAM, internal when there is none
+    ARENA_CLASSES,
+} arena_class_t;
+
+/* Where a buffer should live. AUTO takes internal RAM while the plan's
+ * internal total stays within CONFIG_WAKE_ARENA_INTERNAL_BUDGET_KB and PSRAM
+ * after that: per-chunk buffers are touched every 32 ms on core 0, and
+ * through the cache (plus the SPIRAM cache workaround) PSRAM costs several
+ * times internal RAM per access. */
+typedef enum
+{
+    ARENA_PLACE_AUTO,
+    ARENA_PLACE_INTERNAL,
+    ARENA_PLACE_DMA,
+    ARENA_PLACE_PSRAM,
+} arena_place_t;
+
+/* every buffer the pipeline owns */
+typedef enum
+{
+    ARENA_BUF_CAPTURE_RING,    // capture -> feed SPSC ring, ring mode
+    ARENA_BUF_CAPTURE_SCRATCH, // capture overrun sink, ring mode
+    ARENA_BUF_FEED,            // feed chunk copied out of the ring, ring mode
+    ARENA_BUF_PREROLL,         // energy gate pre-roll chunks, CONFIG_WAKE_GATE
+    ARENA_BUFFERS,
+} arena_buf_t;
+
+#define ARENA_ALIGN 64 // cache line; every carve starts on one
+
+typedef struct
+{
+    size_t bytes[ARENA_CLASSES];
+    int buffers[ARENA_CLASSES];
+    arena_class_t cls[ARENA_BUFFERS]; // resolved placement of each declared buffer
+} arena_plan_t;
+
+/* Overrides the Kconfig placement of `buf` (WAKE_PLACE_*); takes effect for
+ * plans built afterwards. */
+void arena_set_place(arena_buf_t buf, arena_place_t place);
+arena_place_t arena_get_place(arena_buf_t buf);
+/* pins every buffer still on ARENA_PLACE_AUTO to `cls`, e.g. the placement bench's winner */
+void arena_place_auto(arena_class_t cls);
+
+/* declares `buf` as `bytes` long and resolves its class from its placement */
+void arena_plan_add(arena_plan_t *plan, arena_buf_t buf, size_t bytes);
+
+/* Allocates one region per class that has buffers. Call once, before any
+ * arena_alloc(). Returns false if a region could not be allocated. */
+bool arena_init(const arena_plan_t *plan);
+
+/* Next ARENA_ALIGN-aligned carve of `bytes` for `buf` from the region its
+ * plan placed it in; NULL (and an error log) when the plan did not reserve it. */
+void *arena_alloc(arena_buf_t buf, size_t bytes);
+
+/* Called by a pipeline task when it enters its loop. From then on any
+ * heap_caps allocation made on that task is counted as a hot-path
+ * violation (needs CONFIG_HEAP_USE_HOOKS), and aborts with
+ * CONFIG_WAKE_ARENA_HOT_ASSERT. */
+void arena_hot_enter(void);
+
+/* heap allocations seen on hot-path tasks since boot */
+uint32_t arena_hot_violations(void);
+
+const char *arena_class_name(arena_class_t cls);
+
+/* per-class reserved/used bytes, where each buffer went, and the violation count */
+void arena_report(void);
@@ -0,0 +1,92 @@
+/* audio_ring.cpp - lock-free SPSC ring between I2S capture and AFE feed */
+#include <string.h>
+#include "audio_ring.h"
+
+static uint32_t round_up_pow2(uint32_t v)
+{
+    uint32_t p = 1;
+    while (p < v)
+        p <<= 1;
+    return p;
+}
+
+size_t audio_ring_capacity(size_t capacity_samples)
+{
+    return round_up_pow2((uint32_t)capacity_samples);
+}
+
+bool audio_ring_init(audio_ring_t *ring, int16_t *buf, size_t capacity_samples)
+{
+    uint32_t cap = round_up_pow2((uint32_t)capacity_samples);
+    ring->buf = buf;
+    if (!ring->buf)
+        return false;
+    ring->mask = cap - 1;
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->tail.store(0, std::memory_order_relaxed);
+    ring->high_water = 0;
+    ring->overruns.store(0, std::memory_order_relaxed);
+    ring->underruns.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+size_t audio_ring_write_span(audio_ring_t *ring, int16_t **dst)
+{
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    uint32_t tail = ring->tail.load(std::memory_order_acquire);
+    uint32_t free_total = (ring->mask + 1) - (head - tail);
+    uint32_t to_end = (ring->mask + 1) - (head & ring->mask);
+    *dst = ring->buf + (head & ring->mask);
+    return free_total < to_end ? free_total : to_end;
+}
+
+void audio_ring_commit(audio_ring_t *ring, size_t samples)
+{
+    uint32_t head = ring->head.load(std::memory_order_relaxed) + (uint32_t)samples;
+    ring->head.store(head, std::memory_order_release);
+
+    uint32_t used = head - ring->tail.load(std::memory_order_relaxed);
+    if (used > ring->high_water)
+        ring->high_water = used;
+}
+
+void audio_ring_note_overrun(audio_ring_t *ring, size_t samples)
+{
+    ring->overruns.fetch_add((uint32_t)samples, std::memory_order_relaxed);
+}
+
+size_t audio_ring_available(const audio_ring_t *ring)
+{
+    return ring->head.load(std::memory_order_acquire) - ring->tail.load(std::memory_order_relaxed);
+}
+
+bool audio_ring_read(audio_ring_t *ring, int16_t *dst, size_t samples)
+{
+    uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+    uint32_t head = ring->head.load(std::memory_order_acquire);
+    if (head - tail < samples)
+        return false;
+
+    uint32_t off = tail & ring->mask;
+    uint32_t first = (ring->mask + 1) - off;
+    if (first > samples)
+        first = (uint32_t)samples;
+    memcpy(dst, ring->buf + off, first * sizeof(int16_t));
+    memcpy(dst + first, ring->buf, (samples - first) * sizeof(int16_t));
+
+    ring->tail.store(tail + (uint32_t)samples, std::memory_order_release);
+    return true;
+}
+
+void audio_ring_note_underrun(audio_ring_t *ring)
+{
+    ring->underruns.fetch_add(1, std::memory_order_relaxed);
+}
+
+void audio_ring_get_stats(const audio_ring_t *ring, audio_ring_stats_t *out)
+{
+    out->capacity = ring->mask + 1;
+    out->high_water = ring->high_water;
+    out->overruns = ring->overruns.load(std::memory_order_relaxed);
+    out->underruns = ring->underruns.load(std::memory_order_relaxed);
+}
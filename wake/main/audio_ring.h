@@ -0,0 +1,48 @@
+/* audio_ring.h - lock-free single-producer/single-consumer PCM ring */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+/* Producer and consumer indices live on separate cache lines so the capture
+ * core and the feed core never bounce the same line. */
+#define AUDIO_RING_CACHE_LINE 64
+
+typedef struct
+{
+    uint32_t capacity;   // samples
+    uint32_t high_water; // max samples ever queued
+    uint32_t overruns;   // samples dropped because the ring was full
+    uint32_t underruns;  // times the consumer stalled waiting for a chunk
+} audio_ring_stats_t;
+
+typedef struct
+{
+    alignas(AUDIO_RING_CACHE_LINE) std::atomic<uint32_t> head; // producer write index
+    uint32_t high_water;
+    std::atomic<uint32_t> overruns;
+
+    alignas(AUDIO_RING_CACHE_LINE) std::atomic<uint32_t> tail; // consumer read index
+    std::atomic<uint32_t> underruns;
+
+    alignas(AUDIO_RING_CACHE_LINE) int16_t *buf;
+    uint32_t mask;
+} audio_ring_t;
+
+/* samples of storage a ring asked for capacity_samples needs (the next power of two) */
+size_t audio_ring_capacity(size_t capacity_samples);
+/* buf holds audio_ring_capacity(capacity_samples) samples and outlives the ring */
+bool audio_ring_init(audio_ring_t *ring, int16_t *buf, size_t capacity_samples);
+
+/* producer side: contiguous free span at the write index, then commit what was filled */
+size_t audio_ring_write_span(audio_ring_t *ring, int16_t **dst);
+void audio_ring_commit(audio_ring_t *ring, size_t samples);
+void audio_ring_note_overrun(audio_ring_t *ring, size_t samples);
+
+/* consumer side: copies exactly `samples` or nothing */
+size_t audio_ring_available(const audio_ring_t *ring);
+bool audio_ring_read(audio_ring_t *ring, int16_t *dst, size_t samples);
+void audio_ring_note_underrun(audio_ring_t *ring);
+
+void audio_ring_get_stats(const audio_ring_t *ring, audio_ring_stats_t *out);
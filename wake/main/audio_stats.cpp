@@ -0,0 +1,73 @@
+/* audio_stats.cpp - window accumulator behind the feed task's periodic audio summary */
+#include <math.h>
+#include "event_log.h"
+#include "audio_stats.h"
+
+static void window_reset(audio_stats_t *acc)
+{
+    acc->sum_sq = 0;
+    acc->sum = 0;
+    acc->samples = 0;
+    acc->chunks = 0;
+    acc->silent_chunks = 0;
+    acc->clipped = 0;
+    acc->peak = 0;
+}
+
+void audio_stats_init(audio_stats_t *acc, const audio_stats_config_t *cfg)
+{
+    acc->cfg = *cfg;
+    window_reset(acc);
+    acc->last_overruns = 0;
+    acc->last_underruns = 0;
+    acc->requested.store(false, std::memory_order_relaxed);
+}
+
+bool audio_stats_add(audio_stats_t *acc, const signal_stats_t *chunk)
+{
+    acc->sum_sq += chunk->sum_sq;
+    acc->sum += chunk->sum;
+    acc->samples += chunk->samples;
+    acc->clipped += chunk->clipped;
+    acc->peak = chunk->peak > acc->peak ? chunk->peak : acc->peak;
+    acc->silent_chunks += signal_stats_below_rms(chunk, acc->cfg.silent_rms);
+    acc->chunks++;
+
+    if (acc->cfg.window_chunks && acc->chunks >= acc->cfg.window_chunks)
+        return true;
+    return acc->requested.load(std::memory_order_relaxed);
+}
+
+void audio_stats_publish(audio_stats_t *acc, uint32_t overruns, uint32_t underruns, audio_stats_summary_t *out)
+{
+    audio_stats_summary_t s;
+    double mean_sq = acc->samples ? (double)acc->sum_sq / (double)acc->samples : 0.0;
+    s.rms_dbfs = mean_sq > 0.0 ? (float)(10.0 * log10(mean_sq / (32768.0 * 32768.0))) : -120.0f;
+    s.dc = acc->samples ? (float)acc->sum / (float)acc->samples : 0.0f;
+    s.silent_ratio = acc->chunks ? (float)acc->silent_chunks / (float)acc->chunks : 0.0f;
+    s.peak = acc->peak;
+    s.clipped = acc->clipped;
+    s.chunks = acc->chunks;
+    s.overruns = overruns - acc->last_overruns;
+    s.underruns = underruns - acc->last_underruns;
+    acc->last_overruns = overruns;
+    acc->last_underruns = underruns;
+
+    // the feed task only queues the line; the event log task prints it
+    EVENT_LOG(EV_AUDIO_STATS, ev_f(s.rms_dbfs), ev_i(s.peak), ev_f(s.dc), ev_i((int32_t)(s.silent_ratio * 100.0f + 0.5f)),
+              ev_i((int32_t)s.clipped), ev_i((int32_t)s.overruns), ev_i((int32_t)s.underruns), ev_i((int32_t)s.chunks));
+    if (s.chunks && acc->silent_chunks == s.chunks)
+    {
+        EVENT_LOG(EV_AUDIO_SILENT, ev_i((int32_t)acc->cfg.silent_rms));
+    }
+
+    if (out)
+        *out = s;
+    window_reset(acc);
+    acc->requested.store(false, std::memory_order_relaxed);
+}
+
+void audio_stats_request(audio_stats_t *acc)
+{
+    acc->requested.store(true, std::memory_order_relaxed);
+}
@@ -0,0 +1,52 @@
+/* audio_stats.h - per-window audio statistics folded in O(1) per chunk, published once per window */
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "signal_stats.h"
+
+typedef struct
+{
+    uint32_t window_chunks; // publish after this many chunks, 0 = only on request
+    uint32_t silent_rms;    // a chunk whose RMS is below this counts as silent
+} audio_stats_config_t;
+
+typedef struct
+{
+    float rms_dbfs;     // over the whole window
+    float dc;           // mean sample value
+    float silent_ratio; // silent chunks / chunks
+    int32_t peak;
+    uint32_t clipped;
+    uint32_t chunks;
+    uint32_t overruns;  // capture overruns during the window
+    uint32_t underruns; // capture underruns during the window
+} audio_stats_summary_t;
+
+typedef struct
+{
+    audio_stats_config_t cfg;
+    uint64_t sum_sq;
+    int64_t sum;
+    uint64_t samples;
+    uint32_t chunks;
+    uint32_t silent_chunks;
+    uint32_t clipped;
+    int32_t peak;
+    uint32_t last_overruns;
+    uint32_t last_underruns;
+    std::atomic<bool> requested;
+} audio_stats_t;
+
+void audio_stats_init(audio_stats_t *acc, const audio_stats_config_t *cfg);
+
+/* Folds one chunk into the window. Returns true when the window is full or a
+ * summary was requested; the caller then calls audio_stats_publish(). */
+bool audio_stats_add(audio_stats_t *acc, const signal_stats_t *chunk);
+
+/* Closes the window: builds the summary, queues it as one event log line, resets the counters.
+ * overruns/underruns are the capture stage's running totals. */
+void audio_stats_publish(audio_stats_t *acc, uint32_t overruns, uint32_t underruns, audio_stats_summary_t *out);
+
+/* Any task: ask the owner to publish at the next chunk instead of waiting for the window. */
+void audio_stats_request(audio_stats_t *acc);
@@ -0,0 +1,66 @@
+/* boot_profile.cpp - esp_timer stamps for each boot phase and a one-line summary */
+#include <stdio.h>
+#include <atomic>
+#include "sdkconfig.h"
+#include "esp_timer.h"
+#include "boot_profile.h"
+
+typedef struct
+{
+    const char *name;
+    int64_t begin_us;
+    std::atomic<int64_t> end_us;
+} boot_phase_t;
+
+static boot_phase_t phases[BOOT_PROFILE_MAX_PHASES];
+static std::atomic<int> phase_count(0);
+static std::atomic<int64_t> listening_us(0);
+
+int boot_phase_begin(const char *name)
+{
+    int id = phase_count.fetch_add(1, std::memory_order_relaxed);
+    if (id >= BOOT_PROFILE_MAX_PHASES)
+        return -1;
+    phases[id].name = name;
+    phases[id].end_us.store(0, std::memory_order_relaxed);
+    phases[id].begin_us = esp_timer_get_time();
+    return id;
+}
+
+void boot_phase_end(int id)
+{
+    if (id >= 0)
+        phases[id].end_us.store(esp_timer_get_time(), std::memory_order_release);
+}
+
+void boot_listening(void)
+{
+    int64_t expected = 0;
+    if (!listening_us.compare_exchange_strong(expected, esp_timer_get_time()))
+        return;
+
+    char line[256];
+    int len = snprintf(line, sizeof(line), "boot:");
+    int n = phase_count.load(std::memory_order_relaxed);
+    for (int i = 0; i < n && i < BOOT_PROFILE_MAX_PHASES && len < (int)sizeof(line); ++i)
+    {
+        int64_t end = phases[i].end_us.load(std::memory_order_acquire);
+        if (end)
+            len += snprintf(line + len, sizeof(line) - len, " %s=%dms", phases[i].name, (int)((end - phases[i].begin_us) / 1000));
+        else
+            len += snprintf(line + len, sizeof(line) - len, " %s=?", phases[i].name);
+    }
+#if CONFIG_WAKE_FAST_BOOT
+    const char *mode = " (fast boot)";
+#else
+    const char *mode = "";
+#endif
+    if (len < (int)sizeof(line))
+        snprintf(line + len, sizeof(line) - len, " | listening at %d ms%s", (int)(listening_us.load() / 1000), mode);
+    printf("%s\n", line);
+}
+
+int64_t boot_listening_us(void)
+{
+    return listening_us.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,18 @@
+/* boot_profile.h - esp_timer stamps for each boot phase and a one-line summary */
+#pragma once
+
+#include <stdint.h>
+
+#define BOOT_PROFILE_MAX_PHASES 16
+
+/* Starts a named phase (name must be a literal); returns its id for boot_phase_end().
+ * Safe from several init tasks at once. */
+int boot_phase_begin(const char *name);
+void boot_phase_end(int id);
+
+/* Marks the pipeline as listening and prints the summary once, e.g.
+ * "boot: diag=45ms models=120ms afe=380ms periph=3ms i2s=1ms | listening at 902 ms" */
+void boot_listening(void);
+
+/* microseconds since esp_timer start (shortly after the 2nd-stage bootloader) when listening began, 0 before */
+int64_t boot_listening_us(void);
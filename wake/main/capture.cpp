@@ -0,0 +1,338 @@
+/* capture.cpp - I2S capture: SPSC ring copy mode or zero-copy DMA lease mode */
+#include <string.h>
+#include <atomic>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_idf_version.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "arena.h"
+#include "audio_ring.h"
+#include "capture.h"
+
+#define TAG "WAKE_DBG"
+#define CAPTURE_READ_SAMPLES 256 // one DMA frame per i2s_channel_read in ring mode
+#define CAPTURE_RING_CHUNKS 8    // feed chunks of slack between capture and AFE feed
+#define CAPTURE_MAX_SLOTS 16     // upper bound on DMA descriptors tracked in zero-copy mode
+
+static i2s_chan_handle_t rx_chan = NULL;
+static size_t chunk_samples = 0;
+static volatile bool running = false;
+
+#if CONFIG_WAKE_CAPTURE_ZERO_COPY
+
+/* A DMA buffer handed to the feeder by reference. The I2S driver recycles
+ * descriptors in hardware order, so the ISR drops new buffers rather than
+ * let the feeder hold more than dma_desc_num - 2 of them; `lapped` counts
+ * the case where hardware still overtook a leased buffer. */
+typedef struct
+{
+    const int16_t *data;
+    int slot;
+    int64_t at;
+} dma_ref_t;
+
+static QueueHandle_t ref_queue = NULL;
+static int slot_count = 0;
+static const void *slot_addr[CAPTURE_MAX_SLOTS];
+static std::atomic<uint8_t> slot_leased[CAPTURE_MAX_SLOTS];
+static std::atomic<int> outstanding(0);
+static uint32_t zc_high_water = 0;
+static uint32_t zc_overruns = 0;
+static uint32_t zc_lapped = 0;
+static std::atomic<uint32_t> zc_underruns(0);
+
+static int IRAM_ATTR slot_of(const void *buf)
+{
+    for (int i = 0; i < slot_count; ++i)
+    {
+        if (slot_addr[i] == buf)
+            return i;
+    }
+    if (slot_count == CAPTURE_MAX_SLOTS)
+        return -1;
+    slot_addr[slot_count] = buf;
+    return slot_count++;
+}
+
+static bool IRAM_ATTR on_recv(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    int max_outstanding = (int)(intptr_t)user_ctx;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 4, 0)
+    const void *buf = event->dma_buf;
+#else
+    const void *buf = *(void **)event->data;
+#endif
+    int slot = slot_of(buf);
+    if (slot < 0)
+        return false;
+
+    bool lapped = slot_leased[slot].load(std::memory_order_acquire);
+    if (lapped)
+        zc_lapped++;
+
+    int queued = outstanding.load(std::memory_order_relaxed);
+    if (lapped || queued >= max_outstanding || event->size / sizeof(int16_t) != chunk_samples)
+    {
+        zc_overruns += event->size / sizeof(int16_t);
+        return false;
+    }
+
+    // lease before publishing so a fast release can never be lost
+    slot_leased[slot].store(1, std::memory_order_release);
+    queued = outstanding.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    dma_ref_t ref = {(const int16_t *)buf, slot, esp_timer_get_time()};
+    BaseType_t woken = pdFALSE;
+    if (xQueueSendFromISR(ref_queue, &ref, &woken) != pdTRUE)
+    {
+        slot_leased[slot].store(0, std::memory_order_relaxed);
+        outstanding.fetch_sub(1, std::memory_order_relaxed);
+        zc_overruns += chunk_samples;
+        return false;
+    }
+    if ((uint32_t)queued * chunk_samples > zc_high_water)
+        zc_high_water = queued * chunk_samples;
+    return woken == pdTRUE;
+}
+
+void capture_plan(arena_plan_t *plan, size_t feed_samples)
+{
+    // chunks are the driver's own DMA buffers
+}
+
+esp_err_t capture_start(i2s_chan_handle_t rx, size_t feed_samples, int dma_desc_num)
+{
+    if (dma_desc_num < 3 || dma_desc_num > CAPTURE_MAX_SLOTS)
+        return ESP_ERR_INVALID_ARG;
+
+    rx_chan = rx;
+    chunk_samples = feed_samples;
+    slot_count = 0;
+    for (int i = 0; i < CAPTURE_MAX_SLOTS; ++i)
+        slot_leased[i].store(0, std::memory_order_relaxed);
+
+    ref_queue = xQueueCreate(dma_desc_num, sizeof(dma_ref_t));
+    if (!ref_queue)
+        return ESP_ERR_NO_MEM;
+
+    i2s_event_callbacks_t cbs = {};
+    cbs.on_recv = on_recv;
+    esp_err_t err = i2s_channel_register_event_callback(rx, &cbs, (void *)(intptr_t)(dma_desc_num - 2));
+    if (err != ESP_OK)
+        return err;
+
+    running = true;
+    ESP_LOGI(TAG, "Capture: zero-copy, %d DMA buffers of %d samples", dma_desc_num, (int)feed_samples);
+    return i2s_channel_enable(rx);
+}
+
+void capture_stop(void)
+{
+    running = false;
+    i2s_channel_disable(rx_chan);
+}
+
+bool capture_is_zero_copy(void)
+{
+    return true;
+}
+
+bool capture_acquire(capture_chunk_t *chunk, int16_t *copy_buf, TickType_t stall_ticks)
+{
+    dma_ref_t ref;
+    if (!running)
+        return false;
+    if (xQueueReceive(ref_queue, &ref, stall_ticks) != pdTRUE)
+    {
+        zc_underruns.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    chunk->data = ref.data;
+    chunk->samples = chunk_samples;
+    chunk->slot = ref.slot;
+    chunk->captured_at = ref.at;
+    return true;
+}
+
+void capture_release(capture_chunk_t *chunk)
+{
+    if (chunk->slot < 0)
+        return;
+    slot_leased[chunk->slot].store(0, std::memory_order_release);
+    outstanding.fetch_sub(1, std::memory_order_relaxed);
+    chunk->slot = -1;
+}
+
+size_t capture_pending(void)
+{
+    return (size_t)uxQueueMessagesWaiting(ref_queue) * chunk_samples;
+}
+
+void capture_get_stats(capture_stats_t *out)
+{
+    out->capacity = (uint32_t)(slot_count * chunk_samples);
+    out->high_water = zc_high_water;
+    out->overruns = zc_overruns;
+    out->underruns = zc_underruns.load(std::memory_order_relaxed);
+    out->lapped = zc_lapped;
+}
+
+#else /* ring mode */
+
+static audio_ring_t capture_ring;
+static std::atomic<TaskHandle_t> feeder(NULL);
+
+/* esp_timer stamp of each CAPTURE_READ_SAMPLES block, by block index of its last
+ * sample; written before the commit publishes the block */
+#define CAPTURE_STAMPS 64
+static int64_t block_at[CAPTURE_STAMPS];
+
+/* capture task: drain I2S DMA into the capture ring as fast as it fills, never blocking on the AFE */
+static void capture_Task(void *arg)
+{
+    int16_t *scratch = (int16_t *)arg;
+
+    ESP_LOGI(TAG, "Capture task started");
+    arena_hot_enter();
+
+    while (running)
+    {
+        int16_t *dst = NULL;
+        size_t span = audio_ring_write_span(&capture_ring, &dst);
+        bool dropping = (span == 0);
+        if (dropping)
+        {
+            // ring full: keep draining DMA so the driver never stalls, count what we discard
+            dst = scratch;
+            span = CAPTURE_READ_SAMPLES;
+        }
+        else if (span > CAPTURE_READ_SAMPLES)
+        {
+            span = CAPTURE_READ_SAMPLES;
+        }
+
+        size_t bytes_read = 0;
+        esp_err_t ret = i2s_channel_read(rx_chan, dst, span * sizeof(int16_t), &bytes_read, portMAX_DELAY);
+        if (ret != ESP_OK)
+        {
+            if (!running)
+                break;
+            ESP_LOGE(TAG, "i2s read error: %d", ret);
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+        if (bytes_read == 0)
+        {
+            ESP_LOGW(TAG, "i2s read returned 0 bytes");
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+
+        size_t got_samples = bytes_read / sizeof(int16_t);
+        if (dropping)
+        {
+            audio_ring_note_overrun(&capture_ring, got_samples);
+            continue;
+        }
+        uint32_t end = capture_ring.head.load(std::memory_order_relaxed) + (uint32_t)got_samples;
+        block_at[((end - 1) / CAPTURE_READ_SAMPLES) % CAPTURE_STAMPS] = esp_timer_get_time();
+        audio_ring_commit(&capture_ring, got_samples);
+        TaskHandle_t t = feeder.load(std::memory_order_acquire);
+        if (t)
+        {
+            xTaskNotifyGive(t);
+        }
+    }
+
+    vTaskDelete(NULL);
+}
+
+void capture_plan(arena_plan_t *plan, size_t feed_samples)
+{
+    arena_plan_add(plan, ARENA_BUF_CAPTURE_RING, audio_ring_capacity(feed_samples * CAPTURE_RING_CHUNKS) * sizeof(int16_t));
+    arena_plan_add(plan, ARENA_BUF_CAPTURE_SCRATCH, CAPTURE_READ_SAMPLES * sizeof(int16_t));
+}
+
+esp_err_t capture_start(i2s_chan_handle_t rx, size_t feed_samples, int dma_desc_num)
+{
+    rx_chan = rx;
+    chunk_samples = feed_samples;
+    size_t ring_samples = audio_ring_capacity(feed_samples * CAPTURE_RING_CHUNKS);
+    int16_t *ring_buf = (int16_t *)arena_alloc(ARENA_BUF_CAPTURE_RING, ring_samples * sizeof(int16_t));
+    int16_t *scratch = (int16_t *)arena_alloc(ARENA_BUF_CAPTURE_SCRATCH, CAPTURE_READ_SAMPLES * sizeof(int16_t));
+    if (!scratch || !audio_ring_init(&capture_ring, ring_buf, ring_samples))
+        return ESP_ERR_NO_MEM;
+
+    esp_err_t err = i2s_channel_enable(rx);
+    if (err != ESP_OK)
+        return err;
+
+    running = true;
+    ESP_LOGI(TAG, "Capture: ring, %d samples", (int)(capture_ring.mask + 1));
+    if (xTaskCreatePinnedToCore(capture_Task, "capture", 3072, scratch, 8, NULL, 0) != pdPASS)
+    {
+        running = false;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void capture_stop(void)
+{
+    running = false;
+    i2s_channel_disable(rx_chan); // unblocks a pending i2s_channel_read
+}
+
+bool capture_is_zero_copy(void)
+{
+    return false;
+}
+
+bool capture_acquire(capture_chunk_t *chunk, int16_t *copy_buf, TickType_t stall_ticks)
+{
+    feeder.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+    while (audio_ring_available(&capture_ring) < chunk_samples)
+    {
+        if (!running)
+            return false;
+        if (ulTaskNotifyTake(pdTRUE, stall_ticks) == 0)
+        {
+            audio_ring_note_underrun(&capture_ring);
+            return false;
+        }
+    }
+    uint32_t end = capture_ring.tail.load(std::memory_order_relaxed) + (uint32_t)chunk_samples;
+    audio_ring_read(&capture_ring, copy_buf, chunk_samples);
+    chunk->data = copy_buf;
+    chunk->samples = chunk_samples;
+    chunk->slot = -1;
+    chunk->captured_at = block_at[((end - 1) / CAPTURE_READ_SAMPLES) % CAPTURE_STAMPS];
+    return true;
+}
+
+void capture_release(capture_chunk_t *chunk)
+{
+    chunk->slot = -1;
+}
+
+size_t capture_pending(void)
+{
+    return audio_ring_available(&capture_ring);
+}
+
+void capture_get_stats(capture_stats_t *out)
+{
+    audio_ring_stats_t rs;
+    audio_ring_get_stats(&capture_ring, &rs);
+    out->capacity = rs.capacity;
+    out->high_water = rs.high_water;
+    out->overruns = rs.overruns;
+    out->underruns = rs.underruns;
+    out->lapped = 0;
+}
+
+#endif
@@ -0,0 +1,50 @@
+/* capture.h - I2S capture stage in front of the AFE feed */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "driver/i2s_std.h"
+#include "esp_err.h"
+#include "arena.h"
+
+/* One feed-sized chunk. In zero-copy mode `data` points into an I2S DMA
+ * buffer that stays leased to the caller until capture_release(). */
+typedef struct
+{
+    const int16_t *data;
+    size_t samples;
+    int slot;            // leased DMA slot, -1 when data is the caller's copy buffer
+    int64_t captured_at; // esp_timer_get_time() when the chunk's last sample left DMA
+} capture_chunk_t;
+
+typedef struct
+{
+    uint32_t capacity;   // samples of buffering between capture and feed
+    uint32_t high_water; // max samples ever queued
+    uint32_t overruns;   // samples dropped because the feeder fell behind
+    uint32_t underruns;  // times the feeder stalled for more than the stall timeout
+    uint32_t lapped;     // zero-copy only: DMA refilled a buffer that was still leased
+} capture_stats_t;
+
+/* Declares the capture stage's buffers for feed_samples-long chunks; call
+ * before arena_init(). capture_start() takes them from the arena. */
+void capture_plan(arena_plan_t *plan, size_t feed_samples);
+
+/* Registers the capture path on an initialised (not yet enabled) RX channel
+ * and enables it. In zero-copy mode the channel's dma_frame_num must equal
+ * feed_samples so one DMA buffer is exactly one AFE feed chunk. */
+esp_err_t capture_start(i2s_chan_handle_t rx, size_t feed_samples, int dma_desc_num);
+void capture_stop(void);
+
+/* true when chunks reference DMA memory and no copy buffer is needed */
+bool capture_is_zero_copy(void);
+
+/* Blocks for the next chunk. copy_buf (feed_samples long) is only used in
+ * ring mode. Returns false on stall timeout or when capture is stopped. */
+bool capture_acquire(capture_chunk_t *chunk, int16_t *copy_buf, TickType_t stall_ticks);
+void capture_release(capture_chunk_t *chunk);
+
+/* samples captured but not yet acquired by the feeder */
+size_t capture_pending(void);
+void capture_get_stats(capture_stats_t *out);
@@ -0,0 +1,429 @@
+/* cmd_table.cpp - MultiNet command table: partition replay, delta appends and loading into MultiNet */
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "esp_mn_speech_commands.h"
+#include "esp_process_sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "cmd_table.h"
+
+#define TAG "WAKE_DBG"
+#define SEG_ALIGN 4
+#define SEG_MAX_BODY (CMD_TABLE_MAX * CMD_TABLE_RECORD_MAX)
+#define SECTOR CMD_TABLE_SECTOR
+#define ERASE_GAP_MS 40 // more than one 32 ms AFE chunk between two sector erases
+
+static const esp_partition_t *part = NULL;
+static cmd_entry_t *entries = NULL; // CMD_TABLE_MAX, PSRAM when there is some
+static int count = 0;
+static cmd_table_info_t info;
+static bool stale = false; // flash past info.used is not erased (a torn append): the next change rewrites
+static SemaphoreHandle_t lock = NULL;
+
+uint32_t cmd_table_crc32(uint32_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *p++;
+        for (int i = 0; i < 8; ++i)
+            crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+    }
+    return ~crc;
+}
+
+size_t cmd_table_put_record(uint8_t *out, uint8_t op, int command_id, const char *phrase)
+{
+    size_t len = strlen(phrase);
+    if (len == 0 || len > CMD_TABLE_PHRASE_MAX)
+        return 0;
+    out[0] = op;
+    out[1] = (uint8_t)len;
+    out[2] = (uint8_t)(command_id & 0xFF);
+    out[3] = (uint8_t)((command_id >> 8) & 0xFF);
+    memcpy(out + 4, phrase, len);
+    return 4 + len;
+}
+
+size_t cmd_table_put_segment(uint8_t *out, uint8_t kind, uint32_t version, const uint8_t *body, size_t body_len,
+                             uint16_t records)
+{
+    cmd_seg_hdr_t hdr;
+    hdr.magic = CMD_TABLE_MAGIC;
+    hdr.format = CMD_TABLE_FORMAT;
+    hdr.kind = kind;
+    hdr.records = records;
+    hdr.version = version;
+    hdr.body_len = (uint32_t)body_len;
+    hdr.crc = cmd_table_crc32(0, body, body_len);
+    memmove(out + sizeof(hdr), body, body_len); // body may already sit right after the header
+    memcpy(out, &hdr, sizeof(hdr));
+    size_t n = sizeof(hdr) + body_len;
+    while (n % SEG_ALIGN)
+        out[n++] = 0xFF;
+    return n;
+}
+
+static int find(const cmd_entry_t *e, int n, const char *phrase, size_t len)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        if (strncmp(e[i].phrase, phrase, len) == 0 && e[i].phrase[len] == '\0')
+            return i;
+    }
+    return -1;
+}
+
+bool cmd_table_replay(const cmd_seg_hdr_t *hdr, const uint8_t *body, cmd_entry_t *e, int *count, int max)
+{
+    if (hdr->kind == CMD_SEG_BASE)
+        *count = 0;
+    size_t at = 0;
+    for (uint16_t r = 0; r < hdr->records; ++r)
+    {
+        if (at + 4 > hdr->body_len)
+            return false;
+        uint8_t op = body[at];
+        uint8_t len = body[at + 1];
+        int16_t id = (int16_t)(body[at + 2] | body[at + 3] << 8);
+        const char *phrase = (const char *)body + at + 4;
+        if (len == 0 || len > CMD_TABLE_PHRASE_MAX || at + 4 + len > hdr->body_len)
+            return false;
+        int i = find(e, *count, phrase, len);
+        if (op == CMD_OP_ADD)
+        {
+            if (i < 0)
+            {
+                if (*count == max)
+                    return false;
+                i = (*count)++;
+                memcpy(e[i].phrase, phrase, len);
+                e[i].phrase[len] = '\0';
+            }
+            e[i].command_id = id;
+        }
+        else if (op == CMD_OP_REMOVE)
+        {
+            if (i >= 0)
+            {
+                memmove(&e[i], &e[i + 1], (size_t)(*count - i - 1) * sizeof(cmd_entry_t));
+                (*count)--;
+            }
+        }
+        else
+        {
+            return false;
+        }
+        at += 4 + len;
+    }
+    return at == hdr->body_len;
+}
+
+static size_t padded(size_t n)
+{
+    return (n + SEG_ALIGN - 1) & ~(size_t)(SEG_ALIGN - 1);
+}
+
+/* true and its version if a complete base segment starts at `at` */
+static bool base_at(size_t at, uint8_t *body, uint32_t *version)
+{
+    cmd_seg_hdr_t hdr = {};
+    bool ok = esp_partition_read(part, at, &hdr, sizeof(hdr)) == ESP_OK && hdr.magic == CMD_TABLE_MAGIC &&
+              hdr.format == CMD_TABLE_FORMAT && hdr.kind == CMD_SEG_BASE && hdr.body_len <= SEG_MAX_BODY &&
+              sizeof(hdr) + hdr.body_len <= info.size &&
+              esp_partition_read(part, at + sizeof(hdr), body, hdr.body_len) == ESP_OK &&
+              cmd_table_crc32(0, body, hdr.body_len) == hdr.crc;
+    *version = hdr.version;
+    return ok;
+}
+
+static void load(void)
+{
+    count = 0;
+    info.version = 0;
+    info.segments = 0;
+    info.used = 0;
+    info.slot = 0;
+    stale = false;
+    uint8_t *body = (uint8_t *)heap_caps_malloc(SEG_MAX_BODY, MALLOC_CAP_DEFAULT);
+    if (!body)
+    {
+        ESP_LOGE(TAG, "command table: no memory to load");
+        return;
+    }
+    // the newer complete base is live; the other slot is an older table or a rewrite cut short
+    uint32_t v0, v1;
+    bool b0 = base_at(0, body, &v0);
+    if (base_at(info.size, body, &v1) && (!b0 || v1 > v0))
+        info.slot = info.size;
+    size_t at = 0;
+    while (at + sizeof(cmd_seg_hdr_t) <= info.size)
+    {
+        cmd_seg_hdr_t hdr;
+        if (esp_partition_read(part, info.slot + at, &hdr, sizeof(hdr)) != ESP_OK)
+            break;
+        if (hdr.magic == 0xFFFFFFFF)
+            break; // erased: end of the log
+        bool ok = hdr.magic == CMD_TABLE_MAGIC && hdr.format == CMD_TABLE_FORMAT &&
+                  hdr.kind == (info.segments == 0 ? CMD_SEG_BASE : CMD_SEG_DELTA) &&
+                  (info.segments == 0 || hdr.version > info.version) && hdr.body_len <= SEG_MAX_BODY &&
+                  at + sizeof(hdr) + hdr.body_len <= info.size;
+        ok = ok && esp_partition_read(part, info.slot + at + sizeof(hdr), body, hdr.body_len) == ESP_OK &&
+             cmd_table_crc32(0, body, hdr.body_len) == hdr.crc &&
+             cmd_table_replay(&hdr, body, entries, &count, CMD_TABLE_MAX);
+        if (!ok)
+        {
+            ESP_LOGW(TAG, "command table: bad segment at 0x%x, keeping the %u before it", (unsigned)(info.slot + at),
+                     (unsigned)info.segments);
+            stale = true;
+            if (info.segments == 0)
+                count = 0;
+            break;
+        }
+        info.segments++;
+        info.version = hdr.version;
+        at += padded(sizeof(hdr) + hdr.body_len);
+    }
+    info.used = (uint32_t)at;
+    heap_caps_free(body);
+    info.source = info.segments ? CMD_SRC_PARTITION : CMD_SRC_NONE;
+}
+
+esp_err_t cmd_table_init(const char *partition_label)
+{
+    if (!lock)
+        lock = xSemaphoreCreateMutex();
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (!entries)
+    {
+        entries = (cmd_entry_t *)heap_caps_calloc(CMD_TABLE_MAX, sizeof(cmd_entry_t), MALLOC_CAP_SPIRAM);
+        if (!entries)
+            entries = (cmd_entry_t *)heap_caps_calloc(CMD_TABLE_MAX, sizeof(cmd_entry_t), MALLOC_CAP_DEFAULT);
+    }
+    memset(&info, 0, sizeof(info));
+    count = 0;
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)CMD_TABLE_SUBTYPE,
+                                    partition_label);
+    esp_err_t err = !entries ? ESP_ERR_NO_MEM : part ? ESP_OK : ESP_ERR_NOT_FOUND;
+    if (part && entries)
+    {
+        info.size = (uint32_t)CMD_TABLE_SLOT_SIZE(part->size);
+        load();
+        ESP_LOGI(TAG, "command table: v%u, %d commands, %u/%u bytes in %u segments", (unsigned)info.version, count,
+                 (unsigned)info.used, (unsigned)info.size, (unsigned)info.segments);
+    }
+    else if (!part)
+    {
+        ESP_LOGW(TAG, "command table: no '%s' partition, using the Kconfig commands", partition_label);
+    }
+    xSemaphoreGive(lock);
+    return err;
+}
+
+void cmd_table_deinit(void)
+{
+    if (!lock)
+        return;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    heap_caps_free(entries);
+    entries = NULL;
+    count = 0;
+    part = NULL;
+    memset(&info, 0, sizeof(info));
+    xSemaphoreGive(lock);
+}
+
+/* Reads back what esp_mn_commands_update_from_sdkconfig() loaded, so the
+ * first change starts from the Kconfig list rather than from nothing. */
+static void seed_from_multinet(void)
+{
+    count = 0;
+    esp_mn_phrase_t *p;
+    while (count < CMD_TABLE_MAX && (p = esp_mn_commands_get_from_index(count)) != NULL)
+    {
+        entries[count].command_id = p->command_id;
+        snprintf(entries[count].phrase, sizeof(entries[count].phrase), "%s", p->string);
+        count++;
+    }
+    info.source = CMD_SRC_SDKCONFIG;
+}
+
+esp_err_t cmd_table_apply(esp_mn_iface_t *multinet, model_iface_data_t *model_data)
+{
+    if (!lock || !entries)
+    {
+        esp_mn_commands_update_from_sdkconfig(multinet, model_data);
+        return ESP_OK;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (info.source != CMD_SRC_PARTITION)
+    {
+        esp_mn_commands_update_from_sdkconfig(multinet, model_data);
+        if (info.source == CMD_SRC_NONE)
+            seed_from_multinet();
+        xSemaphoreGive(lock);
+        return ESP_OK;
+    }
+    // the phrase list is copied under the lock; the model update, the slow part, runs without it
+    esp_mn_commands_alloc(multinet, model_data);
+    esp_mn_commands_clear();
+    int rejected = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (esp_mn_commands_add(entries[i].command_id, entries[i].phrase) != ESP_OK)
+            rejected++;
+    }
+    unsigned version = (unsigned)info.version;
+    int n = count;
+    xSemaphoreGive(lock);
+
+    esp_mn_error_t *errors = esp_mn_commands_update();
+    if (errors)
+        rejected += errors->num;
+    if (rejected)
+        ESP_LOGW(TAG, "command table v%u: %d of %d phrases rejected by MultiNet", version, rejected, n);
+    else
+        ESP_LOGI(TAG, "command table v%u: %d commands loaded", version, n);
+    return ESP_OK;
+}
+
+/* Writes the table as one base segment into the other slot, erased first a
+ * sector at a time. Each erase stalls the flash/PSRAM cache on both cores for
+ * tens of ms; the pause after it lets feed and detect catch up before the
+ * next one. The live slot is left as it is: until the new base is complete,
+ * load() still picks it. */
+static esp_err_t rewrite(uint32_t version)
+{
+    uint8_t *seg = (uint8_t *)heap_caps_malloc(sizeof(cmd_seg_hdr_t) + SEG_MAX_BODY + SEG_ALIGN, MALLOC_CAP_DEFAULT);
+    if (!seg)
+        return ESP_ERR_NO_MEM;
+    uint8_t *body = seg + sizeof(cmd_seg_hdr_t);
+    size_t body_len = 0;
+    for (int i = 0; i < count; ++i)
+        body_len += cmd_table_put_record(body + body_len, CMD_OP_ADD, entries[i].command_id, entries[i].phrase);
+    size_t n = cmd_table_put_segment(seg, CMD_SEG_BASE, version, body, body_len, (uint16_t)count);
+
+    // without a table yet the live slot holds nothing worth keeping
+    uint32_t slot = info.segments == 0 ? info.slot : info.slot ? 0 : info.size;
+    esp_err_t err = n <= info.size ? ESP_OK : ESP_ERR_INVALID_SIZE;
+    for (size_t at = 0; err == ESP_OK && at < info.size; at += SECTOR)
+    {
+        if (at)
+            vTaskDelay(pdMS_TO_TICKS(ERASE_GAP_MS));
+        err = esp_partition_erase_range(part, slot + at, SECTOR);
+    }
+    if (err == ESP_OK)
+        err = esp_partition_write(part, slot, seg, n);
+    heap_caps_free(seg);
+    if (err != ESP_OK)
+    {
+        stale = true; // the table stays changed in RAM; the next change tries again
+        return err;
+    }
+    stale = false;
+    info.slot = slot;
+    info.used = (uint32_t)n;
+    info.segments = 1;
+    info.version = version;
+    info.source = CMD_SRC_PARTITION;
+    info.compactions++;
+    return ESP_OK;
+}
+
+/* Appends one record as a delta segment, or rewrites the partition when the
+ * delta does not fit or there is no base yet; then applies it to the table. */
+static esp_err_t commit(uint8_t op, int command_id, const char *phrase)
+{
+    uint8_t seg[sizeof(cmd_seg_hdr_t) + CMD_TABLE_RECORD_MAX + SEG_ALIGN];
+    uint8_t *rec = seg + sizeof(cmd_seg_hdr_t);
+    size_t rec_len = cmd_table_put_record(rec, op, command_id, phrase);
+    size_t n = cmd_table_put_segment(seg, CMD_SEG_DELTA, info.version + 1, rec, rec_len, 1);
+    cmd_seg_hdr_t hdr;
+    memcpy(&hdr, seg, sizeof(hdr));
+
+    if (info.segments && !stale && info.used + n <= info.size)
+    {
+        esp_err_t err = esp_partition_write(part, info.slot + info.used, seg, n);
+        if (err != ESP_OK)
+        {
+            stale = true;
+            return err;
+        }
+        cmd_table_replay(&hdr, rec, entries, &count, CMD_TABLE_MAX);
+        info.used += (uint32_t)n;
+        info.segments++;
+        info.version = hdr.version;
+        return ESP_OK;
+    }
+    cmd_table_replay(&hdr, rec, entries, &count, CMD_TABLE_MAX);
+    return rewrite(hdr.version);
+}
+
+static bool phrase_ok(const char *phrase)
+{
+    size_t len = phrase ? strlen(phrase) : 0;
+    return len > 0 && len <= CMD_TABLE_PHRASE_MAX;
+}
+
+esp_err_t cmd_table_add(int command_id, const char *phrase)
+{
+    if (!phrase_ok(phrase) || command_id < 0 || command_id > INT16_MAX)
+        return ESP_ERR_INVALID_ARG;
+    if (!lock || !part || !entries)
+        return ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    esp_err_t err = ESP_OK;
+    int i = find(entries, count, phrase, strlen(phrase));
+    if (info.source == CMD_SRC_NONE && info.segments == 0)
+        err = ESP_ERR_INVALID_STATE; // the Kconfig list it would start from is not read back yet
+    else if (i < 0 && count == CMD_TABLE_MAX)
+        err = ESP_ERR_NO_MEM;
+    else if (i < 0 || entries[i].command_id != command_id)
+        err = commit(CMD_OP_ADD, command_id, phrase);
+    xSemaphoreGive(lock);
+    return err;
+}
+
+esp_err_t cmd_table_remove(const char *phrase)
+{
+    if (!phrase_ok(phrase))
+        return ESP_ERR_INVALID_ARG;
+    if (!lock || !part || !entries)
+        return ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    if (find(entries, count, phrase, strlen(phrase)) >= 0)
+        err = commit(CMD_OP_REMOVE, 0, phrase);
+    xSemaphoreGive(lock);
+    return err;
+}
+
+bool cmd_table_get(int index, cmd_entry_t *out)
+{
+    if (!lock)
+        return false;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool ok = index >= 0 && index < count;
+    if (ok)
+        *out = entries[index];
+    xSemaphoreGive(lock);
+    return ok;
+}
+
+void cmd_table_get_info(cmd_table_info_t *out)
+{
+    if (!lock)
+    {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    *out = info;
+    out->count = (uint16_t)count;
+    xSemaphoreGive(lock);
+}
@@ -0,0 +1,120 @@
+/* cmd_table.h - MultiNet command table kept as a versioned blob in a flash data partition
+ *
+ * Partition layout: two slots, the halves of the partition (whole sectors).
+ * The live slot holds a base segment with the whole table, then one delta
+ * segment per add/remove appended behind it. A segment is a cmd_seg_hdr_t and
+ * `records` records, padded to 4 bytes:
+ *
+ *   op (CMD_OP_ADD / CMD_OP_REMOVE) | len | command_id (int16) | phrase[len]
+ *
+ * little-endian, phrase without a NUL. Load takes the slot whose base segment
+ * is valid and newest, replays its segments in order and stops at erased
+ * flash or at the first segment that fails its magic, version or CRC-32, so
+ * an append cut short by a reset only loses itself. When an append does not
+ * fit, the other slot is erased and the table written there as one base
+ * segment; the old slot stays valid until that base is complete, so a reset
+ * during the rewrite loses at most the change being written. Images built
+ * on the host hold their base in slot 0. Without a partition, or with an
+ * empty one, MultiNet gets the Kconfig command list and the table is seeded
+ * from it.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_mn_iface.h"
+
+#define CMD_TABLE_MAGIC 0x31444D43 // "CMD1"
+#define CMD_TABLE_FORMAT 1
+#define CMD_TABLE_SUBTYPE 0x40 // data partition subtype, see wake/partitions.csv
+#define CMD_TABLE_MAX 400      // commands; MultiNet's own limit
+#define CMD_TABLE_PHRASE_MAX 63
+#define CMD_TABLE_RECORD_MAX (4 + CMD_TABLE_PHRASE_MAX)
+#define CMD_TABLE_SECTOR 4096
+#define CMD_TABLE_SLOT_SIZE(partition_size) ((partition_size) / 2 / CMD_TABLE_SECTOR * CMD_TABLE_SECTOR)
+
+typedef enum
+{
+    CMD_SEG_BASE = 1,  // replaces the table
+    CMD_SEG_DELTA = 2, // changes it
+} cmd_seg_kind_t;
+
+typedef enum
+{
+    CMD_OP_ADD = 1,    // adds the phrase, or moves it to command_id
+    CMD_OP_REMOVE = 2, // command_id ignored
+} cmd_op_t;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint8_t format;
+    uint8_t kind; // cmd_seg_kind_t
+    uint16_t records;
+    uint32_t version;  // table version once this segment is applied; increases along the partition
+    uint32_t body_len; // record bytes after the header, before padding
+    uint32_t crc;      // CRC-32 (IEEE) of the records
+} cmd_seg_hdr_t;
+
+typedef struct
+{
+    int16_t command_id;
+    char phrase[CMD_TABLE_PHRASE_MAX + 1];
+} cmd_entry_t;
+
+typedef enum
+{
+    CMD_SRC_NONE,      // not loaded yet
+    CMD_SRC_SDKCONFIG, // Kconfig list; the first change writes it to the partition
+    CMD_SRC_PARTITION,
+} cmd_table_source_t;
+
+typedef struct
+{
+    cmd_table_source_t source;
+    uint32_t version;
+    uint16_t count;
+    uint16_t segments; // in the live slot, base included
+    uint32_t slot;     // partition offset of the live slot
+    uint32_t used;     // bytes in use in the live slot
+    uint32_t size;     // slot size, 0 without a partition
+    uint32_t compactions;
+} cmd_table_info_t;
+
+/* ---- blob format, shared with the host tools ---- */
+
+uint32_t cmd_table_crc32(uint32_t crc, const void *data, size_t len);
+/* one record; 0 if the phrase is empty or too long */
+size_t cmd_table_put_record(uint8_t *out, uint8_t op, int command_id, const char *phrase);
+/* Header for `body` (its records) into out; returns the padded segment size. */
+size_t cmd_table_put_segment(uint8_t *out, uint8_t kind, uint32_t version, const uint8_t *body, size_t body_len,
+                             uint16_t records);
+/* Applies a segment's records to entries[*count]; false if a record is malformed.
+ * A base segment starts from an empty table. Order is kept; a remove closes the gap. */
+bool cmd_table_replay(const cmd_seg_hdr_t *hdr, const uint8_t *body, cmd_entry_t *entries, int *count, int max);
+
+/* ---- the device's table ---- */
+
+/* Finds the data partition (subtype CMD_TABLE_SUBTYPE) and replays it.
+ * ESP_ERR_NOT_FOUND without one: the table then only follows the Kconfig list. */
+esp_err_t cmd_table_init(const char *partition_label);
+void cmd_table_deinit(void);
+
+/* Loads the table into a MultiNet instance that no task is detecting on (a
+ * fresh one): the slow part, seconds on the larger models, runs on the
+ * caller's task. Phrases go to esp_mn_commands_add() as stored (graphemes for
+ * MultiNet 6/7). Until the partition holds a table the Kconfig list is loaded. */
+esp_err_t cmd_table_apply(esp_mn_iface_t *multinet, model_iface_data_t *model_data);
+
+/* Append a delta to the partition, then change the table; the running
+ * MultiNet keeps the old list until model_registry_multinet_rebuild().
+ * ESP_ERR_INVALID_ARG: bad phrase or id; ESP_ERR_NO_MEM: CMD_TABLE_MAX reached;
+ * ESP_ERR_NOT_FOUND: no partition, or (remove) no such phrase;
+ * ESP_ERR_INVALID_STATE (add): empty partition and MultiNet not loaded yet. */
+esp_err_t cmd_table_add(int command_id, const char *phrase);
+esp_err_t cmd_table_remove(const char *phrase);
+
+/* entry `index` in table order; false past the end */
+bool cmd_table_get(int index, cmd_entry_t *out);
+void cmd_table_get_info(cmd_table_info_t *out);
@@ -0,0 +1,45 @@
+/* decision.cpp - detect_Task's wake/command decision logic as a pure state machine */
+#include <string.h>
+#include "decision.h"
+
+void decision_init(decision_t *d, const decision_config_t *cfg)
+{
+    d->cfg = *cfg;
+    d->awake = false;
+}
+
+bool decision_on_fetch(decision_t *d, const afe_fetch_result_t *res, decision_actions_t *act)
+{
+    memset(act, 0, sizeof(*act));
+    bool wake = res->wakeup_state == WAKENET_DETECTED ||
+                (res->raw_data_channels > 1 && res->wakeup_state == WAKENET_CHANNEL_VERIFIED);
+    if (wake)
+    {
+        d->awake = true;
+        act->flags |= DECISION_TRIGGER_HIGH;
+    }
+    return d->awake;
+}
+
+void decision_on_command(decision_t *d, esp_mn_state_t state, const esp_mn_results_t *results, decision_actions_t *act)
+{
+    if (state == ESP_MN_STATE_DETECTED)
+    {
+        for (int i = 0; i < results->num && i < ESP_MN_RESULT_MAX_NUM; i++)
+        {
+            if (results->prob[i] > d->cfg.cmd_threshold)
+            {
+                uint16_t e = phrase_entry(results->command_id[i]);
+                uint8_t severity = (uint8_t)phrase_severity(e);
+                act->led_on |= (uint8_t)phrase_leds(e);
+                act->severity = severity > act->severity ? severity : act->severity;
+                act->command_id[act->commands++] = results->command_id[i];
+            }
+        }
+    }
+    else if (state == ESP_MN_STATE_TIMEOUT)
+    {
+        d->awake = false;
+        act->flags |= DECISION_LEDS_OFF | DECISION_TRIGGER_LOW;
+    }
+}
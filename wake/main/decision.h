@@ -0,0 +1,48 @@
+/* decision.h - detect_Task's wake/command decision logic as a pure state machine
+ *
+ * No RTOS, driver or model calls: detect_Task applies the returned actions to
+ * TRIGGER_GPIO and the LEDs, and the host tools run the same logic per file.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_afe_sr_iface.h"
+#include "esp_mn_iface.h"
+#include "phrase_table.h" // generated from phrase_manifest.csv
+
+#define DECISION_LED_COUNT 3
+static_assert(PHRASE_LED_BITS == DECISION_LED_COUNT, "phrase_manifest.py packs one bit per LED");
+
+#define DECISION_TRIGGER_HIGH 0x01 // wake word: raise TRIGGER_GPIO
+#define DECISION_TRIGGER_LOW 0x02  // command window timed out: drop TRIGGER_GPIO
+#define DECISION_LEDS_OFF 0x04     // command window timed out: all LEDs off
+
+typedef struct
+{
+    float cmd_threshold; // a command takes its manifest action above this probability
+} decision_config_t;
+
+typedef struct
+{
+    uint32_t flags;   // DECISION_* bits
+    uint8_t led_on;   // bitmask of LEDs to switch on
+    uint8_t severity; // highest manifest severity among the accepted commands, 0 without any
+    int commands;     // accepted commands in command_id[]
+    int command_id[ESP_MN_RESULT_MAX_NUM];
+} decision_actions_t;
+
+typedef struct
+{
+    decision_config_t cfg;
+    bool awake; // MultiNet runs on every chunk from a wake until its command window times out
+} decision_t;
+
+void decision_init(decision_t *d, const decision_config_t *cfg);
+
+/* Per fetched chunk. Clears act, records a wake and returns true when MultiNet
+ * should run on this chunk, i.e. inside a command window. */
+bool decision_on_fetch(decision_t *d, const afe_fetch_result_t *res, decision_actions_t *act);
+
+/* After multinet->detect() on the same chunk; results may be NULL unless state is DETECTED.
+ * TIMEOUT closes the command window until the next wake. */
+void decision_on_command(decision_t *d, esp_mn_state_t state, const esp_mn_results_t *results, decision_actions_t *act);
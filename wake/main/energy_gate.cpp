@@ -0,0 +1,142 @@
+/* energy_gate.cpp - adaptive-floor energy gate and pre-roll ring for the feed task; integer compares per chunk */
+#include <math.h>
+#include <string.h>
+#include "energy_gate.h"
+
+#define FULL_SCALE_MS (32768.0 * 32768.0)
+#define FLOOR_FALL_SHIFT 2  // quieter chunk: floor follows within a few chunks
+#define FLOOR_RISE_SHIFT 5  // quiet chunk above the floor: ~1 s at 32 ms chunks
+#define FLOOR_LOUD_SHIFT 8  // loud chunk: ~8 s, so speech barely moves it but a louder room is learned
+
+void energy_gate_init(energy_gate_t *g, const energy_gate_config_t *cfg, int16_t *preroll)
+{
+    g->cfg = *cfg;
+    if (g->cfg.chunk_ms == 0)
+        g->cfg.chunk_ms = 1;
+    if (g->cfg.preroll_chunks > ENERGY_GATE_MAX_PREROLL)
+        g->cfg.preroll_chunks = ENERGY_GATE_MAX_PREROLL;
+    if (!preroll)
+        g->cfg.preroll_chunks = 0;
+    g->preroll = preroll;
+    g->head = 0;
+    g->stashed = 0;
+    g->floor_ms = 0;
+    g->open_q8 = (uint32_t)lrint(256.0 * pow(10.0, g->cfg.open_db_x10 / 100.0));
+    g->hold_chunks = (g->cfg.hold_ms + g->cfg.chunk_ms - 1) / g->cfg.chunk_ms;
+    g->hold_left = 0;
+    g->open = false;
+    g->primed = false;
+    g->enabled.store(true, std::memory_order_relaxed);
+    g->keep_open.store(false, std::memory_order_relaxed);
+    g->floor_pub.store(0, std::memory_order_relaxed);
+    g->open_pub.store(false, std::memory_order_relaxed);
+    g->chunks.store(0, std::memory_order_relaxed);
+    g->fed.store(0, std::memory_order_relaxed);
+    g->replayed.store(0, std::memory_order_relaxed);
+    g->dropped.store(0, std::memory_order_relaxed);
+    g->opens.store(0, std::memory_order_relaxed);
+}
+
+static void bump(std::atomic<uint32_t> &c)
+{
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); // single writer
+}
+
+static void track_floor(energy_gate_t *g, uint64_t ms_q8, bool loud)
+{
+    if (!g->primed)
+    {
+        g->floor_ms = ms_q8;
+        g->primed = true;
+    }
+    else if (ms_q8 < g->floor_ms)
+        g->floor_ms -= (g->floor_ms - ms_q8) >> FLOOR_FALL_SHIFT;
+    else
+        g->floor_ms += (ms_q8 - g->floor_ms) >> (loud ? FLOOR_LOUD_SHIFT : FLOOR_RISE_SHIFT);
+    g->floor_pub.store((uint32_t)(g->floor_ms >> 8), std::memory_order_relaxed);
+}
+
+bool energy_gate_add(energy_gate_t *g, const signal_stats_t *chunk)
+{
+    bump(g->chunks);
+    uint32_t n = chunk->samples ? chunk->samples : 1;
+    uint64_t ms_q8 = (chunk->sum_sq << 8) / n;
+    // compare before the floor moves, so the chunk that opens the gate is judged against the quiet before it
+    bool loud = g->primed && ms_q8 * 256 > g->floor_ms * g->open_q8 &&
+                chunk->sum_sq > (uint64_t)g->cfg.min_rms * g->cfg.min_rms * n;
+    track_floor(g, ms_q8, loud);
+
+    if (loud)
+        g->hold_left = g->hold_chunks;
+    bool feed = loud || g->hold_left > 0 || g->keep_open.load(std::memory_order_relaxed) ||
+                !g->enabled.load(std::memory_order_relaxed);
+    if (!loud && g->hold_left > 0)
+        g->hold_left--;
+
+    if (feed && !g->open)
+        bump(g->opens);
+    g->open = feed;
+    g->open_pub.store(feed, std::memory_order_relaxed);
+    if (feed)
+        bump(g->fed);
+    return feed;
+}
+
+void energy_gate_stash(energy_gate_t *g, const int16_t *data, int64_t captured_at)
+{
+    uint32_t slots = g->cfg.preroll_chunks;
+    if (slots == 0)
+    {
+        bump(g->dropped);
+        return;
+    }
+    if (g->stashed == slots)
+    {
+        g->head = (g->head + 1) % slots; // oldest falls out unfed
+        g->stashed--;
+        bump(g->dropped);
+    }
+    uint32_t slot = (g->head + g->stashed) % slots;
+    memcpy(g->preroll + (size_t)slot * g->cfg.chunk_samples, data, g->cfg.chunk_samples * sizeof(int16_t));
+    g->preroll_at[slot] = captured_at;
+    g->stashed++;
+}
+
+bool energy_gate_replay(energy_gate_t *g, const int16_t **data, int64_t *captured_at)
+{
+    if (g->stashed == 0)
+        return false;
+    *data = g->preroll + (size_t)g->head * g->cfg.chunk_samples;
+    *captured_at = g->preroll_at[g->head];
+    g->head = (g->head + 1) % g->cfg.preroll_chunks;
+    g->stashed--;
+    bump(g->replayed);
+    return true;
+}
+
+void energy_gate_enable(energy_gate_t *g, bool on)
+{
+    g->enabled.store(on, std::memory_order_relaxed);
+}
+
+bool energy_gate_enabled(const energy_gate_t *g)
+{
+    return g->enabled.load(std::memory_order_relaxed);
+}
+
+void energy_gate_keep_open(energy_gate_t *g, bool on)
+{
+    g->keep_open.store(on, std::memory_order_relaxed);
+}
+
+void energy_gate_get_stats(const energy_gate_t *g, energy_gate_stats_t *out)
+{
+    out->chunks = g->chunks.load(std::memory_order_relaxed);
+    out->fed = g->fed.load(std::memory_order_relaxed);
+    out->replayed = g->replayed.load(std::memory_order_relaxed);
+    out->dropped = g->dropped.load(std::memory_order_relaxed);
+    out->opens = g->opens.load(std::memory_order_relaxed);
+    out->open = g->open_pub.load(std::memory_order_relaxed);
+    uint32_t floor = g->floor_pub.load(std::memory_order_relaxed);
+    out->floor_dbfs_x10 = floor ? (int16_t)lrint(100.0 * log10(floor / FULL_SCALE_MS)) : -1200;
+}
@@ -0,0 +1,78 @@
+/* energy_gate.h - energy pre-detector in front of the AFE: idle chunks wait in a pre-roll ring instead of being fed
+ *
+ * The gate tracks an adaptive noise floor on the per-chunk mean square the
+ * feed task already computes. A chunk that rises open_db above the floor (and
+ * above min_rms) opens the gate; it stays open for hold_ms after the last
+ * loud chunk and while keep_open is set (the MultiNet command window). While
+ * closed, chunks are copied into the pre-roll ring and not fed, so AFE and
+ * WakeNet do no work. On opening the ring is replayed oldest first, so the
+ * AFE still sees the onset of the word that opened it.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "signal_stats.h"
+
+#define ENERGY_GATE_MAX_PREROLL 32 // chunks; 1 s at 32 ms chunks
+
+typedef struct
+{
+    uint32_t chunk_ms;
+    size_t chunk_samples;    // interleaved samples per fed chunk
+    uint32_t preroll_chunks; // at most ENERGY_GATE_MAX_PREROLL
+    uint32_t hold_ms;
+    uint32_t open_db_x10; // above the floor, in 0.1 dB
+    uint32_t min_rms;     // never opens on a chunk quieter than this
+} energy_gate_config_t;
+
+typedef struct
+{
+    uint32_t chunks;   // chunks seen
+    uint32_t fed;      // fed as they arrived
+    uint32_t replayed; // fed late from the pre-roll ring
+    uint32_t dropped;  // fell out of the pre-roll ring unfed
+    uint32_t opens;
+    int16_t floor_dbfs_x10;
+    bool open;
+} energy_gate_stats_t;
+
+typedef struct
+{
+    energy_gate_config_t cfg;
+    int16_t *preroll; // preroll_chunks * chunk_samples, from the arena
+    int64_t preroll_at[ENERGY_GATE_MAX_PREROLL];
+    uint32_t head; // oldest stashed chunk
+    uint32_t stashed;
+    uint64_t floor_ms; // mean-square noise floor, Q8
+    uint32_t open_q8;  // open threshold as a multiple of the floor, Q8
+    uint32_t hold_chunks;
+    uint32_t hold_left;
+    bool open;
+    bool primed; // floor seeded from the first chunk
+    std::atomic<bool> enabled;
+    std::atomic<bool> keep_open;
+    std::atomic<uint32_t> floor_pub; // floor_ms >> 8, for energy_gate_get_stats()
+    std::atomic<bool> open_pub;
+    std::atomic<uint32_t> chunks, fed, replayed, dropped, opens;
+} energy_gate_t;
+
+/* preroll: cfg->preroll_chunks * cfg->chunk_samples samples. Starts enabled and closed. */
+void energy_gate_init(energy_gate_t *g, const energy_gate_config_t *cfg, int16_t *preroll);
+
+/* Owner (feed) task, once per chunk with its stats. True: feed this chunk,
+ * after draining energy_gate_replay(). False: energy_gate_stash() it instead. */
+bool energy_gate_add(energy_gate_t *g, const signal_stats_t *chunk);
+void energy_gate_stash(energy_gate_t *g, const int16_t *data, int64_t captured_at);
+/* next pre-roll chunk to feed, oldest first; false once the ring is empty */
+bool energy_gate_replay(energy_gate_t *g, const int16_t **data, int64_t *captured_at);
+
+/* Any task. Disabled, every chunk is fed and the floor is still tracked. */
+void energy_gate_enable(energy_gate_t *g, bool on);
+bool energy_gate_enabled(const energy_gate_t *g);
+/* Any task: keep feeding regardless of energy, e.g. while MultiNet listens. */
+void energy_gate_keep_open(energy_gate_t *g, bool on);
+
+/* Any task; counters may be torn by a chunk. */
+void energy_gate_get_stats(const energy_gate_t *g, energy_gate_stats_t *out);
@@ -0,0 +1,231 @@
+/* event_log.cpp - bounded lock-free MPSC ring of event records and the task that prints them */
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "event_log.h"
+
+#define TAG "WAKE_DBG"
+#define EVENT_LOG_RECORDS CONFIG_WAKE_EVENT_LOG_RECORDS
+#define EVENT_LOG_DRAIN_MS 50
+
+static_assert(sizeof(event_rec_t) == 48, "event_rec_t is the dump format");
+static_assert((EVENT_LOG_RECORDS & (EVENT_LOG_RECORDS - 1)) == 0, "CONFIG_WAKE_EVENT_LOG_RECORDS must be a power of two");
+
+/* A slot is published for write position `pos` once turn == pos + 1, so a
+ * zeroed ring starts empty and a stale slot never looks ready a lap later. */
+typedef struct
+{
+    std::atomic<uint32_t> turn;
+    event_rec_t rec;
+} event_slot_t;
+
+static event_slot_t slots[EVENT_LOG_RECORDS];
+static std::atomic<uint32_t> head(0);
+static std::atomic<uint32_t> tail(0);
+static std::atomic<uint32_t> dropped(0);
+static std::atomic<uint32_t> high_water(0);
+
+static const char *const event_fmt[EV_COUNT] = {
+#define EVENT_LOG_FMT(id, level, fmt) fmt,
+    EVENT_LOG_EVENTS(EVENT_LOG_FMT)
+#undef EVENT_LOG_FMT
+};
+static const char event_level[EV_COUNT] = {
+#define EVENT_LOG_LEVEL(id, level, fmt) level,
+    EVENT_LOG_EVENTS(EVENT_LOG_LEVEL)
+#undef EVENT_LOG_LEVEL
+};
+static void (*event_action[EV_COUNT])(const event_rec_t *rec);
+
+static TaskHandle_t drain_task = NULL;
+static volatile bool running = false;
+
+bool event_log_write(event_id_t id, const event_arg_t *args, int nargs)
+{
+    uint32_t pos = head.load(std::memory_order_relaxed);
+    do
+    {
+        if (pos - tail.load(std::memory_order_acquire) >= EVENT_LOG_RECORDS)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed));
+
+    event_slot_t *s = &slots[pos & (EVENT_LOG_RECORDS - 1)];
+    s->rec.at = esp_timer_get_time();
+    s->rec.seq = pos;
+    s->rec.id = (uint16_t)id;
+    s->rec.nargs = (uint16_t)(nargs < EVENT_LOG_ARGS ? nargs : EVENT_LOG_ARGS);
+    memcpy(s->rec.args, args, s->rec.nargs * sizeof(event_arg_t));
+    s->turn.store(pos + 1, std::memory_order_release);
+
+    uint32_t queued = pos + 1 - tail.load(std::memory_order_relaxed);
+    if (queued > high_water.load(std::memory_order_relaxed))
+        high_water.store(queued, std::memory_order_relaxed); // racy max, good enough for a gauge
+    return true;
+}
+
+void event_log_set_action(event_id_t id, void (*fn)(const event_rec_t *rec))
+{
+    event_action[id] = fn;
+}
+
+size_t event_log_format(const event_rec_t *rec, char *out, size_t len)
+{
+    size_t n = (size_t)snprintf(out, len, "@%lld.%06lld ", (long long)(rec->at / 1000000), (long long)(rec->at % 1000000));
+    if (rec->id >= EV_COUNT)
+    {
+        if (n < len)
+            n += snprintf(out + n, len - n, "unknown event %u", (unsigned)rec->id);
+        return n < len ? n : len - 1;
+    }
+
+    int arg = 0;
+    for (const char *f = event_fmt[rec->id]; *f && n + 1 < len; ++f)
+    {
+        if (*f != '%')
+        {
+            out[n++] = *f;
+            continue;
+        }
+        if (f[1] == '%')
+        {
+            out[n++] = '%';
+            ++f;
+            continue;
+        }
+        // copy one conversion spec, e.g. "%.1f", and print the next argument with it
+        char spec[16];
+        size_t k = 0;
+        while (f[k] && k < sizeof(spec) - 1 && !strchr("diuxXfeg", f[k]))
+        {
+            spec[k] = f[k];
+            ++k;
+        }
+        char conv = f[k];
+        spec[k] = conv;
+        spec[k + 1] = 0;
+        f += k;
+        if (arg >= rec->nargs)
+            n += snprintf(out + n, len - n, "?");
+        else if (conv == 'f' || conv == 'e' || conv == 'g')
+            n += snprintf(out + n, len - n, spec, (double)rec->args[arg].f);
+        else
+            n += snprintf(out + n, len - n, spec, rec->args[arg].i);
+        ++arg;
+    }
+    if (n >= len)
+        n = len - 1;
+    out[n] = 0;
+    return n;
+}
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool event_log_parse_hex(const char *hex, event_rec_t *rec)
+{
+    uint8_t *b = (uint8_t *)rec;
+    for (size_t i = 0; i < sizeof(*rec); ++i)
+    {
+        int hi = hex_digit(hex[2 * i]);
+        int lo = hi < 0 ? -1 : hex_digit(hex[2 * i + 1]);
+        if (lo < 0)
+            return false;
+        b[i] = (uint8_t)(hi << 4 | lo);
+    }
+    return true;
+}
+
+static void print_record(const event_rec_t *rec)
+{
+#if CONFIG_WAKE_EVENT_LOG_BINARY
+    char hex[2 * sizeof(event_rec_t) + 1];
+    const uint8_t *b = (const uint8_t *)rec;
+    for (size_t i = 0; i < sizeof(*rec); ++i)
+        snprintf(hex + 2 * i, 3, "%02x", b[i]);
+    printf("EVB %s\n", hex);
+#else
+    char line[192];
+    event_log_format(rec, line, sizeof(line));
+    if (rec->id < EV_COUNT && event_level[rec->id] == 'W')
+        ESP_LOGW(TAG, "%s", line);
+    else
+        ESP_LOGI(TAG, "%s", line);
+#endif
+}
+
+static void drain(void)
+{
+    static uint32_t reported_drops = 0;
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        event_slot_t *s = &slots[t & (EVENT_LOG_RECORDS - 1)];
+        if (s->turn.load(std::memory_order_acquire) != t + 1)
+        {
+            // the ring is empty, so the drop count has room as a record of its own, in the stream a dump decodes
+            uint32_t d = dropped.load(std::memory_order_relaxed);
+            event_arg_t n = ev_i((int32_t)(d - reported_drops));
+            if (d == reported_drops || !event_log_write(EV_LOG_DROPPED, &n, 1))
+                break;
+            reported_drops = d;
+            continue;
+        }
+        event_rec_t rec = s->rec;
+        tail.store(++t, std::memory_order_release);
+
+        print_record(&rec);
+        if (rec.id < EV_COUNT && event_action[rec.id])
+            event_action[rec.id](&rec);
+    }
+}
+
+/* drain task: the only place event records become UART output */
+static void drain_Task(void *arg)
+{
+    while (running)
+    {
+        drain();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(EVENT_LOG_DRAIN_MS));
+    }
+    drain();
+    vTaskDelete(NULL);
+}
+
+void event_log_start(void)
+{
+    if (running)
+        return;
+    running = true;
+    xTaskCreatePinnedToCore(drain_Task, "evlog", 3072, NULL, 1, &drain_task, 0);
+}
+
+void event_log_stop(void)
+{
+    running = false;
+    if (drain_task)
+        xTaskNotifyGive(drain_task);
+}
+
+void event_log_get_stats(event_log_stats_t *out)
+{
+    out->written = head.load(std::memory_order_relaxed); // drops never reserve a position
+    out->dropped = dropped.load(std::memory_order_relaxed);
+    out->high_water = high_water.load(std::memory_order_relaxed);
+    out->capacity = EVENT_LOG_RECORDS;
+}
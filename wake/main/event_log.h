@@ -0,0 +1,118 @@
+/* event_log.h - deferred binary event log: fixed-size records from the hot path, formatted by a low-priority task */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_log.h"
+
+/* X(id, level, format): level is 'I' or 'W' and is checked against
+ * LOG_LOCAL_LEVEL at compile time, so the log profile removes the EVENT_LOG()
+ * calls it would not print; the format takes only %d/%u/%x
+ * (int args) and %f/%e/%g (float args), in record argument order. Append new
+ * events at the end so old dumps still decode. */
+#define EVENT_LOG_EVENTS(X)                                                                                  \
+    X(EV_WAKE, 'I', "*** WAKE WORD DETECTED *** model index: %d, word index: %d, verified channel: %d")      \
+    X(EV_GPIO_HIGH, 'I', "GPIO %d set HIGH to trigger Raspberry Pi")                                         \
+    X(EV_MN_RESULT, 'I', "TOP %d, command_id: %d, phrase_id: %d, prob: %f")                                  \
+    X(EV_LED_ON, 'I', "LED %d ON -> command_id %d")                                                          \
+    X(EV_LISTENING, 'I', "-----------listening-----------")                                                  \
+    X(EV_TIMEOUT, 'I', "timeout")                                                                            \
+    X(EV_GPIO_LOW, 'I', "GPIO %d set LOW after timeout")                                                     \
+    X(EV_AWAIT, 'I', "-----------awaits to be waken up-----------")                                          \
+    X(EV_AUDIO_STATS, 'I', "audio: rms=%.1f dBFS peak=%d dc=%.1f silent=%d%% clipped=%u overruns=%u underruns=%u chunks=%u") \
+    X(EV_AUDIO_SILENT, 'W', "Every chunk below RMS %u - microphone may be silent or too quiet")              \
+    X(EV_LATENCY_REPORT, 'I', "latency report")                                                             \
+    X(EV_ACT_DROPPED, 'W', "actuation queue full: %d events dropped")                                       \
+    X(EV_SILENCE_CALIBRATED, 'I', "silence tracker: ambient %.1f dBFS, silent at or below %.1f dBFS")     \
+    X(EV_MN_SWAPPED, 'I', "MultiNet switched to the updated command table")                                \
+    X(EV_LOG_DROPPED, 'W', "event log full: %u records dropped")
+
+typedef enum
+{
+#define EVENT_LOG_ENUM(id, level, fmt) id,
+    EVENT_LOG_EVENTS(EVENT_LOG_ENUM)
+#undef EVENT_LOG_ENUM
+        EV_COUNT,
+} event_id_t;
+
+#define EVENT_LOG_ARGS 8
+
+typedef union
+{
+    int32_t i;
+    float f;
+} event_arg_t;
+
+/* 48 bytes, little-endian; also the unit of a binary dump */
+typedef struct
+{
+    int64_t at;   // esp_timer_get_time() when written
+    uint32_t seq; // write order, without gaps: ring drops come as an EV_LOG_DROPPED record, a gap is transfer loss
+    uint16_t id;  // event_id_t
+    uint16_t nargs;
+    event_arg_t args[EVENT_LOG_ARGS];
+} event_rec_t;
+
+static inline event_arg_t ev_i(int32_t v)
+{
+    event_arg_t a;
+    a.i = v;
+    return a;
+}
+
+static inline event_arg_t ev_f(float v)
+{
+    event_arg_t a;
+    a.f = v;
+    return a;
+}
+
+/* Lock-free and non-blocking from any task: reserves a slot, fills it,
+ * publishes it. Returns false (and counts a drop) when the ring is full;
+ * the drain task logs the count as EV_LOG_DROPPED once there is room. */
+bool event_log_write(event_id_t id, const event_arg_t *args, int nargs);
+
+enum
+{
+#define EVENT_LOG_MIN_LEVEL(id, level, fmt) EVENT_LOG_LEVEL_##id = (level) == 'W' ? (int)ESP_LOG_WARN : (int)ESP_LOG_INFO,
+    EVENT_LOG_EVENTS(EVENT_LOG_MIN_LEVEL)
+#undef EVENT_LOG_MIN_LEVEL
+};
+
+/* EVENT_LOG(EV_LED_ON, ev_i(led), ev_i(cmd)); up to EVENT_LOG_ARGS args.
+ * `id` must be an EV_* name, not an expression. */
+#define EVENT_LOG(id, ...)                                                                 \
+    do                                                                                     \
+    {                                                                                      \
+        if ((int)(LOG_LOCAL_LEVEL) >= EVENT_LOG_LEVEL_##id)                                \
+        {                                                                                  \
+            const event_arg_t ev_args_[] = {ev_i(0), ##__VA_ARGS__};                       \
+            event_log_write(id, ev_args_ + 1, sizeof(ev_args_) / sizeof(ev_args_[0]) - 1); \
+        }                                                                                  \
+    } while (0)
+
+/* Runs on the drain task after the record is printed, e.g. a report that is
+ * too slow for the task that asked for it. */
+void event_log_set_action(event_id_t id, void (*fn)(const event_rec_t *rec));
+
+/* Starts the drain task (priority 1). Text mode prints each record as a log
+ * line; binary mode (CONFIG_WAKE_EVENT_LOG_BINARY) prints "EVB <hex>" lines
+ * for the host decoder (wake/host/event_decode). */
+void event_log_start(void);
+/* drains what is left and ends the drain task */
+void event_log_stop(void);
+
+/* "@<seconds> <text>" for one record; shared with the host decoder */
+size_t event_log_format(const event_rec_t *rec, char *out, size_t len);
+/* parses the hex payload of an "EVB " line; false if malformed */
+bool event_log_parse_hex(const char *hex, event_rec_t *rec);
+
+typedef struct
+{
+    uint32_t written;
+    uint32_t dropped;
+    uint32_t high_water; // most records ever waiting for the drain task
+    uint32_t capacity;
+} event_log_stats_t;
+
+void event_log_get_stats(event_log_stats_t *out);
@@ -0,0 +1,59 @@
+/* latency_hist.cpp - fixed-bucket latency histogram, single writer, printable as one line */
+#include <stdio.h>
+#include <string.h>
+#include "latency_hist.h"
+
+const uint32_t latency_hist_bounds_us[LATENCY_HIST_BUCKETS - 1] = {
+    50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000};
+
+void latency_hist_init(latency_hist_t *h, const char *name)
+{
+    memset(h, 0, sizeof(*h));
+    h->name = name;
+}
+
+void latency_hist_add(latency_hist_t *h, uint32_t us)
+{
+    int b = 0;
+    while (b < LATENCY_HIST_BUCKETS - 1 && us > latency_hist_bounds_us[b])
+        b++;
+    h->counts[b]++;
+    h->n++;
+    h->sum_us += us;
+    if (us > h->max_us)
+        h->max_us = us;
+}
+
+uint32_t latency_hist_percentile(const latency_hist_t *h, uint32_t p)
+{
+    if (h->n == 0)
+        return 0;
+    uint64_t want = ((uint64_t)h->n * p + 99) / 100;
+    uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_HIST_BUCKETS - 1; ++b)
+    {
+        seen += h->counts[b];
+        if (seen >= want)
+            return latency_hist_bounds_us[b] < h->max_us ? latency_hist_bounds_us[b] : h->max_us;
+    }
+    return h->max_us;
+}
+
+void latency_hist_print(const latency_hist_t *h)
+{
+    char line[384];
+    int len = snprintf(line, sizeof(line), "latency %s: n=%u mean=%uus p50<=%uus p90<=%uus p99<=%uus max=%uus |",
+                       h->name, (unsigned)h->n, h->n ? (unsigned)(h->sum_us / h->n) : 0u,
+                       (unsigned)latency_hist_percentile(h, 50), (unsigned)latency_hist_percentile(h, 90),
+                       (unsigned)latency_hist_percentile(h, 99), (unsigned)h->max_us);
+    for (int b = 0; b < LATENCY_HIST_BUCKETS && len < (int)sizeof(line); ++b)
+    {
+        if (!h->counts[b])
+            continue;
+        if (b < LATENCY_HIST_BUCKETS - 1)
+            len += snprintf(line + len, sizeof(line) - len, " <=%u:%u", (unsigned)latency_hist_bounds_us[b], (unsigned)h->counts[b]);
+        else
+            len += snprintf(line + len, sizeof(line) - len, " >%u:%u", (unsigned)latency_hist_bounds_us[b - 1], (unsigned)h->counts[b]);
+    }
+    printf("%s\n", line);
+}
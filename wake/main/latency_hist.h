@@ -0,0 +1,26 @@
+/* latency_hist.h - fixed-bucket latency histogram, single writer, printable as one line */
+#pragma once
+
+#include <stdint.h>
+
+#define LATENCY_HIST_BUCKETS 14
+
+/* upper bounds in microseconds; the last bucket is open-ended */
+extern const uint32_t latency_hist_bounds_us[LATENCY_HIST_BUCKETS - 1];
+
+typedef struct
+{
+    const char *name;
+    uint32_t counts[LATENCY_HIST_BUCKETS];
+    uint32_t n;
+    uint32_t max_us;
+    uint64_t sum_us;
+} latency_hist_t;
+
+void latency_hist_init(latency_hist_t *h, const char *name);
+/* O(buckets) compare loop, no division; call from the owning task only */
+void latency_hist_add(latency_hist_t *h, uint32_t us);
+/* bucket upper bound that covers the p-th percentile (0..100) */
+uint32_t latency_hist_percentile(const latency_hist_t *h, uint32_t p);
+/* one line: name n= mean= p50<= p90<= p99<= max= then the non-empty buckets */
+void latency_hist_print(const latency_hist_t *h);
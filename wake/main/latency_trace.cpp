@@ -0,0 +1,84 @@
+/* latency_trace.cpp - per-chunk esp_timer stamps from I2S capture to TRIGGER_GPIO, one histogram per stage */
+#include <atomic>
+#include "esp_timer.h"
+#include "latency_trace.h"
+
+#define TRACE_STAMPS 64 // chunks in flight between feed and fetch, far above the AFE ring depth
+
+static const char *const stage_names[TRACE_STAGES] = {
+    "capture->feed", "feed->fetch", "fetch->decision", "decision->gpio", "capture->gpio"};
+
+static latency_hist_t hist[TRACE_STAGES];
+static trace_stamp_t stamps[TRACE_STAMPS];
+static std::atomic<uint32_t> fed_seq(0);
+static uint32_t fetched_seq = 0;
+static std::atomic<uint32_t> reset_pending(0); // bit per stage, cleared by that stage's writer
+
+static void take_reset(uint32_t mask)
+{
+    uint32_t bits = reset_pending.fetch_and(~mask, std::memory_order_relaxed) & mask;
+    for (int i = 0; i < TRACE_STAGES; ++i)
+    {
+        if (bits & (1u << i))
+            latency_hist_init(&hist[i], stage_names[i]);
+    }
+}
+
+static void add(trace_stage_t stage, int64_t us)
+{
+    latency_hist_add(&hist[stage], us < 0 ? 0 : (uint32_t)us);
+}
+
+void latency_trace_init(void)
+{
+    for (int i = 0; i < TRACE_STAGES; ++i)
+        latency_hist_init(&hist[i], stage_names[i]);
+}
+
+void latency_trace_fed(int64_t captured_at)
+{
+    take_reset(1u << TRACE_CAPTURE_FEED);
+    int64_t now = esp_timer_get_time();
+    if (captured_at)
+        add(TRACE_CAPTURE_FEED, now - captured_at);
+    uint32_t seq = fed_seq.load(std::memory_order_relaxed);
+    trace_stamp_t *s = &stamps[seq % TRACE_STAMPS];
+    s->captured_at = captured_at;
+    s->fed_at = now;
+    fed_seq.store(seq + 1, std::memory_order_release);
+}
+
+bool latency_trace_fetched(trace_stamp_t *out)
+{
+    take_reset(((1u << TRACE_STAGES) - 1) & ~(1u << TRACE_CAPTURE_FEED));
+
+    int64_t now = esp_timer_get_time();
+    if (fetched_seq == fed_seq.load(std::memory_order_acquire))
+    {
+        out->captured_at = out->fed_at = 0;
+        out->fetched_at = now;
+        return false;
+    }
+    *out = stamps[fetched_seq % TRACE_STAMPS];
+    out->fetched_at = now;
+    fetched_seq++;
+    add(TRACE_FEED_FETCH, now - out->fed_at);
+    return true;
+}
+
+void latency_trace_since(trace_stage_t stage, int64_t since)
+{
+    if (since)
+        add(stage, esp_timer_get_time() - since);
+}
+
+void latency_trace_print(void)
+{
+    for (int i = 0; i < TRACE_STAGES; ++i)
+        latency_hist_print(&hist[i]);
+}
+
+void latency_trace_reset(void)
+{
+    reset_pending.store((1u << TRACE_STAGES) - 1, std::memory_order_relaxed);
+}
@@ -0,0 +1,38 @@
+/* latency_trace.h - per-chunk esp_timer stamps from I2S capture to TRIGGER_GPIO, one histogram per stage */
+#pragma once
+
+#include <stdint.h>
+#include "latency_hist.h"
+
+typedef enum
+{
+    TRACE_CAPTURE_FEED,   // last sample of the chunk in DMA -> afe->feed()   (feed task)
+    TRACE_FEED_FETCH,     // afe->feed() -> fetch returned the chunk          (detect task)
+    TRACE_FETCH_DECISION, // fetch -> WakeNet/MultiNet decision made          (detect task)
+    TRACE_DECISION_GPIO,  // wake decision -> gpio_set_level() returned       (actuation task)
+    TRACE_CAPTURE_GPIO,   // end to end for wake chunks                       (actuation task)
+    TRACE_STAGES,
+} trace_stage_t;
+
+typedef struct
+{
+    int64_t captured_at; // esp_timer time the chunk's last sample left DMA, 0 if unknown
+    int64_t fed_at;
+    int64_t fetched_at;
+} trace_stamp_t;
+
+void latency_trace_init(void);
+
+/* Feed task, right before afe->feed(). Records capture->feed and queues the
+ * chunk's stamp; the AFE is FIFO so the n-th fetch pops the n-th stamp. */
+void latency_trace_fed(int64_t captured_at);
+
+/* Detect task, right after a fetch returned a chunk. Records feed->fetch. */
+bool latency_trace_fetched(trace_stamp_t *out);
+
+/* Detect or actuation task: stage time from `since` to now. */
+void latency_trace_since(trace_stage_t stage, int64_t since);
+
+/* One line per stage, see latency_hist_print(). Safe from any task; counts may be torn by a chunk. */
+void latency_trace_print(void);
+void latency_trace_reset(void);
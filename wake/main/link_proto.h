@@ -0,0 +1,116 @@
+/* link_proto.h - framed ESP32 -> Raspberry Pi event protocol, shared by the firmware and the pi/ decoder
+ *
+ * Frame:   0xA5 0x5A | type | seq | len | payload[len] | crc16 lo | crc16 hi
+ * CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over type..payload. seq
+ * counts frames mod 256, so the reader can count lost ones; a frame the
+ * firmware dropped on a full queue skips its seq too. Payloads are
+ * packed little-endian structs; both ends are little-endian. New fields go at
+ * the end of a payload and readers accept a longer len than they know.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define LINK_SOF0 0xA5
+#define LINK_SOF1 0x5A
+#define LINK_VERSION 1
+#define LINK_HEADER_BYTES 5
+#define LINK_CRC_BYTES 2
+#define LINK_MAX_PAYLOAD 32
+#define LINK_FRAME_MAX (LINK_HEADER_BYTES + LINK_MAX_PAYLOAD + LINK_CRC_BYTES)
+
+typedef enum
+{
+    LINK_HELLO = 1,   // link_hello_t: at start and as a 1 s heartbeat while idle
+    LINK_WAKE,        // link_wake_t: TRIGGER_GPIO went high
+    LINK_COMMAND,     // link_command_t: one per MultiNet result
+    LINK_TIMEOUT,     // link_timeout_t: command window over, TRIGGER_GPIO low
+    LINK_AUDIO_STATS, // link_audio_stats_t: one per audio stats window
+    LINK_SILENCE,     // link_silence_t: silence tracker state, then each further second of silence
+} link_type_t;
+
+#pragma pack(push, 1)
+typedef struct
+{
+    uint32_t t_ms; // esp_timer milliseconds, every payload starts with it
+    uint8_t version;
+    uint32_t phrase_table; // PHRASE_TABLE_HASH the firmware was built with
+} link_hello_t;
+
+typedef struct
+{
+    uint32_t t_ms;
+    int8_t model_index;
+    int8_t word_index;
+    int8_t channel; // verified channel, -1 if not verified
+} link_wake_t;
+
+typedef struct
+{
+    uint32_t t_ms;
+    uint8_t rank;     // 1 = top result
+    uint8_t accepted; // above the firmware's command threshold (its LED is lit)
+    int16_t command_id;
+    int16_t phrase_id;
+    uint16_t prob_q16; // probability * 65535
+    uint8_t severity;  // from the firmware's phrase table; index into phrase_severity_names
+    uint8_t category;  // likewise phrase_category_names; both 0 for ids outside the manifest
+} link_command_t;
+
+typedef struct
+{
+    uint32_t t_ms;
+} link_timeout_t;
+
+typedef struct
+{
+    uint32_t t_ms;
+    int16_t rms_dbfs_x10;
+    int16_t peak;
+    int16_t dc;
+    uint8_t silent_pct;
+    uint8_t reserved;
+    uint16_t clipped;
+    uint16_t overruns;
+    uint16_t underruns;
+    uint16_t chunks;
+} link_audio_stats_t;
+typedef struct
+{
+    uint32_t t_ms;
+    uint16_t silent_s; // continuous silence, counted once tracking (0 while calibrating or in grace)
+    int16_t floor_dbfs_x10;
+    int16_t threshold_dbfs_x10;
+    uint8_t state; // 1 calibrating, 2 grace, 3 tracking
+} link_silence_t;
+#pragma pack(pop)
+
+static inline uint16_t link_crc16(uint16_t crc, const uint8_t *p, size_t n)
+{
+    while (n--)
+    {
+        crc ^= (uint16_t)(*p++ << 8);
+        for (int b = 0; b < 8; ++b)
+            crc = (uint16_t)(crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1);
+    }
+    return crc;
+}
+
+/* Writes one frame to out (at least LINK_FRAME_MAX bytes); returns its length, 0 if len is too big. */
+static inline size_t link_encode(uint8_t *out, uint8_t type, uint8_t seq, const void *payload, size_t len)
+{
+    if (len > LINK_MAX_PAYLOAD)
+        return 0;
+    out[0] = LINK_SOF0;
+    out[1] = LINK_SOF1;
+    out[2] = type;
+    out[3] = seq;
+    out[4] = (uint8_t)len;
+    memcpy(out + LINK_HEADER_BYTES, payload, len);
+    uint16_t crc = link_crc16(0xFFFF, out + 2, 3 + len);
+    out[LINK_HEADER_BYTES + len] = (uint8_t)(crc & 0xFF);
+    out[LINK_HEADER_BYTES + len + 1] = (uint8_t)(crc >> 8);
+    return LINK_HEADER_BYTES + len + LINK_CRC_BYTES;
+}
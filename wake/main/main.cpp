@@ -2,9 +2,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "driver/i2s_std.h"
 #include "esp_log.h"
 #include "esp_afe_sr_iface.h"
@@ -19,6 +19,16 @@
 #include "esp_process_sdkconfig.h"
 #include "driver/ledc.h"
 #include "driver/gpio.h"
+#include "sdkconfig.h"
+#include "afe_bench.h"
+#include "arena.h"
+#include "capture.h"
+#include "signal_stats.h"
+#include "pipeline.h"
+#include "model_registry.h"
+#include "boot_profile.h"
+#include "wake_console.h"
+#include "wake_log.h"
 
 #define TAG "WAKE_DBG"
 #define s3
@@ -27,27 +37,24 @@
 #define I2S_WS_IO (gpio_num_t)5
 #define I2S_SD_IO (gpio_num_t)6
 #endif
-#define TRIGGER_GPIO (gpio_num_t)7
-int wakeup_flag = 0;
+#define I2S_DMA_DESC_NUM 8
+#define I2S_DMA_FRAME_NUM 256
 static i2s_chan_handle_t rx_handle;
-static esp_afe_sr_iface_t *afe_handle = NULL;
-static volatile int task_flag = 0;
-srmodel_list_t *models = NULL;
 const int ledPins[] = {38, 39, 40};
 const int chns[] = {0, 1, 2};
-/* init I2S (same as your code, but keep DMA smaller while debugging if you want) */
-void i2s_init()
+/* init I2S (same as your code, but keep DMA smaller while debugging if you want); capture_start() enables it */
+void i2s_init(int dma_frame_num)
 {
     i2s_chan_config_t chan_cfg = {
         .id = I2S_NUM_0,
         .role = I2S_ROLE_MASTER,
-        .dma_desc_num = 8,
-        .dma_frame_num = 256,
+        .dma_desc_num = I2S_DMA_DESC_NUM,
+        .dma_frame_num = (uint32_t)dma_frame_num,
     };
     ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, NULL, &rx_handle));
 
     i2s_std_config_t std_cfg = {
-        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(16000),
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SAMPLE_RATE),
         .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
         .gpio_cfg = {
             .bclk = I2S_BCK_IO,
@@ -58,258 +65,93 @@ void i2s_init()
     std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_LEFT;
 
     ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx_handle, &std_cfg));
-    ESP_ERROR_CHECK(i2s_channel_enable(rx_handle));
 }
 
-/* helper: compute RMS of a PCM buffer */
-static float compute_rms(const int16_t *buf, size_t samples)
+/* LEDs on LEDC and TRIGGER_GPIO as a low output */
+static void periph_init(void)
 {
-    if (!buf || samples == 0)
-        return 0.0f;
-    uint64_t acc = 0;
-    for (size_t i = 0; i < samples; ++i)
-    {
-        int32_t v = buf[i];
-        acc += (uint64_t)(v * (int64_t)v);
-    }
-    double mean = ((double)acc) / (double)samples;
-    return (float)sqrt(mean);
-}
-
-/* feed task: read from i2s, compute RMS + optionally print first samples, feed to AFE */
-void feed_Task(void *arg)
-{
-    esp_afe_sr_data_t *afe_data = (esp_afe_sr_data_t *)arg;
-    if (!afe_handle || !afe_data)
-    {
-        ESP_LOGE(TAG, "afe_handle or afe_data NULL in feed_Task!");
-        vTaskDelete(NULL);
-        return;
-    }
-
-    int chunk = afe_handle->get_feed_chunksize(afe_data);
-    int ch = afe_handle->get_feed_channel_num(afe_data);
-    ESP_LOGI(TAG, "Feed task chunk=%d channels=%d", chunk, ch);
-
-    size_t samples = (size_t)chunk * (size_t)ch;
-    int16_t *buffer = (int16_t *)heap_caps_malloc(samples * sizeof(int16_t), MALLOC_CAP_DEFAULT | MALLOC_CAP_SPIRAM);
-    if (!buffer)
-    {
-        ESP_LOGW(TAG, "PSRAM allocation failed for audio buffer, falling back to heap_malloc");
-        buffer = (int16_t *)malloc(samples * sizeof(int16_t));
-    }
-    if (!buffer)
-    {
-        ESP_LOGE(TAG, "Failed to allocate audio buffer");
-        vTaskDelete(NULL);
-        return;
-    }
-
-    ESP_LOGI(TAG, "Feed task started");
+    // ESP32-S3: USE HIGH-SPEED MODE ONLY
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .duty_resolution = LEDC_TIMER_8_BIT,
+        .timer_num = LEDC_TIMER_0,
+        .freq_hz = 1000,
+        .clk_cfg = LEDC_AUTO_CLK};
+    ledc_timer_config(&ledc_timer);
 
-    while (task_flag)
+    for (int i = 0; i < 3; i++)
     {
-        size_t bytes_read = 0;
-        esp_err_t ret = i2s_channel_read(rx_handle, buffer, samples * sizeof(int16_t), &bytes_read, portMAX_DELAY);
-        if (ret != ESP_OK)
-        {
-            ESP_LOGE(TAG, "i2s read error: %d", ret);
-            vTaskDelay(pdMS_TO_TICKS(100));
-            continue;
-        }
-        if (bytes_read == 0)
-        {
-            ESP_LOGW(TAG, "i2s read returned 0 bytes");
-            vTaskDelay(pdMS_TO_TICKS(10));
-            continue;
-        }
-
-        size_t got_samples = bytes_read / sizeof(int16_t);
-        float rms = compute_rms(buffer, got_samples);
-        ESP_LOGD(TAG, "I2S read %d bytes (%d samples), RMS=%.2f", (int)bytes_read, (int)got_samples, rms);
-
-        static int print_count = 0;
-        if ((print_count++ % 50) == 0)
-        {
-            ESP_LOGI(TAG, "I2S read %d bytes (%d samples), RMS=%.2f", (int)bytes_read, (int)got_samples, rms);
-
-            ESP_LOGI(TAG, "samples[0..7]: %d,%d,%d,%d,%d,%d,%d,%d",
-                     buffer[0], buffer[1], buffer[2], buffer[3], buffer[4], buffer[5], buffer[6], buffer[7]);
-        }
-
-        if (rms < 2.0f)
-        {
-            ESP_LOGW(TAG, "Low RMS (%.2f) - microphone may be silent or too quiet", rms);
-        }
-
-        afe_handle->feed(afe_data, buffer);
-        // FETCH REMOVED — ONLY FEED HERE
+        ledc_channel_config_t ledc_ch = {
+            .gpio_num = ledPins[i],
+            .speed_mode = LEDC_LOW_SPEED_MODE,
+            .channel = (ledc_channel_t)i,
+            .intr_type = LEDC_INTR_DISABLE,
+            .timer_sel = LEDC_TIMER_0,
+            .duty = 255, // OFF
+            .hpoint = 0,
+            .flags = {.output_invert = 0}};
+        ledc_channel_config(&ledc_ch);
     }
+    // the actuation task drives the LEDs with hardware fades
+    ledc_fade_func_install(0);
 
-    heap_caps_free(buffer);
-    vTaskDelete(NULL);
+    // Configure TRIGGER_GPIO as output
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << TRIGGER_GPIO),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE};
+    gpio_config(&io_conf);
+    gpio_set_level(TRIGGER_GPIO, 0); // Start low
 }
 
-/* detect task: call afe fetch and react to wake events */
-void detect_Task(void *arg)
-{
-    esp_afe_sr_data_t *afe_data = (esp_afe_sr_data_t *)arg;
-    int afe_chunksize = afe_handle->get_fetch_chunksize(afe_data);
-
-    models = esp_srmodel_init("model");
-    char *mn_name = esp_srmodel_filter(models, ESP_MN_PREFIX, ESP_MN_ENGLISH);
-    printf("multinet:%s\n", mn_name);
-    esp_mn_iface_t *multinet = esp_mn_handle_from_name(mn_name);
-    model_iface_data_t *model_data = multinet->create(mn_name, 6000);
-    int mu_chunksize = multinet->get_samp_chunksize(model_data);
-    esp_mn_commands_update_from_sdkconfig(multinet, model_data);
-    assert(mu_chunksize == afe_chunksize);
-    multinet->print_active_speech_commands(model_data);
-
-    if (!afe_handle || !afe_data)
-    {
-        ESP_LOGE(TAG, "afe_handle or afe_data NULL in detect_Task!");
-        vTaskDelete(NULL);
-        return;
-    }
-
-    int chunk = afe_handle->get_fetch_chunksize(afe_data);
-    ESP_LOGI(TAG, "Detect task chunk=%d", chunk);
-
-    ESP_LOGI(TAG, "Listening for 20 greetings in parallel...");
-
-    while (task_flag)
-    {
-        afe_fetch_result_t *res = afe_handle->fetch(afe_data);
-        if (!res)
-        {
-            vTaskDelay(pdMS_TO_TICKS(5));
-            continue;
-        }
-        if (res->ret_value == ESP_FAIL)
-        {
-            ESP_LOGE(TAG, "AFE fetch failed");
-            break;
-        }
-
-        ESP_LOGD(TAG, "AFE fetch: vad=%d, wakeup_state=%d, model_idx=%d, word_idx=%d",
-                 res->vad_state, res->wakeup_state, res->wakenet_model_index, res->wake_word_index);
-
-        if (res->wakeup_state == WAKENET_DETECTED)
-        {
-            ESP_LOGI(TAG, "*** WAKE WORD DETECTED ***");
-            ESP_LOGI(TAG, "Model index: %d, Word index: %d", res->wakenet_model_index, res->wake_word_index);
-            // afe_handle->disable_wakenet(afe_data);  // DISABLE WAKE NET
-            wakeup_flag = 1;
-            // Trigger GPIO high to signal Raspberry Pi
-            gpio_set_level(TRIGGER_GPIO, 1);
-            ESP_LOGI(TAG, "GPIO %d set HIGH to trigger Raspberry Pi", TRIGGER_GPIO);
-        }
-
-        if (res->raw_data_channels == 1 && res->wakeup_state == WAKENET_DETECTED)
-        {
-            wakeup_flag = 1;
-            gpio_set_level(TRIGGER_GPIO, 1);
-        }
-        else if (res->raw_data_channels > 1 && res->wakeup_state == WAKENET_CHANNEL_VERIFIED)
-        {
-            printf("AFE_FETCH_CHANNEL_VERIFIED, channel index: %d\n", res->trigger_channel_id);
-            wakeup_flag = 1;
-            gpio_set_level(TRIGGER_GPIO, 1);
-        }
-
-        if (wakeup_flag == 1)
-        {
-            esp_mn_state_t mn_state = multinet->detect(model_data, res->data);
+#if CONFIG_WAKE_FAST_BOOT
+static SemaphoreHandle_t periph_done = NULL;
 
-            if (mn_state == ESP_MN_STATE_DETECTING)
-            {
-                continue;
-            }
-
-            if (mn_state == ESP_MN_STATE_DETECTED)
-            {
-                esp_mn_results_t *mn_result = multinet->get_results(model_data);
-                for (int i = 0; i < mn_result->num; i++)
-                {
-                    printf("TOP %d, command_id: %d, phrase_id: %d, string: %s, prob: %f\n",
-                           i + 1, mn_result->command_id[i], mn_result->phrase_id[i], mn_result->string, mn_result->prob[i]);
-
-                    // LED CONTROL: PROB > 0.5 → TURN ON CORRESPONDING LED
-                    if (mn_result->prob[i] > 0.5)
-                    {
-                        int led = mn_result->command_id[i] % 3;
-                        ledc_set_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)led, 255); // 0 = ON
-                        ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)led);
-                        ESP_LOGI(TAG, "LED %d ON → %s (%.2f)", led, mn_result->string, mn_result->prob[i]);
-                        printf("LED %d ON → %s (%.2f)", led, mn_result->string, mn_result->prob[i]);
-                    }
-                }
-                printf("-----------listening-----------\n");
-            }
-
-            if (mn_state == ESP_MN_STATE_TIMEOUT)
-            {
-                esp_mn_results_t *mn_result = multinet->get_results(model_data);
-                printf("timeout, string:%s\n", mn_result->string);
-                // afe_handle->enable_wakenet(afe_data);
-                // wakeup_flag = 0;
-                for (int i = 0; i < 3; i++)
-                {
-                    ledc_set_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)i, 0); // OFF
-                    ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)i);
-                }
-
-                // Reset GPIO to low after timeout
-                gpio_set_level(TRIGGER_GPIO, 0);
-                ESP_LOGI(TAG, "GPIO %d set LOW after timeout", TRIGGER_GPIO);
-
-                printf("\n-----------awaits to be waken up-----------\n");
-                continue;
-            }
-        }
-
-        // FREE DATA ONLY HERE
-        if (res->data)
-        {
-            // free(res->data);
-        }
-    }
-
-    multinet->destroy(model_data);
+/* fast boot: LEDC, GPIO and (in ring mode) I2S come up on the other core while app_main loads the models */
+static void periph_init_Task(void *arg)
+{
+    int phase = boot_phase_begin("periph");
+    periph_init();
+    boot_phase_end(phase);
+#if !CONFIG_WAKE_CAPTURE_ZERO_COPY
+    phase = boot_phase_begin("i2s");
+    i2s_init(I2S_DMA_FRAME_NUM);
+    boot_phase_end(phase);
+#endif
+    xSemaphoreGive(periph_done);
     vTaskDelete(NULL);
 }
+#endif
 
 extern "C" void app_main()
 {
-    esp_log_level_set("*", ESP_LOG_WARN);
-    esp_log_level_set("WAKENET", ESP_LOG_DEBUG);
-    esp_log_level_set("AFE", ESP_LOG_DEBUG);
-    esp_log_level_set("WAKE_DBG", ESP_LOG_DEBUG);
-    esp_log_level_set("WAKENET_DETECT", ESP_LOG_DEBUG);
+    wake_log_init();
 
+#if CONFIG_WAKE_FAST_BOOT
+    periph_done = xSemaphoreCreateBinary();
+    xTaskCreatePinnedToCore(periph_init_Task, "periph_init", 3072, NULL, 5, NULL, 1);
+#else
+    int phase = boot_phase_begin("diag");
     ESP_LOGI(TAG, "Free PSRAM: %u bytes", (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
     heap_caps_print_heap_info(MALLOC_CAP_DEFAULT);
     heap_caps_print_heap_info(MALLOC_CAP_SPIRAM);
+    boot_phase_end(phase);
+#endif
 
-    size_t buffer_size = 1 * 1024 * 1024;
-    void *psram_buffer = heap_caps_malloc(buffer_size, MALLOC_CAP_SPIRAM);
-    if (psram_buffer)
-    {
-        ESP_LOGI(TAG, "PSRAM OK: allocated %u bytes at %p", (unsigned)buffer_size, psram_buffer);
-        heap_caps_free(psram_buffer);
-    }
-    else
-    {
-        ESP_LOGW(TAG, "PSRAM allocation failed (no PSRAM or not configured)");
-    }
-
-    ESP_LOGI(TAG, "Initializing I2S...");
-    i2s_init();
+    int phase_stats = boot_phase_begin("stats");
+    signal_stats_init();
+#if CONFIG_WAKE_SIGNAL_STATS_BENCH
+    signal_stats_bench();
+#endif
+    boot_phase_end(phase_stats);
 
     ESP_LOGI(TAG, "Loading models...");
-    srmodel_list_t *models = esp_srmodel_init("model");
-    if (!models || models->num == 0)
+    int phase_models = boot_phase_begin("models");
+    srmodel_list_t *models = model_registry_init("model");
+    boot_phase_end(phase_models);
+    if (!models)
     {
         ESP_LOGE(TAG, "No models found in flash!");
         vTaskDelay(pdMS_TO_TICKS(3000));
@@ -317,11 +159,17 @@ extern "C" void app_main()
         return;
     }
 
+#if !CONFIG_WAKE_FAST_BOOT
     ESP_LOGI(TAG, "Found %d model(s). Listing:", models->num);
     for (int i = 0; i < models->num; ++i)
     {
         ESP_LOGI(TAG, "  [%d] %s", i, models->model_name[i] ? models->model_name[i] : "(null)");
     }
+#endif
+
+#if CONFIG_WAKE_AFE_BENCH
+    afe_bench_run(models);
+#endif
 
     const char *input_fmt = "M";
 
@@ -340,7 +188,15 @@ extern "C" void app_main()
         return;
     }
 
+    model_registry_mark_t afe_mark;
+    model_registry_mark(&afe_mark);
+    int phase_afe = boot_phase_begin("afe");
     esp_afe_sr_data_t *afe_data = afe_handle->create_from_config(afe_config);
+    boot_phase_end(phase_afe);
+    if (afe_data)
+    {
+        model_registry_record(afe_config->wakenet_model_name ? afe_config->wakenet_model_name : "afe", &afe_mark);
+    }
     if (!afe_data)
     {
         ESP_LOGE(TAG, "Failed to create afe_data");
@@ -355,41 +211,48 @@ extern "C" void app_main()
 
     afe_config_free(afe_config);
 
-    // ESP32-S3: USE HIGH-SPEED MODE ONLY
-    ledc_timer_config_t ledc_timer = {
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .duty_resolution = LEDC_TIMER_8_BIT,
-        .timer_num = LEDC_TIMER_0,
-        .freq_hz = 1000,
-        .clk_cfg = LEDC_AUTO_CLK};
-    ledc_timer_config(&ledc_timer);
+#if CONFIG_WAKE_FAST_BOOT
+    xSemaphoreTake(periph_done, portMAX_DELAY);
+#else
+    int phase_periph = boot_phase_begin("periph");
+    periph_init();
+    boot_phase_end(phase_periph);
+#endif
 
-    for (int i = 0; i < 3; i++)
+    // I2S comes up after the AFE so zero-copy mode can size one DMA buffer to one feed chunk
+    size_t feed_samples = (size_t)afe_handle->get_feed_chunksize(afe_data) * (size_t)afe_handle->get_feed_channel_num(afe_data);
+#if CONFIG_WAKE_CAPTURE_ZERO_COPY
+    ESP_LOGI(TAG, "Initializing I2S...");
+    int phase_i2s = boot_phase_begin("i2s");
+    i2s_init((int)feed_samples);
+    boot_phase_end(phase_i2s);
+#elif !CONFIG_WAKE_FAST_BOOT
+    ESP_LOGI(TAG, "Initializing I2S...");
+    int phase_i2s = boot_phase_begin("i2s");
+    i2s_init(I2S_DMA_FRAME_NUM);
+    boot_phase_end(phase_i2s);
+#endif
+    // every pipeline buffer comes out of one region per memory class, sized from the chunk geometry
+#if CONFIG_WAKE_PLACEMENT_BENCH
+    arena_place_auto(pipeline_placement_bench(afe_data));
+#endif
+    arena_plan_t plan = {};
+    capture_plan(&plan, feed_samples);
+    pipeline_plan(&plan, afe_data);
+    if (!arena_init(&plan))
     {
-        ledc_channel_config_t ledc_ch = {
-            .gpio_num = ledPins[i],
-            .speed_mode = LEDC_LOW_SPEED_MODE,
-            .channel = (ledc_channel_t)i,
-            .intr_type = LEDC_INTR_DISABLE,
-            .timer_sel = LEDC_TIMER_0,
-            .duty = 255, // OFF
-            .hpoint = 0,
-            .flags = {.output_invert = 0}};
-        ledc_channel_config(&ledc_ch);
+        ESP_LOGE(TAG, "Failed to reserve the pipeline arena");
+        return;
+    }
+    if (capture_start(rx_handle, feed_samples, I2S_DMA_DESC_NUM) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to start I2S capture");
+        return;
     }
 
-    // Configure TRIGGER_GPIO as output
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << TRIGGER_GPIO),
-        .mode = GPIO_MODE_OUTPUT,
-        .pull_up_en = GPIO_PULLUP_DISABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE};
-    gpio_config(&io_conf);
-    gpio_set_level(TRIGGER_GPIO, 0); // Start low
-
-    task_flag = 1;
     printf("LED and GPIO initialized done ");
-    xTaskCreatePinnedToCore(feed_Task, "feed", 4096, (void *)afe_data, 7, NULL, 0);
-    xTaskCreatePinnedToCore(detect_Task, "detect", 8192, (void *)afe_data, 6, NULL, 1);
+    pipeline_start(afe_data);
+#if CONFIG_WAKE_CONSOLE
+    wake_console_start();
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,255 @@
+/* model_registry.cpp - the model partition index, loaded once, and lazily created model instances */
+#include <stdio.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_mn_models.h"
+#include "esp_process_sdkconfig.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <atomic>
+#include "cmd_table.h"
+#include "model_registry.h"
+
+#define TAG "WAKE_DBG"
+
+static srmodel_list_t *models = NULL;
+static std::atomic<esp_mn_iface_t *> multinet(NULL);
+static std::atomic<model_iface_data_t *> multinet_data(NULL);
+static std::atomic<model_iface_data_t *> rebuilt(NULL); // loaded with the new table, waiting for the detect task
+static std::atomic<model_iface_data_t *> retired(NULL); // swapped out, waiting to be destroyed
+static std::atomic<bool> rebuild_wanted(false);
+static std::atomic<bool> rebuild_run(false);
+static TaskHandle_t rebuild_task = NULL;
+static int multinet_duration_ms = 0;
+static model_load_info_t loaded[MODEL_REGISTRY_MAX];
+static int loaded_count = 0;
+static SemaphoreHandle_t lock = NULL;
+
+void model_registry_mark(model_registry_mark_t *mark)
+{
+    mark->internal_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    mark->psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    mark->t0 = esp_timer_get_time();
+}
+
+void model_registry_record(const char *name, const model_registry_mark_t *since)
+{
+    int64_t us = esp_timer_get_time() - since->t0;
+    size_t internal_now = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    size_t psram_now = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    model_load_info_t info = {
+        .name = name,
+        .load_us = us,
+        .internal_bytes = since->internal_free > internal_now ? since->internal_free - internal_now : 0,
+        .psram_bytes = since->psram_free > psram_now ? since->psram_free - psram_now : 0,
+    };
+    if (loaded_count < MODEL_REGISTRY_MAX)
+        loaded[loaded_count++] = info;
+    ESP_LOGI(TAG, "model %s: %u ms, %u KB internal, %u KB PSRAM", name, (unsigned)(us / 1000),
+             (unsigned)(info.internal_bytes / 1024), (unsigned)(info.psram_bytes / 1024));
+}
+
+srmodel_list_t *model_registry_init(const char *partition_label)
+{
+    if (models)
+        return models;
+    if (!lock)
+        lock = xSemaphoreCreateMutex();
+
+    model_registry_mark_t mark;
+    model_registry_mark(&mark);
+    srmodel_list_t *list = esp_srmodel_init(partition_label);
+    if (!list || list->num == 0)
+        return NULL;
+    models = list;
+    model_registry_record("index", &mark);
+    return models;
+}
+
+srmodel_list_t *model_registry_models(void)
+{
+    return models;
+}
+
+char *model_registry_wakenet_name(void)
+{
+    return esp_srmodel_filter(models, ESP_WN_PREFIX, NULL);
+}
+
+char *model_registry_multinet_name(void)
+{
+    return esp_srmodel_filter(models, ESP_MN_PREFIX, ESP_MN_ENGLISH);
+}
+
+static void load_commands(esp_mn_iface_t *iface, model_iface_data_t *md)
+{
+#if CONFIG_WAKE_CMD_TABLE
+    cmd_table_apply(iface, md);
+#else
+    esp_mn_commands_update_from_sdkconfig(iface, md);
+#endif
+}
+
+static void multinet_rebuild_Task(void *arg)
+{
+    while (rebuild_run.load(std::memory_order_acquire))
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        esp_mn_iface_t *iface = multinet.load(std::memory_order_acquire);
+        model_iface_data_t *old = retired.exchange(NULL);
+        if (old && iface)
+            iface->destroy(old);
+        // one rebuilt instance at a time: the next starts once the detect task has taken this one
+        if (!rebuild_run.load(std::memory_order_acquire) || !iface || rebuilt.load(std::memory_order_acquire) ||
+            !rebuild_wanted.exchange(false))
+            continue;
+
+        xSemaphoreTake(lock, portMAX_DELAY);
+        int64_t t0 = esp_timer_get_time();
+        model_iface_data_t *md = iface->create(model_registry_multinet_name(), multinet_duration_ms);
+        if (md)
+        {
+            load_commands(iface, md);
+            rebuilt.store(md, std::memory_order_release);
+        }
+        xSemaphoreGive(lock);
+        if (md)
+            ESP_LOGI(TAG, "MultiNet rebuilt in %u ms", (unsigned)((esp_timer_get_time() - t0) / 1000));
+        else
+            ESP_LOGE(TAG, "MultiNet rebuild failed");
+    }
+    vTaskDelete(NULL);
+}
+
+/* with lock held and the first instance loaded */
+static void start_rebuild(void)
+{
+    if (!rebuild_task)
+    {
+        rebuild_run.store(true, std::memory_order_release);
+        xTaskCreatePinnedToCore(multinet_rebuild_Task, "mn_rebuild", 4096, NULL, 2, &rebuild_task, 1);
+    }
+    xTaskNotifyGive(rebuild_task);
+}
+
+esp_mn_iface_t *model_registry_multinet(model_iface_data_t **data, int duration_ms)
+{
+    if (!models)
+        return NULL;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (!multinet.load(std::memory_order_acquire))
+    {
+        char *name = model_registry_multinet_name();
+        if (name)
+        {
+            model_registry_mark_t mark;
+            model_registry_mark(&mark);
+#if CONFIG_WAKE_CMD_TABLE
+            cmd_table_init(CONFIG_WAKE_CMD_TABLE_PARTITION);
+#endif
+            esp_mn_iface_t *iface = esp_mn_handle_from_name(name);
+            model_iface_data_t *md = iface ? iface->create(name, duration_ms) : NULL;
+            if (md)
+            {
+                load_commands(iface, md);
+                multinet_data.store(md, std::memory_order_relaxed);
+                multinet_duration_ms = duration_ms;
+                model_registry_record(name, &mark);
+                multinet.store(iface, std::memory_order_release);
+                if (rebuild_wanted.load(std::memory_order_acquire))
+                    start_rebuild(); // the table changed while this instance was loading
+            }
+        }
+    }
+    xSemaphoreGive(lock);
+    *data = multinet_data.load(std::memory_order_relaxed);
+    return multinet.load(std::memory_order_relaxed);
+}
+
+static void multinet_load_Task(void *arg)
+{
+    model_iface_data_t *data;
+    if (!model_registry_multinet(&data, (int)(intptr_t)arg))
+        ESP_LOGE(TAG, "MultiNet load failed");
+    vTaskDelete(NULL);
+}
+
+void model_registry_multinet_async(int duration_ms)
+{
+    if (multinet.load(std::memory_order_acquire))
+        return;
+    xTaskCreatePinnedToCore(multinet_load_Task, "mn_load", 4096, (void *)(intptr_t)duration_ms, 2, NULL, 1);
+}
+
+esp_mn_iface_t *model_registry_multinet_ready(model_iface_data_t **data)
+{
+    esp_mn_iface_t *mn = multinet.load(std::memory_order_acquire);
+    *data = mn ? multinet_data.load(std::memory_order_relaxed) : NULL;
+    return mn;
+}
+
+void model_registry_multinet_rebuild(void)
+{
+    if (!lock)
+        return;
+    rebuild_wanted.store(true, std::memory_order_release);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (multinet.load(std::memory_order_acquire))
+        start_rebuild();
+    xSemaphoreGive(lock);
+}
+
+bool model_registry_multinet_swap(model_iface_data_t **data)
+{
+    model_iface_data_t *md = rebuilt.load(std::memory_order_acquire);
+    if (!md)
+        return false;
+    rebuilt.store(NULL, std::memory_order_relaxed);
+    retired.store(multinet_data.exchange(md, std::memory_order_acq_rel), std::memory_order_release);
+    xTaskNotifyGive(rebuild_task); // destroys the old instance and starts any rebuild that waited
+    *data = md;
+    return true;
+}
+
+void model_registry_deinit(void)
+{
+    if (rebuild_task)
+    {
+        rebuild_run.store(false, std::memory_order_release);
+        xTaskNotifyGive(rebuild_task);
+        rebuild_task = NULL;
+    }
+    if (lock)
+        xSemaphoreTake(lock, portMAX_DELAY); // waits out a rebuild in progress
+    esp_mn_iface_t *mn = multinet.exchange(NULL);
+    if (mn)
+    {
+        mn->destroy(multinet_data.exchange(NULL));
+        model_iface_data_t *md = rebuilt.exchange(NULL);
+        if (md)
+            mn->destroy(md);
+        if ((md = retired.exchange(NULL)) != NULL)
+            mn->destroy(md);
+    }
+    rebuild_wanted.store(false, std::memory_order_relaxed);
+    if (lock)
+        xSemaphoreGive(lock);
+#if CONFIG_WAKE_CMD_TABLE
+    cmd_table_deinit();
+#endif
+    esp_srmodel_deinit(models);
+    models = NULL;
+    loaded_count = 0;
+}
+
+void model_registry_report(void)
+{
+    for (int i = 0; i < loaded_count; ++i)
+    {
+        printf("model %s: load=%ums internal=%uKB psram=%uKB\n", loaded[i].name, (unsigned)(loaded[i].load_us / 1000),
+               (unsigned)(loaded[i].internal_bytes / 1024), (unsigned)(loaded[i].psram_bytes / 1024));
+    }
+}
@@ -0,0 +1,57 @@
+/* model_registry.h - the model partition index, loaded once, and lazily created model instances */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "model_path.h"
+#include "esp_mn_iface.h"
+
+#define MODEL_REGISTRY_MAX 4
+
+typedef struct
+{
+    const char *name;
+    int64_t load_us;
+    size_t internal_bytes; // heap taken by the load, internal RAM
+    size_t psram_bytes;    // heap taken by the load, PSRAM
+} model_load_info_t;
+
+typedef struct
+{
+    int64_t t0;
+    size_t internal_free;
+    size_t psram_free;
+} model_registry_mark_t;
+
+/* Parses the partition index on the first call and returns the same list ever after. NULL if empty. */
+srmodel_list_t *model_registry_init(const char *partition_label);
+srmodel_list_t *model_registry_models(void);
+
+/* First WakeNet / English MultiNet name in the index, NULL if absent */
+char *model_registry_wakenet_name(void);
+char *model_registry_multinet_name(void);
+
+/* MultiNet instance, created on the first call and shared after that; NULL if no model */
+esp_mn_iface_t *model_registry_multinet(model_iface_data_t **data, int duration_ms);
+/* Starts creating the MultiNet in a low-priority task so wake listening need not wait for it. */
+void model_registry_multinet_async(int duration_ms);
+/* Non-blocking: the MultiNet once the async load has finished, else NULL. */
+esp_mn_iface_t *model_registry_multinet_ready(model_iface_data_t **data);
+/* Reloads the command table (cmd_table.h) into a second MultiNet instance on a
+ * low-priority task while the first keeps recognizing; requests made during a
+ * rebuild are merged into one more. No-op before the first load. */
+void model_registry_multinet_rebuild(void);
+/* Detect task, between command windows: O(1) switch to a rebuilt instance.
+ * Returns true and updates *data when it switched; the old instance is
+ * destroyed on the rebuild task. */
+bool model_registry_multinet_swap(model_iface_data_t **data);
+
+/* Brackets a model load done elsewhere (e.g. WakeNet inside the AFE) so it shows up in the report. */
+void model_registry_mark(model_registry_mark_t *mark);
+void model_registry_record(const char *name, const model_registry_mark_t *since);
+
+/* destroys the MultiNet and frees the index */
+void model_registry_deinit(void);
+
+/* one line per loaded model: load time and heap footprint */
+void model_registry_report(void);
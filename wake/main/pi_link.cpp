@@ -0,0 +1,196 @@
+/* pi_link.cpp - link task: queued pipeline events -> CRC-framed UART frames for the Raspberry Pi */
+#include <string.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/uart.h"
+#include "sdkconfig.h"
+#include "link_proto.h"
+#include "phrase_table.h"
+#include "pipeline.h"
+#include "pi_link.h"
+
+#define TAG "WAKE_DBG"
+#define LINK_QUEUE_LEN 16
+#define LINK_TX_RING_BYTES 1024
+#define LINK_HEARTBEAT_MS 1000
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t len;
+    uint8_t payload[LINK_MAX_PAYLOAD];
+} link_msg_t;
+
+static QueueHandle_t link_queue = NULL;
+static std::atomic<uint32_t> link_frames(0);
+static std::atomic<uint32_t> link_dropped(0);
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void post(uint8_t type, const void *payload, size_t len)
+{
+    if (!link_queue)
+        return;
+    link_msg_t m;
+    m.type = type;
+    m.len = (uint8_t)len;
+    memcpy(m.payload, payload, len);
+    if (xQueueSend(link_queue, &m, 0) != pdTRUE)
+        link_dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+#if CONFIG_WAKE_LINK
+static void send(uint8_t type, uint8_t seq, const void *payload, size_t len)
+{
+    uint8_t frame[LINK_FRAME_MAX];
+    size_t n = link_encode(frame, type, seq, payload, len);
+    // copies into the driver's TX ring buffer (waiting here if it is full); the FIFO interrupt does the rest
+    if (uart_write_bytes((uart_port_t)CONFIG_WAKE_LINK_UART_NUM, frame, n) == (int)n)
+        link_frames.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void send_hello(uint8_t seq)
+{
+    link_hello_t h = {};
+    h.t_ms = now_ms();
+    h.version = LINK_VERSION;
+    h.phrase_table = PHRASE_TABLE_HASH;
+    send(LINK_HELLO, seq, &h, sizeof(h));
+}
+
+/* seq of the next frame: a frame dropped on a full queue still takes one,
+ * so the Pi counts it as lost like a frame lost on the wire */
+static uint8_t next_seq(uint8_t *seq, uint32_t *counted_drops)
+{
+    uint32_t d = link_dropped.load(std::memory_order_relaxed);
+    *seq = (uint8_t)(*seq + (d - *counted_drops));
+    *counted_drops = d;
+    return (*seq)++;
+}
+
+/* link task: the only writer of the link UART */
+static void link_Task(void *arg)
+{
+    uint8_t seq = 0;
+    uint32_t counted_drops = 0;
+    send_hello(next_seq(&seq, &counted_drops));
+    int64_t last_sent = esp_timer_get_time();
+    while (task_flag)
+    {
+        link_msg_t m;
+        if (xQueueReceive(link_queue, &m, pdMS_TO_TICKS(100)) == pdTRUE)
+            send(m.type, next_seq(&seq, &counted_drops), m.payload, m.len);
+        else if (esp_timer_get_time() - last_sent < LINK_HEARTBEAT_MS * 1000)
+            continue;
+        else
+            send_hello(next_seq(&seq, &counted_drops)); // lets the Pi tell a quiet room from a dead link
+        last_sent = esp_timer_get_time();
+    }
+    vTaskDelete(NULL);
+}
+#endif
+
+void pi_link_start(void)
+{
+#if CONFIG_WAKE_LINK
+    uart_port_t port = (uart_port_t)CONFIG_WAKE_LINK_UART_NUM;
+    uart_config_t cfg = {};
+    cfg.baud_rate = CONFIG_WAKE_LINK_BAUD;
+    cfg.data_bits = UART_DATA_8_BITS;
+    cfg.parity = UART_PARITY_DISABLE;
+    cfg.stop_bits = UART_STOP_BITS_1;
+    cfg.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+    cfg.source_clk = UART_SCLK_DEFAULT;
+    // TX only; the RX buffer just has to be larger than the 128-byte hardware FIFO
+    esp_err_t err = uart_driver_install(port, 256, LINK_TX_RING_BYTES, 0, NULL, 0);
+    if (err == ESP_OK)
+        err = uart_param_config(port, &cfg);
+    if (err == ESP_OK)
+        err = uart_set_pin(port, CONFIG_WAKE_LINK_TX_GPIO, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Pi link UART%d not started: %d", (int)port, err);
+        return;
+    }
+    link_queue = xQueueCreate(LINK_QUEUE_LEN, sizeof(link_msg_t));
+    xTaskCreatePinnedToCore(link_Task, "pi_link", 3072, NULL, 3, NULL, 0);
+    ESP_LOGI(TAG, "Pi link on UART%d TX GPIO %d at %d baud", (int)port, CONFIG_WAKE_LINK_TX_GPIO, CONFIG_WAKE_LINK_BAUD);
+#endif
+}
+
+void pi_link_wake(int model_index, int word_index, int channel)
+{
+    link_wake_t w = {};
+    w.t_ms = now_ms();
+    w.model_index = (int8_t)model_index;
+    w.word_index = (int8_t)word_index;
+    w.channel = (int8_t)channel;
+    post(LINK_WAKE, &w, sizeof(w));
+}
+
+void pi_link_command(int rank, bool accepted, int command_id, int phrase_id, float prob)
+{
+    link_command_t c = {};
+    c.t_ms = now_ms();
+    c.rank = (uint8_t)rank;
+    c.accepted = accepted ? 1 : 0;
+    c.command_id = (int16_t)command_id;
+    c.phrase_id = (int16_t)phrase_id;
+    float p = prob < 0.0f ? 0.0f : prob > 1.0f ? 1.0f : prob;
+    c.prob_q16 = (uint16_t)(p * 65535.0f + 0.5f);
+    uint16_t e = phrase_entry(command_id);
+    c.severity = (uint8_t)phrase_severity(e);
+    c.category = (uint8_t)phrase_category(e);
+    post(LINK_COMMAND, &c, sizeof(c));
+}
+
+void pi_link_timeout(void)
+{
+    link_timeout_t t = {};
+    t.t_ms = now_ms();
+    post(LINK_TIMEOUT, &t, sizeof(t));
+}
+
+static uint16_t sat_u16(uint32_t v)
+{
+    return (uint16_t)(v > 0xFFFF ? 0xFFFF : v);
+}
+
+void pi_link_audio_stats(const audio_stats_summary_t *s)
+{
+    link_audio_stats_t a = {};
+    a.t_ms = now_ms();
+    a.rms_dbfs_x10 = (int16_t)(s->rms_dbfs * 10.0f);
+    a.peak = (int16_t)(s->peak > 32767 ? 32767 : s->peak);
+    a.dc = (int16_t)s->dc;
+    a.silent_pct = (uint8_t)(s->silent_ratio * 100.0f + 0.5f);
+    a.clipped = sat_u16(s->clipped);
+    a.overruns = sat_u16(s->overruns);
+    a.underruns = sat_u16(s->underruns);
+    a.chunks = sat_u16(s->chunks);
+    post(LINK_AUDIO_STATS, &a, sizeof(a));
+}
+
+void pi_link_silence(const silence_report_t *r)
+{
+    link_silence_t l = {};
+    l.t_ms = now_ms();
+    l.silent_s = sat_u16(r->silent_s);
+    l.floor_dbfs_x10 = r->floor_dbfs_x10;
+    l.threshold_dbfs_x10 = r->threshold_dbfs_x10;
+    l.state = (uint8_t)r->state;
+    post(LINK_SILENCE, &l, sizeof(l));
+}
+
+void pi_link_get_stats(pi_link_stats_t *out)
+{
+    out->frames = link_frames.load(std::memory_order_relaxed);
+    out->dropped = link_dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,30 @@
+/* pi_link.h - framed UART event link to the Raspberry Pi (wire format in link_proto.h)
+ *
+ * The pipeline tasks only queue messages; a low-priority task frames them and
+ * hands them to the UART driver, whose TX ring buffer and FIFO interrupt put
+ * them on the wire. TRIGGER_GPIO keeps working alongside for old Pi scripts.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "audio_stats.h"
+#include "silence.h"
+
+/* Installs the UART driver and starts the link task (priority 3, core 0).
+ * Without CONFIG_WAKE_LINK every pi_link_* call is a no-op. */
+void pi_link_start(void);
+
+/* Never block; a full queue drops the message and counts it. */
+void pi_link_wake(int model_index, int word_index, int channel);
+void pi_link_command(int rank, bool accepted, int command_id, int phrase_id, float prob);
+void pi_link_timeout(void);
+void pi_link_audio_stats(const audio_stats_summary_t *s);
+void pi_link_silence(const silence_report_t *r);
+
+typedef struct
+{
+    uint32_t frames;  // written to the UART driver
+    uint32_t dropped; // queue full
+} pi_link_stats_t;
+
+void pi_link_get_stats(pi_link_stats_t *out);
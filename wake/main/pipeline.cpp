@@ -0,0 +1,453 @@
+/* pipeline.cpp - feed and detect tasks of the wake pipeline, shared by the firmware and the host simulation */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_afe_sr_iface.h"
+#include "esp_afe_sr_models.h"
+#include "esp_wn_iface.h"
+#include "esp_wn_models.h"
+#include "esp_mn_iface.h"
+#include "esp_mn_models.h"
+#include "esp_process_sdkconfig.h"
+#include "sdkconfig.h"
+#include "actuator.h"
+#include "arena.h"
+#include "capture.h"
+#include "signal_stats.h"
+#include "audio_stats.h"
+#include "silence.h"
+#include "energy_gate.h"
+#include "decision.h"
+#include "event_log.h"
+#include "latency_trace.h"
+#include "model_registry.h"
+#include "pi_link.h"
+#include "boot_profile.h"
+#include "pipeline.h"
+
+#define TAG "WAKE_DBG"
+
+int wakeup_flag = 0;
+esp_afe_sr_iface_t *afe_handle = NULL;
+volatile int task_flag = 0;
+static audio_stats_t audio_stats;
+static silence_t silence;
+static TaskHandle_t detect_task = NULL;
+static int16_t *feed_buf = NULL; // ring mode copy target, from the arena
+#if CONFIG_WAKE_GATE
+#define GATE_PREROLL_MS CONFIG_WAKE_GATE_PREROLL_MS
+static energy_gate_t gate;
+#else
+#define GATE_PREROLL_MS 0
+#endif
+
+static uint32_t gate_preroll_chunks(int chunk)
+{
+    uint32_t chunk_ms = (uint32_t)(1000 * chunk / SAMPLE_RATE);
+    uint32_t n = (GATE_PREROLL_MS + chunk_ms - 1) / chunk_ms;
+    return n < ENERGY_GATE_MAX_PREROLL ? n : ENERGY_GATE_MAX_PREROLL;
+}
+
+static void feed_chunk(esp_afe_sr_data_t *afe_data, const int16_t *data, int64_t captured_at)
+{
+    // stamp before feeding so the detect task can never fetch a chunk it has no stamp for
+    latency_trace_fed(captured_at);
+    afe_handle->feed(afe_data, data);
+#if !CONFIG_WAKE_DETECT_POLL
+    xTaskNotifyGive(detect_task);
+#endif
+}
+
+/* feed task: take exact feed chunks from the capture stage, fold their stats into the window, feed to AFE */
+void feed_Task(void *arg)
+{
+    esp_afe_sr_data_t *afe_data = (esp_afe_sr_data_t *)arg;
+    if (!afe_handle || !afe_data)
+    {
+        ESP_LOGE(TAG, "afe_handle or afe_data NULL in feed_Task!");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    int chunk = afe_handle->get_feed_chunksize(afe_data);
+    int ch = afe_handle->get_feed_channel_num(afe_data);
+    ESP_LOGI(TAG, "Feed task chunk=%d channels=%d", chunk, ch);
+
+    int16_t *buffer = feed_buf;
+    if (!capture_is_zero_copy() && !buffer)
+    {
+        ESP_LOGE(TAG, "No feed buffer in the arena");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    audio_stats_config_t stats_cfg = {
+        .window_chunks = (uint32_t)((uint64_t)CONFIG_WAKE_STATS_WINDOW_MS * SAMPLE_RATE / 1000 / chunk),
+        .silent_rms = CONFIG_WAKE_STATS_SILENT_RMS,
+    };
+    audio_stats_init(&audio_stats, &stats_cfg);
+    silence_config_t silence_cfg = {
+        .chunk_ms = (uint32_t)(1000 * chunk / SAMPLE_RATE),
+        .calib_ms = CONFIG_WAKE_SILENCE_CALIB_MS,
+        .grace_ms = (uint32_t)CONFIG_WAKE_SILENCE_GRACE_S * 1000,
+        .margin_db_x10 = CONFIG_WAKE_SILENCE_MARGIN_DB_X10,
+    };
+    silence_init(&silence, &silence_cfg);
+
+    // no new chunk within two chunk periods means capture has stalled
+    TickType_t stall_ticks = pdMS_TO_TICKS(2 * 1000 * chunk / SAMPLE_RATE) + 1;
+
+    ESP_LOGI(TAG, "Feed task started");
+    arena_hot_enter();
+
+    while (task_flag)
+    {
+        capture_chunk_t in;
+        if (!capture_acquire(&in, buffer, stall_ticks))
+        {
+            continue;
+        }
+
+        signal_stats_t st;
+        signal_stats_compute(in.data, in.samples, &st);
+        bool publish = audio_stats_add(&audio_stats, &st);
+        silence_report_t silence_rep;
+        if (silence_add(&silence, &st, &silence_rep))
+        {
+            pi_link_silence(&silence_rep);
+            if (silence_rep.calibrated)
+                EVENT_LOG(EV_SILENCE_CALIBRATED, ev_f(silence_rep.floor_dbfs_x10 / 10.0f), ev_f(silence_rep.threshold_dbfs_x10 / 10.0f));
+        }
+
+#if CONFIG_WAKE_GATE
+        // a quiet chunk is only copied aside; a loud one first replays what was set aside before it
+        bool gated = !energy_gate_add(&gate, &st);
+        if (gated)
+            energy_gate_stash(&gate, in.data, in.captured_at);
+        const int16_t *pre;
+        int64_t pre_at;
+        while (!gated && energy_gate_replay(&gate, &pre, &pre_at))
+            feed_chunk(afe_data, pre, pre_at);
+#else
+        bool gated = false;
+#endif
+        // feed() consumes the chunk synchronously, so a DMA lease can be returned right after
+        if (!gated)
+            feed_chunk(afe_data, in.data, in.captured_at);
+        capture_release(&in);
+        // FETCH REMOVED — ONLY FEED HERE
+
+        if (publish)
+        {
+            capture_stats_t cs;
+            capture_get_stats(&cs);
+            audio_stats_summary_t summary;
+            audio_stats_publish(&audio_stats, cs.overruns, cs.underruns, &summary);
+            pi_link_audio_stats(&summary);
+        }
+    }
+
+    vTaskDelete(NULL);
+}
+
+/* Switches to a MultiNet rebuilt with a changed command table. Only called
+ * where no utterance is in progress: outside a command window, or right
+ * after MultiNet reported DETECTED or TIMEOUT and its results were used. */
+static void multinet_swap(model_iface_data_t **model_data)
+{
+    if (model_registry_multinet_swap(model_data))
+        EVENT_LOG(EV_MN_SWAPPED);
+}
+
+/* detect task: call afe fetch and react to wake events */
+void detect_Task(void *arg)
+{
+    esp_afe_sr_data_t *afe_data = (esp_afe_sr_data_t *)arg;
+    esp_mn_iface_t *multinet = NULL;
+    model_iface_data_t *model_data = NULL;
+
+    if (!afe_handle || !afe_data)
+    {
+        ESP_LOGE(TAG, "afe_handle or afe_data NULL in detect_Task!");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    // MultiNet loads in the background; WakeNet listening starts right away
+    model_registry_multinet_async(6000);
+
+    int chunk = afe_handle->get_fetch_chunksize(afe_data);
+    ESP_LOGI(TAG, "Detect task chunk=%d", chunk);
+
+#if !CONFIG_WAKE_DETECT_POLL
+    // AFE output for a fed chunk is normally ready well inside one chunk period
+    TickType_t chunk_ticks = pdMS_TO_TICKS(1000 * chunk / SAMPLE_RATE) + 1;
+    TickType_t idle_ticks = pdMS_TO_TICKS(100);
+    bool drain = false; // more results may be ready without a new notification
+#endif
+    uint32_t report_chunks = (uint32_t)((uint64_t)CONFIG_WAKE_LATENCY_REPORT_S * SAMPLE_RATE / chunk);
+    uint32_t chunks = 0;
+
+    decision_t decision;
+    decision_config_t decision_cfg = {.cmd_threshold = 0.5f};
+    decision_init(&decision, &decision_cfg);
+
+    ESP_LOGI(TAG, "Listening for 20 greetings in parallel...");
+
+    while (task_flag)
+    {
+#if CONFIG_WAKE_DETECT_POLL
+        afe_fetch_result_t *res = afe_handle->fetch(afe_data);
+        if (!res)
+        {
+            vTaskDelay(pdMS_TO_TICKS(5));
+            continue;
+        }
+#else
+        // sleep until the feed task hands the AFE a chunk, then drain whatever is ready
+        if (!drain && ulTaskNotifyTake(pdTRUE, idle_ticks) == 0)
+        {
+            continue;
+        }
+        afe_fetch_result_t *res = afe_handle->fetch_with_delay(afe_data, drain ? 0 : chunk_ticks);
+        drain = (res != NULL);
+        if (!res)
+        {
+            continue;
+        }
+#endif
+        if (res->ret_value == ESP_FAIL)
+        {
+            ESP_LOGE(TAG, "AFE fetch failed");
+            break;
+        }
+
+        ESP_LOGD(TAG, "AFE fetch: vad=%d, wakeup_state=%d, model_idx=%d, word_idx=%d",
+                 res->vad_state, res->wakeup_state, res->wakenet_model_index, res->wake_word_index);
+
+        trace_stamp_t stamp;
+        latency_trace_fetched(&stamp);
+        boot_listening(); // first fetched chunk: prints the boot summary once
+        if (report_chunks && ++chunks % report_chunks == 0)
+        {
+            EVENT_LOG(EV_LATENCY_REPORT); // printed by the event log task
+        }
+
+        decision_actions_t act;
+        bool listen = decision_on_fetch(&decision, res, &act);
+        if (!listen)
+        {
+            latency_trace_since(TRACE_FETCH_DECISION, stamp.fetched_at); // otherwise once MultiNet has decided
+        }
+        if (act.flags & DECISION_TRIGGER_HIGH)
+        {
+            // the actuation task raises TRIGGER_GPIO for the Raspberry Pi; post before any logging
+            actuator_event_t ev = {};
+            ev.kind = ACT_WAKE;
+            ev.captured_at = stamp.captured_at;
+            ev.decided_at = esp_timer_get_time();
+            actuator_post(&ev);
+            pi_link_wake(res->wakenet_model_index, res->wake_word_index,
+                         res->wakeup_state == WAKENET_CHANNEL_VERIFIED ? res->trigger_channel_id : -1);
+            wakeup_flag = 1;
+            if (!silence_armed(&silence))
+                silence_arm(&silence); // the first wake starts the room's silence tracking, as shutdown.py did
+#if CONFIG_WAKE_GATE
+            energy_gate_keep_open(&gate, true); // MultiNet needs every chunk until the command window closes
+#endif
+            if (multinet)
+                multinet->clean(model_data); // a new command window: MultiNet's timeout starts over
+            // afe_handle->disable_wakenet(afe_data);  // DISABLE WAKE NET
+
+            // records only: the event log task does the formatting and the UART I/O
+            EVENT_LOG(EV_WAKE, ev_i(res->wakenet_model_index), ev_i(res->wake_word_index),
+                      ev_i(res->wakeup_state == WAKENET_CHANNEL_VERIFIED ? res->trigger_channel_id : -1));
+        }
+
+        if (!listen && multinet)
+        {
+            multinet_swap(&model_data);
+        }
+
+        if (listen && !multinet)
+        {
+            multinet = model_registry_multinet_ready(&model_data);
+            if (multinet)
+            {
+                printf("multinet:%s\n", model_registry_multinet_name());
+                assert(multinet->get_samp_chunksize(model_data) == chunk);
+                multinet->print_active_speech_commands(model_data);
+                // printf and esp-sr allocate above; the loop allocates nothing from here on
+                arena_hot_enter();
+            }
+            else
+            {
+                ESP_LOGD(TAG, "MultiNet still loading, chunk not scored");
+                listen = false;
+            }
+        }
+
+        if (listen)
+        {
+            esp_mn_state_t mn_state = multinet->detect(model_data, res->data);
+
+            if (mn_state == ESP_MN_STATE_DETECTING)
+            {
+                latency_trace_since(TRACE_FETCH_DECISION, stamp.fetched_at);
+                continue;
+            }
+
+            esp_mn_results_t *mn_result = multinet->get_results(model_data);
+            decision_on_command(&decision, mn_state, mn_result, &act);
+            latency_trace_since(TRACE_FETCH_DECISION, stamp.fetched_at);
+
+            if (mn_state == ESP_MN_STATE_DETECTED)
+            {
+                for (int i = 0; i < mn_result->num; i++)
+                {
+                    EVENT_LOG(EV_MN_RESULT, ev_i(i + 1), ev_i(mn_result->command_id[i]), ev_i(mn_result->phrase_id[i]),
+                              ev_f(mn_result->prob[i]));
+                    bool accepted = false;
+                    for (int c = 0; c < act.commands; c++)
+                        accepted |= act.command_id[c] == mn_result->command_id[i];
+                    pi_link_command(i + 1, accepted, mn_result->command_id[i], mn_result->phrase_id[i], mn_result->prob[i]);
+                }
+                // LED CONTROL: PROB > threshold → TURN ON THE COMMAND'S MANIFEST LEDS
+                if (act.led_on)
+                {
+                    actuator_event_t ev = {};
+                    ev.kind = ACT_COMMAND;
+                    ev.leds = act.led_on;
+                    actuator_post(&ev);
+                }
+                for (int c = 0; c < act.commands; c++)
+                {
+                    unsigned leds = phrase_leds(phrase_entry(act.command_id[c]));
+                    for (int led = 0; led < DECISION_LED_COUNT; led++)
+                    {
+                        if (leds & (1u << led))
+                            EVENT_LOG(EV_LED_ON, ev_i(led), ev_i(act.command_id[c]));
+                    }
+                }
+                EVENT_LOG(EV_LISTENING);
+            }
+
+            if (act.flags & (DECISION_LEDS_OFF | DECISION_TRIGGER_LOW))
+            {
+                // LEDs fade out and TRIGGER_GPIO drops on the actuation task
+                actuator_event_t ev = {};
+                ev.kind = ACT_TIMEOUT;
+                ev.flags = (uint16_t)(act.flags & (DECISION_LEDS_OFF | DECISION_TRIGGER_LOW));
+                actuator_post(&ev);
+                pi_link_timeout();
+            }
+
+            if (act.flags & DECISION_LEDS_OFF)
+            {
+                EVENT_LOG(EV_TIMEOUT);
+                // afe_handle->enable_wakenet(afe_data);
+                // wakeup_flag = 0;
+            }
+
+            // between utterances: mn_result is not used past this point
+            multinet_swap(&model_data);
+
+            if (act.flags & DECISION_TRIGGER_LOW)
+            {
+#if CONFIG_WAKE_GATE
+                energy_gate_keep_open(&gate, false);
+#endif
+                EVENT_LOG(EV_AWAIT);
+                continue;
+            }
+        }
+
+        // FREE DATA ONLY HERE
+        if (res->data)
+        {
+            // free(res->data);
+        }
+    }
+
+    vTaskDelete(NULL);
+}
+
+static void latency_report_action(const event_rec_t *rec)
+{
+    latency_trace_print();
+}
+
+void pipeline_plan(arena_plan_t *plan, esp_afe_sr_data_t *afe_data)
+{
+    size_t samples = (size_t)afe_handle->get_feed_chunksize(afe_data) * (size_t)afe_handle->get_feed_channel_num(afe_data);
+    if (!capture_is_zero_copy())
+        arena_plan_add(plan, ARENA_BUF_FEED, samples * sizeof(int16_t));
+    uint32_t preroll = gate_preroll_chunks(afe_handle->get_feed_chunksize(afe_data));
+    if (preroll)
+        arena_plan_add(plan, ARENA_BUF_PREROLL, preroll * samples * sizeof(int16_t));
+}
+
+void pipeline_start(esp_afe_sr_data_t *afe_data)
+{
+    if (!capture_is_zero_copy())
+    {
+        size_t samples = (size_t)afe_handle->get_feed_chunksize(afe_data) * (size_t)afe_handle->get_feed_channel_num(afe_data);
+        feed_buf = (int16_t *)arena_alloc(ARENA_BUF_FEED, samples * sizeof(int16_t));
+    }
+#if CONFIG_WAKE_GATE
+    int chunk = afe_handle->get_feed_chunksize(afe_data);
+    energy_gate_config_t gate_cfg = {
+        .chunk_ms = (uint32_t)(1000 * chunk / SAMPLE_RATE),
+        .chunk_samples = (size_t)chunk * (size_t)afe_handle->get_feed_channel_num(afe_data),
+        .preroll_chunks = gate_preroll_chunks(chunk),
+        .hold_ms = CONFIG_WAKE_GATE_HOLD_MS,
+        .open_db_x10 = CONFIG_WAKE_GATE_OPEN_DB_X10,
+        .min_rms = CONFIG_WAKE_GATE_MIN_RMS,
+    };
+    int16_t *preroll = NULL;
+    if (gate_cfg.preroll_chunks)
+        preroll = (int16_t *)arena_alloc(ARENA_BUF_PREROLL, gate_cfg.preroll_chunks * gate_cfg.chunk_samples * sizeof(int16_t));
+    energy_gate_init(&gate, &gate_cfg, preroll);
+#endif
+    task_flag = 1;
+    latency_trace_init();
+    event_log_set_action(EV_LATENCY_REPORT, latency_report_action);
+    event_log_start();
+    actuator_start();
+    pi_link_start();
+    // detect first so the feed task always has a handle to notify
+    xTaskCreatePinnedToCore(detect_Task, "detect", 8192, (void *)afe_data, 6, &detect_task, 1);
+    xTaskCreatePinnedToCore(feed_Task, "feed", 4096, (void *)afe_data, 7, NULL, 0);
+}
+
+void pipeline_print_latency(void)
+{
+    latency_trace_print();
+}
+
+void pipeline_request_stats(void)
+{
+    audio_stats_request(&audio_stats);
+}
+
+#if CONFIG_WAKE_GATE
+void pipeline_gate_stats(energy_gate_stats_t *out)
+{
+    energy_gate_get_stats(&gate, out);
+}
+
+void pipeline_gate_enable(bool on)
+{
+    energy_gate_enable(&gate, on);
+}
+
+bool pipeline_gate_enabled(void)
+{
+    return energy_gate_enabled(&gate);
+}
+#endif
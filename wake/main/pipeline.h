@@ -0,0 +1,41 @@
+/* pipeline.h - feed and detect tasks of the wake pipeline */
+#pragma once
+
+#include "sdkconfig.h"
+#include "esp_afe_sr_iface.h"
+#include "driver/gpio.h"
+#include "arena.h"
+#include "energy_gate.h"
+
+#define SAMPLE_RATE 16000
+#define TRIGGER_GPIO (gpio_num_t)7
+
+extern esp_afe_sr_iface_t *afe_handle;
+extern volatile int task_flag;
+extern int wakeup_flag;
+
+/* feed task: capture stage -> afe->feed(), pinned to core 0 */
+void feed_Task(void *arg);
+/* detect task: afe->fetch() -> WakeNet/MultiNet decisions -> actuator events, pinned to core 1 */
+void detect_Task(void *arg);
+
+/* declares the feed task's buffers for afe_data's chunk geometry; call before arena_init() */
+void pipeline_plan(arena_plan_t *plan, esp_afe_sr_data_t *afe_data);
+/* feed path cost (ring copy, stats, feed, fetch) with its buffers in each memory class;
+ * prints one line per class and returns the fastest (placement_bench.cpp) */
+arena_class_t pipeline_placement_bench(esp_afe_sr_data_t *afe_data);
+/* sets task_flag and starts the actuation, Pi link, detect and feed tasks on afe_data; capture must already be running */
+void pipeline_start(esp_afe_sr_data_t *afe_data);
+
+/* per-stage capture -> TRIGGER_GPIO latency histograms (latency_trace.h) */
+void pipeline_print_latency(void);
+/* audio stats summary at the next chunk instead of the end of the window */
+void pipeline_request_stats(void);
+
+#if CONFIG_WAKE_GATE
+/* counters of the energy gate in front of afe->feed() (energy_gate.h) */
+void pipeline_gate_stats(energy_gate_stats_t *out);
+/* off: feed every chunk again; any task */
+void pipeline_gate_enable(bool on);
+bool pipeline_gate_enabled(void);
+#endif
@@ -0,0 +1,106 @@
+/* placement_bench.cpp - per-chunk cost of the feed path with its buffers in each memory class.
+ * Runs at boot with CONFIG_WAKE_PLACEMENT_BENCH and on the host via wake/host (placement_bench). */
+#include <stdio.h>
+#include <string.h>
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "arena.h"
+#include "signal_stats.h"
+#include "pipeline.h"
+
+#define BENCH_RING_CHUNKS 8 // same slack as the capture ring, so reads stream past the cache
+#define BENCH_WARM_CHUNKS 4
+#define BENCH_CHUNKS 64
+#define BENCH_MARGIN_PCT 5 // a later class must beat the best so far by this much; ties stay in internal RAM
+
+static const uint32_t bench_caps[ARENA_CLASSES] = {
+    MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT,
+    MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT,
+    MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT,
+};
+
+typedef struct
+{
+    uint64_t copy, stats, feed, fetch;
+    int chunks;
+} bench_cost_t;
+
+/* one class: ring and feed buffer both there, low-level noise so WakeNet stays quiet */
+static bool bench_class(esp_afe_sr_data_t *afe_data, arena_class_t cls, size_t samples, TickType_t wait, bench_cost_t *out)
+{
+    size_t bytes = samples * sizeof(int16_t);
+    int16_t *ring = (int16_t *)heap_caps_aligned_alloc(ARENA_ALIGN, bytes * BENCH_RING_CHUNKS, bench_caps[cls]);
+    int16_t *buf = (int16_t *)heap_caps_aligned_alloc(ARENA_ALIGN, bytes, bench_caps[cls]);
+    if (!ring || !buf)
+    {
+        heap_caps_free(ring);
+        heap_caps_free(buf);
+        return false;
+    }
+    uint32_t seed = 1;
+    for (size_t i = 0; i < samples * BENCH_RING_CHUNKS; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        ring[i] = (int16_t)((int32_t)(seed >> 16) % 64);
+    }
+
+    memset(out, 0, sizeof(*out));
+    for (int n = 0; n < BENCH_WARM_CHUNKS + BENCH_CHUNKS; ++n)
+    {
+        const int16_t *src = ring + (size_t)(n % BENCH_RING_CHUNKS) * samples;
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        memcpy(buf, src, bytes);
+        uint32_t t1 = esp_cpu_get_cycle_count();
+        signal_stats_t st;
+        signal_stats_compute(buf, samples, &st);
+        uint32_t t2 = esp_cpu_get_cycle_count();
+        afe_handle->feed(afe_data, buf);
+        uint32_t t3 = esp_cpu_get_cycle_count();
+        afe_fetch_result_t *res = afe_handle->fetch_with_delay(afe_data, wait);
+        uint32_t t4 = esp_cpu_get_cycle_count();
+        if (n < BENCH_WARM_CHUNKS || !res)
+            continue;
+        out->copy += t1 - t0;
+        out->stats += t2 - t1;
+        out->feed += t3 - t2;
+        out->fetch += t4 - t3;
+        out->chunks++;
+    }
+    heap_caps_free(ring);
+    heap_caps_free(buf);
+    return out->chunks > 0;
+}
+
+arena_class_t pipeline_placement_bench(esp_afe_sr_data_t *afe_data)
+{
+    size_t samples = (size_t)afe_handle->get_feed_chunksize(afe_data) * (size_t)afe_handle->get_feed_channel_num(afe_data);
+    TickType_t wait = pdMS_TO_TICKS(4 * 1000 * afe_handle->get_fetch_chunksize(afe_data) / SAMPLE_RATE) + 1;
+
+    arena_class_t best = ARENA_INTERNAL;
+    uint64_t best_total = UINT64_MAX / 100;
+    for (int c = 0; c < ARENA_CLASSES; ++c)
+    {
+        bench_cost_t cost;
+        if (!bench_class(afe_data, (arena_class_t)c, samples, wait, &cost))
+        {
+            printf("placement class=%s skipped (no memory or no AFE output)\n", arena_class_name((arena_class_t)c));
+            continue;
+        }
+        uint64_t total = (cost.copy + cost.stats + cost.feed + cost.fetch) / cost.chunks;
+        printf("placement class=%s chunks=%d copy=%u stats=%u feed=%u fetch=%u total=%u cycles_per_chunk\n",
+               arena_class_name((arena_class_t)c), cost.chunks, (unsigned)(cost.copy / cost.chunks),
+               (unsigned)(cost.stats / cost.chunks), (unsigned)(cost.feed / cost.chunks), (unsigned)(cost.fetch / cost.chunks),
+               (unsigned)total);
+        if (total * 100 < best_total * (100 - BENCH_MARGIN_PCT))
+        {
+            best_total = total;
+            best = (arena_class_t)c;
+        }
+    }
+    printf("placement winner=%s\n", arena_class_name(best));
+
+    // the bench audio must not linger in front of the first real chunk
+    afe_handle->reset_buffer(afe_data);
+    return best;
+}
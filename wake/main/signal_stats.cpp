@@ -0,0 +1,254 @@
+/* signal_stats.cpp - scalar, portable and ESP32-S3 PIE paths of the PCM statistics kernel */
+#include <math.h>
+#include <string.h>
+#include "esp_log.h"
+#include "signal_stats.h"
+
+#define TAG "WAKE_DBG"
+
+static signal_stats_fn_t active_fn = signal_stats_portable;
+static const char *active_name = "portable";
+
+static void stats_reset(signal_stats_t *out, size_t n)
+{
+    memset(out, 0, sizeof(*out));
+    out->samples = (uint32_t)n;
+}
+
+void signal_stats_scalar(const int16_t *buf, size_t n, signal_stats_t *out)
+{
+    stats_reset(out, n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        int64_t v = buf[i];
+        int32_t a = v < 0 ? (int32_t)-v : (int32_t)v;
+        out->sum_sq += (uint64_t)(v * v);
+        out->sum += v;
+        if (a > out->peak)
+            out->peak = a;
+        if (a >= SIGNAL_STATS_CLIP_LEVEL)
+            out->clipped++;
+    }
+}
+
+void signal_stats_portable(const int16_t *buf, size_t n, signal_stats_t *out)
+{
+    stats_reset(out, n);
+    int32_t hi = 0, lo = 0;
+    uint64_t sum_sq = 0;
+    int64_t sum = 0;
+    uint32_t clipped = 0;
+
+    // per block the 32-bit partials cannot overflow: 2 * 2^30 < 2^32, 4096 * 2^15 < 2^31
+    const size_t block = 4096;
+    for (size_t base = 0; base < n; base += block)
+    {
+        size_t end = base + block < n ? base + block : n;
+        int32_t bsum = 0;
+        for (size_t i = base; i + 1 < end; i += 2)
+        {
+            int32_t a = buf[i], b = buf[i + 1];
+            sum_sq += (uint32_t)(a * a) + (uint32_t)(b * b);
+            bsum += a + b;
+            hi = a > hi ? a : hi;
+            hi = b > hi ? b : hi;
+            lo = a < lo ? a : lo;
+            lo = b < lo ? b : lo;
+            clipped += (uint32_t)(a >= SIGNAL_STATS_CLIP_LEVEL || a <= -SIGNAL_STATS_CLIP_LEVEL) +
+                       (uint32_t)(b >= SIGNAL_STATS_CLIP_LEVEL || b <= -SIGNAL_STATS_CLIP_LEVEL);
+        }
+        if ((end - base) & 1)
+        {
+            int32_t a = buf[end - 1];
+            sum_sq += (uint32_t)(a * a);
+            bsum += a;
+            hi = a > hi ? a : hi;
+            lo = a < lo ? a : lo;
+            clipped += (uint32_t)(a >= SIGNAL_STATS_CLIP_LEVEL || a <= -SIGNAL_STATS_CLIP_LEVEL);
+        }
+        sum += bsum;
+    }
+
+    out->sum_sq = sum_sq;
+    out->sum = sum;
+    out->clipped = clipped;
+    out->peak = hi > -lo ? hi : -lo;
+}
+
+#if CONFIG_IDF_TARGET_ESP32S3
+
+/* 32 vectors of 8 lanes per block keeps ACCX (40-bit) clear of overflow:
+ * 256 * 2^30 = 2^38. QACC lanes only sum 32 values each. */
+#define PIE_BLOCK_SAMPLES 256
+
+static int64_t sext40(const uint8_t *p)
+{
+    uint64_t v = (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) |
+                 ((uint64_t)p[3] << 24) | ((uint64_t)p[4] << 32);
+    return (int64_t)(v << 24) >> 24;
+}
+
+/* One asm block per 16-byte aligned run of whole vectors:
+ *   ACCX      += sum(x * x)       (ee.vmulas.s16.accx, loads the next vector in the same op)
+ *   QACC lane += x * 1            (ee.vmulas.s16.qacc against a broadcast 1)
+ *   q2 / q3    = lane max / min   (ee.vmax.s16 / ee.vmin.s16)
+ * The last vector is handled after the loop so nothing past the buffer is read. */
+static void pie_block(const int16_t *p, int vecs, signal_stats_t *out, int32_t *hi, int32_t *lo)
+{
+    static const int16_t one = 1;
+    int16_t mm[16] __attribute__((aligned(16)));
+    uint8_t qacc[64] __attribute__((aligned(16)));
+    uint32_t acc_lo, acc_hi;
+    int16_t *mm_p = mm;
+    uint8_t *q_ll = qacc, *q_lh = qacc + 16, *q_hl = qacc + 32, *q_hh = qacc + 48;
+    int loops = vecs - 1;
+
+    asm volatile(
+        "ee.zero.accx\n"
+        "ee.zero.qacc\n"
+        "ee.vldbc.16 q7, %[one]\n"
+        "ee.vld.128.ip q0, %[p], 16\n"
+        "ee.orq q2, q0, q0\n"
+        "ee.orq q3, q0, q0\n"
+        "loopgtz %[loops], 1f\n"
+        "ee.vmulas.s16.qacc q0, q7\n"
+        "ee.vmax.s16 q2, q2, q0\n"
+        "ee.vmin.s16 q3, q3, q0\n"
+        "ee.vmulas.s16.accx.ld.ip q0, %[p], 16, q0, q0\n"
+        "1:\n"
+        "ee.vmulas.s16.qacc q0, q7\n"
+        "ee.vmax.s16 q2, q2, q0\n"
+        "ee.vmin.s16 q3, q3, q0\n"
+        "ee.vmulas.s16.accx q0, q0\n"
+        "ee.vst.128.ip q2, %[mm], 16\n"
+        "ee.vst.128.ip q3, %[mm], 16\n"
+        "ee.st.qacc_l.l.128.ip %[qll], 0\n"
+        "ee.st.qacc_l.h.32.ip %[qlh], 0\n"
+        "ee.st.qacc_h.l.128.ip %[qhl], 0\n"
+        "ee.st.qacc_h.h.32.ip %[qhh], 0\n"
+        "rur.accx_0 %[alo]\n"
+        "rur.accx_1 %[ahi]\n"
+        : [p] "+r"(p), [mm] "+r"(mm_p), [alo] "=r"(acc_lo), [ahi] "=r"(acc_hi),
+          [qll] "+r"(q_ll), [qlh] "+r"(q_lh), [qhl] "+r"(q_hl), [qhh] "+r"(q_hh)
+        : [loops] "r"(loops), [one] "r"(&one)
+        : "memory");
+
+    out->sum_sq += ((uint64_t)(acc_hi & 0xff) << 32) | acc_lo;
+    // QACC_L / QACC_H each hold four 40-bit lanes; lane order does not matter for a sum
+    for (int i = 0; i < 4; ++i)
+        out->sum += sext40(qacc + 5 * i) + sext40(qacc + 32 + 5 * i);
+
+    int32_t bhi = mm[0], blo = mm[8];
+    for (int i = 1; i < 8; ++i)
+    {
+        bhi = mm[i] > bhi ? mm[i] : bhi;
+        blo = mm[8 + i] < blo ? mm[8 + i] : blo;
+    }
+    *hi = bhi > *hi ? bhi : *hi;
+    *lo = blo < *lo ? blo : *lo;
+}
+
+void signal_stats_pie(const int16_t *buf, size_t n, signal_stats_t *out)
+{
+    stats_reset(out, n);
+    int32_t hi = 0, lo = 0;
+    signal_stats_t part;
+
+    // scalar head up to 16-byte alignment, PIE body, scalar tail
+    size_t head = ((16 - ((uintptr_t)buf & 15)) & 15) / sizeof(int16_t);
+    if (head > n || ((uintptr_t)buf & 1))
+        head = n;
+    if (head)
+    {
+        signal_stats_portable(buf, head, &part);
+        out->sum_sq += part.sum_sq;
+        out->sum += part.sum;
+        out->clipped += part.clipped;
+        hi = part.peak;
+        lo = -part.peak;
+    }
+
+    size_t i = head;
+    while (n - i >= 8)
+    {
+        size_t len = n - i < PIE_BLOCK_SAMPLES ? (n - i) & ~(size_t)7 : PIE_BLOCK_SAMPLES;
+        int32_t bhi = 0, blo = 0;
+        pie_block(buf + i, (int)(len / 8), out, &bhi, &blo);
+        // clipping is rare: only count it when the block actually reached full scale
+        if (bhi >= SIGNAL_STATS_CLIP_LEVEL || blo <= -SIGNAL_STATS_CLIP_LEVEL)
+        {
+            for (size_t k = i; k < i + len; ++k)
+                out->clipped += (buf[k] >= SIGNAL_STATS_CLIP_LEVEL || buf[k] <= -SIGNAL_STATS_CLIP_LEVEL);
+        }
+        hi = bhi > hi ? bhi : hi;
+        lo = blo < lo ? blo : lo;
+        i += len;
+    }
+
+    if (i < n)
+    {
+        signal_stats_portable(buf + i, n - i, &part);
+        out->sum_sq += part.sum_sq;
+        out->sum += part.sum;
+        out->clipped += part.clipped;
+        hi = part.peak > hi ? part.peak : hi;
+        lo = -part.peak < lo ? -part.peak : lo;
+    }
+    out->peak = hi > -lo ? hi : -lo;
+}
+
+#endif
+
+void signal_stats_init(void)
+{
+#if CONFIG_IDF_TARGET_ESP32S3
+    // odd length and offset, full-scale values and noise: exercises head, body, tail and the clip path
+    static int16_t probe[1031] __attribute__((aligned(16)));
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < sizeof(probe) / sizeof(probe[0]); ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        probe[i] = (int16_t)(seed >> 16);
+    }
+    probe[100] = 32767;
+    probe[517] = -32768;
+
+    signal_stats_t ref, got;
+    signal_stats_scalar(probe + 3, 1021, &ref);
+    signal_stats_pie(probe + 3, 1021, &got);
+    if (signal_stats_equal(&ref, &got))
+    {
+        active_fn = signal_stats_pie;
+        active_name = "pie";
+    }
+    else
+    {
+        ESP_LOGE(TAG, "PIE signal stats mismatch, using portable path");
+    }
+#endif
+    ESP_LOGI(TAG, "Signal stats path: %s", active_name);
+}
+
+void signal_stats_compute(const int16_t *buf, size_t n, signal_stats_t *out)
+{
+    active_fn(buf, n, out);
+}
+
+const char *signal_stats_path(void)
+{
+    return active_name;
+}
+
+float signal_stats_rms(const signal_stats_t *s)
+{
+    if (s->samples == 0)
+        return 0.0f;
+    return sqrtf((float)s->sum_sq / (float)s->samples);
+}
+
+float signal_stats_dc(const signal_stats_t *s)
+{
+    if (s->samples == 0)
+        return 0.0f;
+    return (float)s->sum / (float)s->samples;
+}
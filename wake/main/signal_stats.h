@@ -0,0 +1,54 @@
+/* signal_stats.h - one-pass fixed-point PCM statistics (energy, peak, clipping, DC) */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+#define SIGNAL_STATS_CLIP_LEVEL 32767 // |x| at or above this counts as clipped
+
+typedef struct
+{
+    uint64_t sum_sq;  // sum of x^2
+    int64_t sum;      // sum of x, for DC offset
+    uint32_t samples;
+    uint32_t clipped; // samples at full scale
+    int32_t peak;     // max |x| (32768 for INT16_MIN)
+} signal_stats_t;
+
+typedef void (*signal_stats_fn_t)(const int16_t *buf, size_t n, signal_stats_t *out);
+
+/* reference: straightforward scalar loop, the behaviour of the old compute_rms */
+void signal_stats_scalar(const int16_t *buf, size_t n, signal_stats_t *out);
+/* portable fallback: 16x16->32 multiplies, no 64-bit multiply, no branches */
+void signal_stats_portable(const int16_t *buf, size_t n, signal_stats_t *out);
+#if CONFIG_IDF_TARGET_ESP32S3
+/* ESP32-S3 PIE: 8 lanes per instruction for energy, DC and peak */
+void signal_stats_pie(const int16_t *buf, size_t n, signal_stats_t *out);
+#endif
+
+/* Self-checks the SIMD path against the scalar one and picks the fastest
+ * correct implementation for signal_stats_compute(). Call once at boot. */
+void signal_stats_init(void);
+void signal_stats_compute(const int16_t *buf, size_t n, signal_stats_t *out);
+const char *signal_stats_path(void);
+
+/* derived values; only these touch floating point */
+float signal_stats_rms(const signal_stats_t *s);
+float signal_stats_dc(const signal_stats_t *s);
+
+/* true when mean square is below level^2, without a sqrt */
+static inline bool signal_stats_below_rms(const signal_stats_t *s, uint32_t level)
+{
+    return s->sum_sq < (uint64_t)level * level * s->samples;
+}
+
+/* field by field: the struct has tail padding, so memcmp() can differ on equal stats */
+static inline bool signal_stats_equal(const signal_stats_t *a, const signal_stats_t *b)
+{
+    return a->sum_sq == b->sum_sq && a->sum == b->sum && a->samples == b->samples &&
+           a->clipped == b->clipped && a->peak == b->peak;
+}
+
+/* cycles-per-sample microbenchmark of every path over the hilexin clip (signal_stats_bench.cpp) */
+void signal_stats_bench(void);
@@ -0,0 +1,60 @@
+/* signal_stats_bench.cpp - verifies every signal stats path against the scalar one on the hilexin
+ * clip and reports cycles per sample. Runs at boot with CONFIG_WAKE_SIGNAL_STATS_BENCH and on the
+ * host via wake/host (signal_stats_bench). */
+#include <stdio.h>
+#include <string.h>
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "signal_stats.h"
+#include "hilexin.h"
+
+#define BENCH_REPEATS 20
+#define BENCH_CHUNK 512 // AFE feed chunk, the size the feed task actually calls with
+
+static bool bench_path(const char *name, signal_stats_fn_t fn, const int16_t *pcm, size_t n)
+{
+    // whole clip and feed-sized chunks (with an odd offset to hit unaligned heads)
+    signal_stats_t ref, got;
+    signal_stats_scalar(pcm, n, &ref);
+    fn(pcm, n, &got);
+    bool ok = signal_stats_equal(&ref, &got);
+    for (size_t off = 1; off + BENCH_CHUNK <= n && ok; off += BENCH_CHUNK)
+    {
+        signal_stats_scalar(pcm + off, BENCH_CHUNK, &ref);
+        fn(pcm + off, BENCH_CHUNK, &got);
+        ok = signal_stats_equal(&ref, &got);
+    }
+
+    uint32_t best = UINT32_MAX;
+    for (int r = 0; r < BENCH_REPEATS; ++r)
+    {
+        uint32_t t0 = esp_cpu_get_cycle_count();
+        for (size_t off = 0; off + BENCH_CHUNK <= n; off += BENCH_CHUNK)
+            fn(pcm + off, BENCH_CHUNK, &got);
+        uint32_t dt = esp_cpu_get_cycle_count() - t0;
+        best = dt < best ? dt : best;
+    }
+    size_t timed = n / BENCH_CHUNK * BENCH_CHUNK;
+    printf("signal_stats path=%s samples=%u %s cycles_per_sample=%.3f\n",
+           name, (unsigned)timed, ok ? "match" : "MISMATCH", (double)best / (double)timed);
+    return ok;
+}
+
+void signal_stats_bench(void)
+{
+    size_t n = sizeof(hilexin) / sizeof(int16_t);
+    int16_t *pcm = (int16_t *)heap_caps_aligned_alloc(16, n * sizeof(int16_t), MALLOC_CAP_DEFAULT);
+    if (!pcm)
+    {
+        printf("signal_stats bench: no memory for %u samples\n", (unsigned)n);
+        return;
+    }
+    memcpy(pcm, hilexin, n * sizeof(int16_t)); // clip is little-endian 16-bit PCM
+
+    bench_path("scalar", signal_stats_scalar, pcm, n);
+    bench_path("portable", signal_stats_portable, pcm, n);
+#if CONFIG_IDF_TARGET_ESP32S3
+    bench_path("pie", signal_stats_pie, pcm, n);
+#endif
+    heap_caps_free(pcm);
+}
@@ -0,0 +1,139 @@
+/* silence.cpp - median-calibrated silence tracker on chunk energies, no floating point per chunk */
+#include <math.h>
+#include <algorithm>
+#include "silence.h"
+
+#define FULL_SCALE_MS (32768.0 * 32768.0)
+#define FLOOR_DB_MIN (-90.0)
+#define FLOOR_DB_MAX (-10.0)
+
+void silence_init(silence_t *t, const silence_config_t *cfg)
+{
+    t->cfg = *cfg;
+    t->state = SILENCE_IDLE;
+    t->n_calib = 0;
+    t->state_chunks = 0;
+    t->threshold_ms = 0;
+    t->silent_ms = 0;
+    t->reported_s = 0;
+    t->floor_dbfs_x10 = 0;
+    t->threshold_dbfs_x10 = 0;
+    if (t->cfg.chunk_ms == 0)
+        t->cfg.chunk_ms = 1;
+    uint32_t calib_chunks = (t->cfg.calib_ms + t->cfg.chunk_ms - 1) / t->cfg.chunk_ms;
+    t->calib_stride = (calib_chunks + SILENCE_CALIB_SLOTS - 1) / SILENCE_CALIB_SLOTS;
+    if (t->calib_stride == 0)
+        t->calib_stride = 1;
+    t->arm_requested.store(false, std::memory_order_relaxed);
+}
+
+void silence_arm(silence_t *t)
+{
+    t->arm_requested.store(true, std::memory_order_relaxed);
+}
+
+bool silence_armed(const silence_t *t)
+{
+    return t->state != SILENCE_IDLE || t->arm_requested.load(std::memory_order_relaxed);
+}
+
+static int16_t db_x10(double db)
+{
+    return (int16_t)lrint(db * 10.0);
+}
+
+/* median of the calibration window -> threshold; the only floating point in the tracker */
+static void calibrate(silence_t *t)
+{
+    uint32_t median = 0;
+    if (t->n_calib)
+    {
+        std::nth_element(t->calib, t->calib + t->n_calib / 2, t->calib + t->n_calib);
+        median = t->calib[t->n_calib / 2];
+    }
+    double floor_db = median ? 10.0 * log10(median / FULL_SCALE_MS) : -120.0;
+    double thr_db = floor_db - t->cfg.margin_db_x10 / 10.0;
+    thr_db = std::max(FLOOR_DB_MIN, std::min(FLOOR_DB_MAX, thr_db));
+    t->threshold_ms = (uint64_t)(FULL_SCALE_MS * pow(10.0, thr_db / 10.0));
+    t->floor_dbfs_x10 = db_x10(floor_db);
+    t->threshold_dbfs_x10 = db_x10(thr_db);
+}
+
+static void enter(silence_t *t, silence_state_t state)
+{
+    t->state = state;
+    t->state_chunks = 0;
+}
+
+static void report(const silence_t *t, silence_report_t *out)
+{
+    out->state = t->state;
+    out->silent_s = t->reported_s;
+    out->floor_dbfs_x10 = t->floor_dbfs_x10;
+    out->threshold_dbfs_x10 = t->threshold_dbfs_x10;
+    out->calibrated = false;
+}
+
+bool silence_add(silence_t *t, const signal_stats_t *chunk, silence_report_t *out)
+{
+    if (t->arm_requested.exchange(false, std::memory_order_relaxed))
+    {
+        t->n_calib = 0;
+        t->silent_ms = 0;
+        t->reported_s = 0;
+        enter(t, SILENCE_CALIBRATING);
+        report(t, out);
+        return true;
+    }
+    if (t->state == SILENCE_IDLE || !chunk->samples)
+        return false;
+
+    t->state_chunks++;
+    uint32_t elapsed_ms = t->state_chunks * t->cfg.chunk_ms;
+    // silent at or below the threshold, like the Python monitor's `level > threshold` for sound
+    bool silent = chunk->sum_sq <= t->threshold_ms * chunk->samples;
+
+    switch (t->state)
+    {
+    case SILENCE_CALIBRATING:
+        if (t->state_chunks % t->calib_stride == 0 && t->n_calib < SILENCE_CALIB_SLOTS)
+            t->calib[t->n_calib++] = (uint32_t)(chunk->sum_sq / chunk->samples);
+        if (elapsed_ms < t->cfg.calib_ms)
+            return false;
+        calibrate(t);
+        enter(t, t->cfg.grace_ms ? SILENCE_GRACE : SILENCE_TRACKING);
+        report(t, out);
+        out->calibrated = true;
+        return true;
+
+    case SILENCE_GRACE:
+        // silence during grace still counts towards the total, it just is not reported yet
+        t->silent_ms = silent ? t->silent_ms + t->cfg.chunk_ms : 0;
+        if (elapsed_ms < t->cfg.grace_ms)
+            return false;
+        enter(t, SILENCE_TRACKING);
+        t->reported_s = t->silent_ms / 1000;
+        report(t, out);
+        return true;
+
+    case SILENCE_TRACKING:
+        if (!silent)
+        {
+            t->silent_ms = 0;
+            if (t->reported_s == 0)
+                return false;
+            t->reported_s = 0;
+            report(t, out);
+            return true;
+        }
+        t->silent_ms += t->cfg.chunk_ms;
+        if (t->silent_ms / 1000 == t->reported_s)
+            return false;
+        t->reported_s = t->silent_ms / 1000;
+        report(t, out);
+        return true;
+
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,66 @@
+/* silence.h - fixed-point noise-floor calibration and silence tracking for the feed task
+ *
+ * Mirrors the Pi's old shutdown.py monitor on the ESP32's own chunks. Arming
+ * starts a calibration window, and the ambient level is the median chunk
+ * energy over that window. The threshold sits margin dB below it. Grace time
+ * passes, then the tracker counts continuous silence. Per chunk it is
+ * integer compares only; the one log10/pow runs when calibration ends.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "signal_stats.h"
+
+#define SILENCE_CALIB_SLOTS 256 // calibration chunks kept for the median; longer windows are subsampled
+
+typedef struct
+{
+    uint32_t chunk_ms;
+    uint32_t calib_ms;    // calibration window after arming
+    uint32_t grace_ms;    // no silence reported until this long after calibration
+    int32_t margin_db_x10; // threshold below the ambient median, in 0.1 dB
+} silence_config_t;
+
+typedef enum
+{
+    SILENCE_IDLE,
+    SILENCE_CALIBRATING,
+    SILENCE_GRACE,
+    SILENCE_TRACKING,
+} silence_state_t;
+
+typedef struct
+{
+    silence_state_t state;
+    uint32_t silent_s;          // whole seconds of continuous silence (SILENCE_TRACKING)
+    int16_t floor_dbfs_x10;     // calibrated ambient median
+    int16_t threshold_dbfs_x10; // chunks at or below this are silent
+    bool calibrated;            // this report ends calibration
+} silence_report_t;
+
+typedef struct
+{
+    silence_config_t cfg;
+    silence_state_t state;
+    uint32_t calib[SILENCE_CALIB_SLOTS]; // mean square per kept calibration chunk
+    uint32_t n_calib;
+    uint32_t calib_stride; // keep every calib_stride-th chunk
+    uint32_t state_chunks; // chunks since the state was entered
+    uint64_t threshold_ms; // mean-square threshold
+    uint32_t silent_ms;
+    uint32_t reported_s;
+    int16_t floor_dbfs_x10;
+    int16_t threshold_dbfs_x10;
+    std::atomic<bool> arm_requested;
+} silence_t;
+
+void silence_init(silence_t *t, const silence_config_t *cfg);
+
+/* Any task: (re)start calibration at the owner's next chunk. */
+void silence_arm(silence_t *t);
+bool silence_armed(const silence_t *t);
+
+/* Owner task, once per chunk. Returns true when *out should be published:
+ * a state change, another whole second of silence, or silence broken. */
+bool silence_add(silence_t *t, const signal_stats_t *chunk, silence_report_t *out);
@@ -0,0 +1,241 @@
+/* wake_console.cpp - esp_console REPL with the pipeline's diagnostic commands */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "arena.h"
+#include "cmd_table.h"
+#include "phrase_table.h"
+#include "event_log.h"
+#include "latency_trace.h"
+#include "model_registry.h"
+#include "pi_link.h"
+#include "pipeline.h"
+#include "wake_log.h"
+#include "wake_console.h"
+
+#define TAG "WAKE_DBG"
+
+static int cmd_lat(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "reset") == 0)
+    {
+        latency_trace_reset();
+        printf("latency histograms cleared\n");
+        return 0;
+    }
+    latency_trace_print();
+    return 0;
+}
+
+static int cmd_stats(int argc, char **argv)
+{
+    pipeline_request_stats();
+    return 0;
+}
+
+static int cmd_models(int argc, char **argv)
+{
+    model_registry_report();
+    return 0;
+}
+
+static int cmd_mem(int argc, char **argv)
+{
+    arena_report();
+    return 0;
+}
+
+static int cmd_evlog(int argc, char **argv)
+{
+    event_log_stats_t s;
+    event_log_get_stats(&s);
+    printf("evlog: written=%u dropped=%u high_water=%u/%u\n", (unsigned)s.written, (unsigned)s.dropped,
+           (unsigned)s.high_water, (unsigned)s.capacity);
+    return 0;
+}
+
+static int cmd_link(int argc, char **argv)
+{
+    pi_link_stats_t s;
+    pi_link_get_stats(&s);
+    printf("link: frames=%u dropped=%u\n", (unsigned)s.frames, (unsigned)s.dropped);
+    return 0;
+}
+
+#if CONFIG_WAKE_GATE
+static int cmd_gate(int argc, char **argv)
+{
+    if (argc > 1)
+        pipeline_gate_enable(strcmp(argv[1], "off") != 0);
+    energy_gate_stats_t s;
+    pipeline_gate_stats(&s);
+    printf("gate: %s %s chunks=%u fed=%u replayed=%u dropped=%u opens=%u floor=%.1f dBFS\n",
+           pipeline_gate_enabled() ? "on" : "off", s.open ? "open" : "closed", (unsigned)s.chunks, (unsigned)s.fed,
+           (unsigned)s.replayed, (unsigned)s.dropped, (unsigned)s.opens, s.floor_dbfs_x10 / 10.0);
+    return 0;
+}
+#endif
+
+#if CONFIG_WAKE_CMD_TABLE
+static const char *const cmd_sources[] = {"not loaded", "Kconfig", "partition"};
+
+static int cmd_cmd(int argc, char **argv)
+{
+    bool add = argc > 3 && strcmp(argv[1], "add") == 0;
+    bool rm = argc > 2 && strcmp(argv[1], "rm") == 0;
+    if (add || rm)
+    {
+        // the phrase is the rest of the line
+        char phrase[CMD_TABLE_PHRASE_MAX + 2] = "";
+        for (int i = add ? 3 : 2; i < argc; ++i)
+        {
+            size_t n = strlen(phrase);
+            snprintf(phrase + n, sizeof(phrase) - n, "%s%s", n ? " " : "", argv[i]);
+        }
+        esp_err_t err = add ? cmd_table_add(atoi(argv[2]), phrase) : cmd_table_remove(phrase);
+        if (err != ESP_OK)
+        {
+            printf("cmd: %s\n", esp_err_to_name(err));
+            return 1;
+        }
+        model_registry_multinet_rebuild(); // recognition switches over once the new instance is loaded
+    }
+    else if (argc > 1 && strcmp(argv[1], "list") != 0)
+    {
+        printf("usage: cmd [list | add <id> <phrase> | rm <phrase>]\n");
+        return 1;
+    }
+
+    cmd_table_info_t info;
+    cmd_table_get_info(&info);
+    printf("commands: v%u from %s, %u commands, %u/%u bytes in %u segments, %u rewrites\n", (unsigned)info.version,
+           cmd_sources[info.source], (unsigned)info.count, (unsigned)info.used, (unsigned)info.size,
+           (unsigned)info.segments, (unsigned)info.compactions);
+    cmd_entry_t e;
+    for (int i = 0; argc > 1 && strcmp(argv[1], "list") == 0 && cmd_table_get(i, &e); ++i)
+    {
+        uint16_t a = phrase_entry(e.command_id);
+        printf("%5d  %-12s %-7s leds 0x%x  %s\n", e.command_id, phrase_category_names[phrase_category(a)],
+               phrase_severity_names[phrase_severity(a)], phrase_leds(a), e.phrase);
+    }
+    return 0;
+}
+#endif
+
+static int cmd_log(int argc, char **argv)
+{
+    static const char *const names[] = {"none", "error", "warn", "info", "debug", "verbose"};
+    if (argc != 3)
+    {
+        printf("usage: log <tag> <none|error|warn|info|debug|verbose>\n");
+        return 1;
+    }
+    for (int l = ESP_LOG_NONE; l <= ESP_LOG_VERBOSE; ++l)
+    {
+        if (strcmp(argv[2], names[l]) != 0)
+            continue;
+        esp_log_level_t set = wake_log_set(argv[1], (esp_log_level_t)l);
+        printf("%s: %s%s\n", argv[1], names[set], set != l ? " (highest compiled in)" : "");
+        return 0;
+    }
+    printf("unknown level '%s'\n", argv[2]);
+    return 1;
+}
+
+esp_err_t wake_console_start(void)
+{
+    esp_console_repl_t *repl = NULL;
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_config.prompt = "wake>";
+    repl_config.task_priority = 1;
+
+#if CONFIG_ESP_CONSOLE_UART_DEFAULT || CONFIG_ESP_CONSOLE_UART_CUSTOM
+    esp_console_dev_uart_config_t hw_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    esp_err_t err = esp_console_new_repl_uart(&hw_config, &repl_config, &repl);
+#elif CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    esp_console_dev_usb_serial_jtag_config_t hw_config = ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+    esp_err_t err = esp_console_new_repl_usb_serial_jtag(&hw_config, &repl_config, &repl);
+#elif CONFIG_ESP_CONSOLE_USB_CDC
+    esp_console_dev_usb_cdc_config_t hw_config = ESP_CONSOLE_DEV_CDC_CONFIG_DEFAULT();
+    esp_err_t err = esp_console_new_repl_usb_cdc(&hw_config, &repl_config, &repl);
+#else
+    esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+#endif
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Console not started: %d", err);
+        return err;
+    }
+
+    const esp_console_cmd_t lat = {
+        .command = "lat",
+        .help = "Print capture->GPIO latency histograms per stage; 'lat reset' clears them",
+        .hint = "[reset]",
+        .func = cmd_lat,
+    };
+    const esp_console_cmd_t stats = {
+        .command = "stats",
+        .help = "Publish the audio stats summary now",
+        .hint = NULL,
+        .func = cmd_stats,
+    };
+    const esp_console_cmd_t models = {
+        .command = "models",
+        .help = "Load time and heap footprint of each loaded model",
+        .hint = NULL,
+        .func = cmd_models,
+    };
+    const esp_console_cmd_t mem = {
+        .command = "mem",
+        .help = "Pipeline arena use per memory class and hot-path heap allocations",
+        .hint = NULL,
+        .func = cmd_mem,
+    };
+    const esp_console_cmd_t evlog = {
+        .command = "evlog",
+        .help = "Event log records written, dropped and the ring's high-water mark",
+        .hint = NULL,
+        .func = cmd_evlog,
+    };
+    const esp_console_cmd_t link = {
+        .command = "link",
+        .help = "Frames sent to the Pi over the event link and messages dropped",
+        .hint = NULL,
+        .func = cmd_link,
+    };
+    const esp_console_cmd_t log = {
+        .command = "log",
+        .help = "Set a tag's log level, capped at what the log profile compiled in",
+        .hint = "<tag> <level>",
+        .func = cmd_log,
+    };
+#if CONFIG_WAKE_GATE
+    const esp_console_cmd_t gate = {
+        .command = "gate",
+        .help = "Energy gate state and counters; 'gate off' feeds every chunk to the AFE again",
+        .hint = "[on|off]",
+        .func = cmd_gate,
+    };
+    esp_console_cmd_register(&gate);
+#endif
+#if CONFIG_WAKE_CMD_TABLE
+    const esp_console_cmd_t cmd = {
+        .command = "cmd",
+        .help = "MultiNet command table; add/rm persist to the commands partition and reload MultiNet in the background",
+        .hint = "[list | add <id> <phrase> | rm <phrase>]",
+        .func = cmd_cmd,
+    };
+    esp_console_cmd_register(&cmd);
+#endif
+    esp_console_cmd_register(&lat);
+    esp_console_cmd_register(&stats);
+    esp_console_cmd_register(&models);
+    esp_console_cmd_register(&mem);
+    esp_console_cmd_register(&evlog);
+    esp_console_cmd_register(&link);
+    esp_console_cmd_register(&log);
+    return esp_console_start_repl(repl);
+}
@@ -0,0 +1,8 @@
+/* wake_console.h - esp_console REPL with the pipeline's diagnostic commands */
+#pragma once
+
+#include "esp_err.h"
+
+/* Starts the REPL on the configured console (UART or USB) and registers
+ * `lat [reset]`, `stats`, `models`, `mem`, `evlog`, `link` and `log <tag> <level>`. Runs in its own low-priority task. */
+esp_err_t wake_console_start(void);
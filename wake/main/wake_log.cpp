@@ -0,0 +1,43 @@
+/* wake_log.cpp - per-tag runtime log levels clamped to the build's log profile */
+#include <string.h>
+#include "wake_log.h"
+
+typedef struct
+{
+    const char *tag;
+    esp_log_level_t level; // set by wake_log_init()
+    esp_log_level_t max;
+} wake_log_tag_t;
+
+static const wake_log_tag_t profile_tags[] = {
+    {"WAKE_DBG", WAKE_LOG_LEVEL, (esp_log_level_t)LOG_LOCAL_LEVEL},
+    {"AFE", WAKE_LOG_SR_MAX, WAKE_LOG_SR_MAX},
+    {"WAKENET", WAKE_LOG_SR_MAX, WAKE_LOG_SR_MAX},
+    {"WAKENET_DETECT", WAKE_LOG_SR_MAX, WAKE_LOG_SR_MAX},
+};
+
+void wake_log_init(void)
+{
+    esp_log_level_set("*", ESP_LOG_WARN);
+    for (const wake_log_tag_t &t : profile_tags)
+        wake_log_set(t.tag, t.level);
+}
+
+esp_log_level_t wake_log_ceiling(const char *tag)
+{
+    for (const wake_log_tag_t &t : profile_tags)
+    {
+        if (strcmp(t.tag, tag) == 0)
+            return t.max;
+    }
+    return ESP_LOG_VERBOSE;
+}
+
+esp_log_level_t wake_log_set(const char *tag, esp_log_level_t level)
+{
+    esp_log_level_t max = wake_log_ceiling(tag);
+    if (level > max)
+        level = max;
+    esp_log_level_set(tag, level);
+    return level;
+}
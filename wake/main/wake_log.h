@@ -0,0 +1,31 @@
+/* wake_log.h - build-time log profile: compile-time level ceiling per tag, runtime levels inside it */
+#pragma once
+
+#include "sdkconfig.h"
+#include "esp_log.h"
+
+/* WAKE_DBG is this component's only tag. main/CMakeLists.txt compiles the
+ * component with LOG_LOCAL_LEVEL from the profile, so ESP_LOGx sites above it
+ * and EVENT_LOG() calls for their events are not in the image at all.
+ * AFE, WAKENET and WAKENET_DETECT log from the prebuilt esp-sr libraries and
+ * cannot be recompiled; for them the profile fixes the runtime ceiling. */
+#if CONFIG_WAKE_LOG_PROFILE_PRODUCTION
+#define WAKE_LOG_LEVEL ESP_LOG_WARN
+#define WAKE_LOG_SR_MAX ESP_LOG_WARN
+#elif CONFIG_WAKE_LOG_PROFILE_TRACE
+#define WAKE_LOG_LEVEL ESP_LOG_DEBUG
+#define WAKE_LOG_SR_MAX ESP_LOG_DEBUG
+#else
+#define WAKE_LOG_LEVEL ESP_LOG_INFO
+#define WAKE_LOG_SR_MAX ESP_LOG_INFO
+#endif
+
+/* "*" to WARN and each profile tag to its profile level */
+void wake_log_init(void);
+
+/* Highest level `tag` can log at; levels above it were compiled out (or are
+ * capped by the profile). Tags outside the profile: ESP_LOG_VERBOSE. */
+esp_log_level_t wake_log_ceiling(const char *tag);
+
+/* esp_log_level_set() clamped to wake_log_ceiling(); returns the level set */
+esp_log_level_t wake_log_set(const char *tag, esp_log_level_t level);